@@ -3,21 +3,25 @@
 // phenomena streams (rise/transit/set, seasons, apsides). Time is UTC.
 //
 //   astro info
-//   astro time    2026-07-11T17:24
+//   astro time    2026-07-11T17:24 [--eop finals2000A.daily] [--tdb de440.tdb]
 //   astro constant AU EMRAT GMS
-//   astro state   mars 2026-07-11 [--center ssb|sun|earth]
+//   astro state   mars 2026-07-11 [--center ssb|sun|earth] [--acceleration]
 //   astro place   jupiter 2026-07-11 [--observer 47.6,-122.3,10] [--coord ...]
-//   astro sky     2026-07-11 [--observer ...]
+//   astro sky     2026-07-11 [--observer ...] [--eop ...]
 //   astro rise    sun  2026-07-11 --observer 47.6,-122.3,10 [--horizon ...] [-n]
 //   astro seasons 2026-07-11 [-n N] [--back]
 //   astro apsides earth 2026-07-11 [--center sun|earth] [-n N] [--back]
+//   astro subset  out.eph 2020-01-01 2030-01-01 [--bodies sun,earth,moon]
+//   astro compress out.astroz
 
 #include <argparse/argparse.hpp>
 #include <algorithm>
 #include <cctype>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <ctime>
+#include <filesystem>
 #include <iostream>
 #include <optional>
 #include <ranges>
@@ -25,6 +29,7 @@
 #include <utility>
 #include <vector>
 
+#include "astro/earth_orientation.hpp"
 #include "astro/ephemeris.hpp"
 #include "astro/phenomena.hpp"
 #include "astro/reductions.hpp"
@@ -45,9 +50,20 @@ std::string ephem_path(const argparse::ArgumentParser& p) {
   return "data/JPLEPH";
 }
 
+// The ephemeris path, or several joined with ':' (e.g. DE441's two parts)
+// to open them as one. With --tdb CACHE, TDB - TT comes from a table
+// integrated from the ephemeris and kept at CACHE (TdbSource::ephemeris).
 std::optional<Ephemeris> open_ephem(const argparse::ArgumentParser& p) {
   const std::string path = ephem_path(p);
-  auto e = Ephemeris::open(path);
+  std::vector<std::filesystem::path> paths;
+  for (auto part : std::views::split(path, ':'))
+    paths.emplace_back(std::string(part.begin(), part.end()));
+  OpenOptions options;
+  if (auto cache = p.get<std::string>("--tdb"); !cache.empty()) {
+    options.tdb = TdbSource::ephemeris;
+    options.tdb_cache = cache;
+  }
+  auto e = Ephemeris::open(paths, options);
   if (!e) {
     std::fprintf(stderr, "error: cannot open ephemeris '%s': %s\n"
                          "(use --ephemeris PATH, set LIBASTRO_EPHEMERIS, or run "
@@ -58,22 +74,41 @@ std::optional<Ephemeris> open_ephem(const argparse::ArgumentParser& p) {
   return std::move(*e);
 }
 
-// UTC "YYYY-MM-DD[ T]HH:MM[:SS]", or the literal "now" (current system time in
-// UTC) -> time scales (with a fixed observer 0 UT1-UTC).
-std::optional<TimeScaleSet> parse_utc(const std::string& s) {
+// IERS Earth orientation from --eop (else $LIBASTRO_EOP), with leap seconds
+// from --leap-seconds if given. Neither: an empty table (UT1 - UTC = 0, no
+// polar motion, the built-in leap seconds).
+std::optional<EarthOrientationTable> open_eop(const argparse::ArgumentParser& p) {
+  std::string path = p.get<std::string>("--eop");
+  if (path.empty())
+    if (const char* env = std::getenv("LIBASTRO_EOP")) path = env;
+  if (path.empty()) return EarthOrientationTable{};
+  auto e = EarthOrientationTable::load(path, p.get<std::string>("--leap-seconds"));
+  if (!e) {
+    std::fprintf(stderr, "error: cannot load Earth orientation '%s': %s\n",
+                 path.c_str(), std::string(to_string(e.error())).c_str());
+    return std::nullopt;
+  }
+  return std::move(*e);
+}
+
+// UTC ISO 8601 "YYYY-MM-DD[Thh:mm[:ss[.fff]]][Z]" (or ' ' for 'T'), or the
+// literal "now" (current system time in UTC) -> time scales (UT1-UTC from
+// `eop`, else 0).
+std::optional<TimeScaleSet> parse_utc(
+    const std::string& s, const EarthOrientationTable& eop = {}) {
   if (lower(s) == "now") {
     const std::time_t t = std::time(nullptr);
     std::tm g{};
     gmtime_r(&t, &g);  // system time -> broken-down UTC
     return utc_time_scales(g.tm_year + 1900, g.tm_mon + 1, g.tm_mday,
-                           g.tm_hour + g.tm_min / 60.0 + g.tm_sec / 3600.0);
+                           g.tm_hour + g.tm_min / 60.0 + g.tm_sec / 3600.0, eop);
   }
-  int y = 0, mo = 0, d = 0, h = 0, mi = 0;
-  double se = 0.0;
-  const int n = std::sscanf(s.c_str(), "%d-%d-%d%*[ T]%d:%d:%lf", &y, &mo, &d,
-                            &h, &mi, &se);
-  if (n < 3) return std::nullopt;
-  return utc_time_scales(y, mo, d, h + mi / 60.0 + se / 3600.0);
+  UtcTimestamp t;
+  const char* end = s.data() + s.size();
+  if (const auto r = parse_utc_timestamp(s.data(), end, t);
+      r.ec != std::errc{} || r.ptr != end)
+    return std::nullopt;
+  return utc_time_scales(julian_date(t).value(), eop);
 }
 
 std::optional<Point> parse_body(const std::string& name) {
@@ -128,17 +163,16 @@ Horizon parse_horizon(const std::string& s) {
   return Horizon::star;
 }
 
-// TT Julian date -> a printable UTC calendar string (approximate: ignores
-// UT1-UTC, good to < 1 s).
-std::string tt_to_utc(double tt_jd) {
-  const double leap = tai_minus_utc(tt_jd);
-  const auto c = calendar_date(tt_jd - (leap + 32.184) / 86400.0);
-  const int hh = static_cast<int>(c.hour);
-  const int mm = static_cast<int>((c.hour - hh) * 60.0);
-  const int ss = static_cast<int>(((c.hour - hh) * 60.0 - mm) * 60.0 + 0.5);
-  char buf[40];
-  std::snprintf(buf, sizeof buf, "%04d-%02d-%02d %02d:%02d:%02d UTC", c.year,
-                c.month, c.day, hh, mm, ss);
+// TT -> ISO 8601 UTC to the second, into `buf` (approximate: TAI-UTC is
+// taken at the TT date and UT1-UTC ignored, good to < 1 s). A stream reuses
+// one buffer, so an event costs no allocation.
+using UtcText = char[kUtcTimestampMaxChars + 1];
+const char* tt_to_utc(TtInstant tt, UtcText& buf) {
+  const double leap = tai_minus_utc(tt.jd.value());
+  const JulianDate utc{tt.jd.whole, tt.jd.frac - (leap + 32.184) / 86400.0};
+  const auto r = format_utc_timestamp(buf, buf + kUtcTimestampMaxChars,
+                                      utc_timestamp(utc));
+  *r.ptr = '\0';
   return buf;
 }
 
@@ -152,21 +186,36 @@ int run_info(const argparse::ArgumentParser& a) {
   std::printf("  DE number   : %d\n", h.denum);
   std::printf("  JD span     : %.1f .. %.1f\n", h.jd_begin, h.jd_end);
   std::printf("  days/record : %.0f\n", h.days_per_record);
-  std::printf("  records     : %zu\n", h.record_count);
+  std::printf("  records     : %zu%s\n", h.record_count,
+              h.compressed ? " (compressed)" : "");
   std::printf("  constants   : %d\n", h.n_constants);
   std::printf("  AU (km)     : %.6f\n", h.au_km);
   std::printf("  Earth/Moon  : %.9f\n", h.earth_moon_ratio);
+  if (const auto segs = eph->segments(); segs.size() > 1)
+    for (const auto& seg : segs)
+      std::printf("  file        : DE%d JD %.1f .. %.1f\n", seg.denum,
+                  seg.jd_begin, seg.jd_end);
   return 0;
 }
 
 int run_time(const argparse::ArgumentParser& a) {
-  auto ts = parse_utc(a.get<std::string>("datetime"));
+  auto eop = open_eop(a);
+  if (!eop) return 1;
+  auto ts = parse_utc(a.get<std::string>("datetime"), *eop);
   if (!ts) { std::fprintf(stderr, "error: bad datetime\n"); return 2; }
   std::printf("UTC  jd = %.6f\n", ts->jd_utc);
   std::printf("leap seconds (TAI-UTC) = %.0f s\n", ts->leap_seconds);
+  if (auto eo = eop->at(ts->jd_utc))
+    std::printf("UT1-UTC = %.7f s, pole x = %.6f\", y = %.6f\"\n", eo->ut1_utc,
+                eo->pole.x_arcsec, eo->pole.y_arcsec);
   std::printf("TT   jd = %.9f\n", ts->tt.jd.value());
   std::printf("UT1  jd = %.9f\n", ts->ut1.jd.value());
-  std::printf("TDB  jd = %.9f\n", tdb_from_tt(ts->tt).jd.value());
+  // The ephemeris is only needed for its TDB - TT table; else the series.
+  std::optional<Ephemeris> eph;
+  if (!a.get<std::string>("--tdb").empty() && !(eph = open_ephem(a))) return 1;
+  const TdbInstant tdb =
+      eph ? tdb_from_tt(ts->tt, eph->tdb_table()) : tdb_from_tt(ts->tt);
+  std::printf("TDB  jd = %.9f\n", tdb.jd.value());
   std::printf("delta_t (TT-UT1) = %.3f s\n", ts->delta_t.seconds);
   return 0;
 }
@@ -207,12 +256,26 @@ int run_state(const argparse::ArgumentParser& a) {
   auto center = parse_center(a.get<std::string>("--center"));
   auto ts = parse_utc(a.get<std::string>("datetime"));
   if (!body || !center || !ts) { std::fprintf(stderr, "error: bad body/center/datetime\n"); return 2; }
-  auto st = eph->state(*body, *center, tdb_from_tt(ts->tt), Units::au);
+  // state_pva() runs the acceleration kernel as well; only pay for it when
+  // it is printed.
+  const TdbInstant t = tdb_from_tt(ts->tt, eph->tdb_table());
+  const bool accel = a.get<bool>("--acceleration");
+  std::expected<PvaState, EphError> st;
+  if (accel) {
+    st = eph->state_pva(*body, *center, t, Units::au);
+  } else if (auto sv = eph->state(*body, *center, t, Units::au)) {
+    st = PvaState{sv->position, sv->velocity, {}, sv->units};
+  } else {
+    st = std::unexpected(sv.error());
+  }
   if (!st) { std::fprintf(stderr, "error: %s\n", std::string(to_string(st.error())).c_str()); return 1; }
   std::printf("position (AU)     : % .12e % .12e % .12e\n",
               st->position[0], st->position[1], st->position[2]);
   std::printf("velocity (AU/day) : % .12e % .12e % .12e\n",
               st->velocity[0], st->velocity[1], st->velocity[2]);
+  if (accel)
+    std::printf("accel (AU/day^2)  : % .12e % .12e % .12e\n",
+                st->acceleration[0], st->acceleration[1], st->acceleration[2]);
   return 0;
 }
 
@@ -244,7 +307,9 @@ int run_place(const argparse::ArgumentParser& a) {
 int run_sky(const argparse::ArgumentParser& a) {
   auto eph = open_ephem(a);
   if (!eph) return 1;
-  auto ts = parse_utc(a.get<std::string>("datetime"));
+  auto eop = open_eop(a);
+  if (!eop) return 1;
+  auto ts = parse_utc(a.get<std::string>("datetime"), *eop);
   if (!ts) { std::fprintf(stderr, "error: bad datetime\n"); return 2; }
   SurfaceObserver obs{47.6096694, -122.340412, 10.0, 15.0, 1026.4};
   if (auto os = a.present<std::string>("--observer")) {
@@ -261,7 +326,7 @@ int run_sky(const argparse::ArgumentParser& a) {
     auto sky = place(*eph, b, ts->tt, ts->delta_t, obs, CoordSys::equator_equinox,
                      Accuracy::full);
     if (!sky) continue;
-    auto hor = equ2hor(ts->ut1, ts->delta_t, Accuracy::full, PolarMotion{}, obs,
+    auto hor = equ2hor(ts->ut1, ts->delta_t, Accuracy::full, *eop, obs,
                        sky->ra_hours, sky->dec_deg, Refraction::from_location);
     std::printf("%-8s %12.6f %13.6f %16.9f %11.4f %11.4f\n",
                 std::string(to_string(b)).c_str(), sky->ra_hours, sky->dec_deg,
@@ -270,7 +335,7 @@ int run_sky(const argparse::ArgumentParser& a) {
   const Star polaris{2.5303010278, 89.2641094444, 3442.95, -11.8, 7.56, -17.4};
   if (auto sky = place(*eph, polaris, ts->tt, ts->delta_t, obs,
                        CoordSys::equator_equinox, Accuracy::full)) {
-    auto hor = equ2hor(ts->ut1, ts->delta_t, Accuracy::full, PolarMotion{}, obs,
+    auto hor = equ2hor(ts->ut1, ts->delta_t, Accuracy::full, *eop, obs,
                        sky->ra_hours, sky->dec_deg, Refraction::from_location);
     std::printf("%-8s %12.6f %13.6f %16.6e %11.4f %11.4f\n", "Polaris",
                 sky->ra_hours, sky->dec_deg, parallax_distance_au(polaris),
@@ -297,11 +362,12 @@ int run_rise(const argparse::ArgumentParser& a) {
   auto obs = parse_observer(a.get<std::string>("--observer"));
   if (!body || !ts || !obs) { std::fprintf(stderr, "error: bad body/datetime/observer\n"); return 2; }
   const auto dir = a.get<bool>("--back") ? Direction::backward : Direction::forward;
+  UtcText when;
   for (auto e : horizon_events(*eph, *body, *obs, ts->tt, parse_horizon(a.get<std::string>("--horizon")),
                                dir, ts->delta_t) |
                     std::views::take(a.get<int>("--count")))
     std::printf("%-11s %s  alt=%8.4f  az=%9.4f\n", event_name(e.kind),
-                tt_to_utc(e.time.jd.value()).c_str(), e.altitude_deg,
+                tt_to_utc(e.time, when), e.altitude_deg,
                 e.azimuth_deg);
   return 0;
 }
@@ -314,10 +380,11 @@ int run_seasons(const argparse::ArgumentParser& a) {
   const auto dir = a.get<bool>("--back") ? Direction::backward : Direction::forward;
   static const char* names[] = {"March equinox", "June solstice",
                                 "September equinox", "December solstice"};
+  UtcText when;
   for (auto m : tropical_moments(*eph, ts->tt, dir) |
                     std::views::take(a.get<int>("--count")))
     std::printf("%-18s %s\n", names[static_cast<int>(m.season)],
-                tt_to_utc(m.time.jd.value()).c_str());
+                tt_to_utc(m.time, when));
   return 0;
 }
 
@@ -330,16 +397,71 @@ int run_apsides(const argparse::ArgumentParser& a) {
   if (!body || !center || !ts) { std::fprintf(stderr, "error: bad body/center/datetime\n"); return 2; }
   const auto dir = a.get<bool>("--back") ? Direction::backward : Direction::forward;
   const bool geo = (*center == Point::earth);
+  UtcText when;
   for (auto ap : apsides(*eph, *body, *center, ts->tt, dir) |
                      std::views::take(a.get<int>("--count"))) {
     const char* name = (ap.kind == Apsis::periapsis) ? (geo ? "perigee" : "perihelion")
                                                       : (geo ? "apogee" : "aphelion");
     std::printf("%-10s %s  dist=%.7f AU\n", name,
-                tt_to_utc(ap.time.jd.value()).c_str(), ap.distance_au);
+                tt_to_utc(ap.time, when), ap.distance_au);
   }
   return 0;
 }
 
+int run_subset(const argparse::ArgumentParser& a) {
+  auto eph = open_ephem(a);
+  if (!eph) return 1;
+  auto from = parse_utc(a.get<std::string>("from"));
+  auto to = parse_utc(a.get<std::string>("to"));
+  if (!from || !to) { std::fprintf(stderr, "error: bad datetime\n"); return 2; }
+  SubsetSpec spec{.from = tdb_from_tt(from->tt, eph->tdb_table()),
+                  .to = tdb_from_tt(to->tt, eph->tdb_table()),
+                  .points = {},
+                  .nutations = a.get<bool>("--nutations"),
+                  .librations = a.get<bool>("--librations")};
+  if (auto list = a.present("--bodies")) {
+    for (auto part : std::views::split(*list, ',')) {
+      const std::string name(part.begin(), part.end());
+      auto p = parse_body(name);
+      if (!p) p = parse_center(name);
+      if (!p) { std::fprintf(stderr, "error: bad body '%s'\n", name.c_str()); return 2; }
+      spec.points.push_back(*p);
+    }
+  }
+  const std::string out = a.get<std::string>("output");
+  if (auto r = eph->write_subset(out, spec); !r) {
+    std::fprintf(stderr, "error: %s\n", std::string(to_string(r.error())).c_str());
+    return 1;
+  }
+  auto sub = Ephemeris::open(out);
+  if (!sub) { std::fprintf(stderr, "error: cannot reopen '%s'\n", out.c_str()); return 1; }
+  const auto& h = sub->header();
+  std::printf("%s: JD %.1f .. %.1f, %zu records of %zu bytes\n", out.c_str(),
+              h.jd_begin, h.jd_end, h.record_count - 2, h.record_length);
+  return 0;
+}
+
+int run_compress(const argparse::ArgumentParser& a) {
+  auto eph = open_ephem(a);
+  if (!eph) return 1;
+  const std::string out = a.get<std::string>("output");
+  if (auto r = eph->write_compressed(out); !r) {
+    std::fprintf(stderr, "error: %s\n", std::string(to_string(r.error())).c_str());
+    return 1;
+  }
+  auto packed = Ephemeris::open(out);
+  if (!packed) { std::fprintf(stderr, "error: cannot reopen '%s'\n", out.c_str()); return 1; }
+  const auto& h = packed->header();
+  const auto raw = static_cast<double>(h.record_count * h.record_length);
+  std::error_code ec;
+  const auto size = std::filesystem::file_size(out, ec);
+  if (ec) { std::fprintf(stderr, "error: cannot stat '%s'\n", out.c_str()); return 1; }
+  std::printf("%s: %zu records, %.0f -> %ju bytes (%.1f%%)\n", out.c_str(),
+              h.record_count - 2, raw, static_cast<std::uintmax_t>(size),
+              100.0 * static_cast<double>(size) / raw);
+  return 0;
+}
+
 }  // namespace
 
 int main(int argc, char** argv) {
@@ -348,7 +470,18 @@ int main(int argc, char** argv) {
 
   auto with_ephem = [](argparse::ArgumentParser& p) {
     p.add_argument("--ephemeris").default_value(std::string{})
-        .help("path to the DE ephemeris (else $LIBASTRO_EPHEMERIS or data/JPLEPH)");
+        .help("path to the DE ephemeris, or several joined with ':' "
+              "(else $LIBASTRO_EPHEMERIS or data/JPLEPH)");
+    p.add_argument("--tdb").default_value(std::string{})
+        .help("take TDB-TT from a table integrated from the ephemeris, cached "
+              "at this path (built on first use; else the series)");
+  };
+  auto with_eop = [](argparse::ArgumentParser& p) {
+    p.add_argument("--eop").default_value(std::string{})
+        .help("IERS finals file (finals2000A.daily etc.) for UT1-UTC and polar "
+              "motion (else $LIBASTRO_EOP; none: UT1-UTC = 0)");
+    p.add_argument("--leap-seconds").default_value(std::string{})
+        .help("IERS Leap_Second.dat or leap-seconds.list (else built in)");
   };
   auto with_stream = [](argparse::ArgumentParser& p) {
     p.add_argument("-n", "--count").scan<'i', int>().default_value(6)
@@ -363,6 +496,8 @@ int main(int argc, char** argv) {
   argparse::ArgumentParser time_cmd("time");
   time_cmd.add_description("Convert a UTC instant to TT/UT1/TDB and show leap seconds.");
   time_cmd.add_argument("datetime").help("UTC, YYYY-MM-DD[THH:MM[:SS]], or 'now'");
+  with_eop(time_cmd);
+  with_ephem(time_cmd);  // read only with --tdb
 
   argparse::ArgumentParser constant("constant");
   constant.add_description("Look up named ephemeris constants, or list them all.");
@@ -376,6 +511,7 @@ int main(int argc, char** argv) {
   state.add_argument("datetime").help("UTC or 'now'");
   state.add_argument("--center").default_value(std::string{"ssb"})
       .help("ssb | sun | earth | emb");
+  state.add_argument("--acceleration").flag().help("also print the acceleration");
   with_ephem(state);
 
   argparse::ArgumentParser place_cmd("place");
@@ -394,6 +530,7 @@ int main(int argc, char** argv) {
   sky.add_argument("datetime").help("UTC or 'now'");
   sky.add_argument("--observer").help("lat,lon,height (default: Seattle)");
   with_ephem(sky);
+  with_eop(sky);
 
   argparse::ArgumentParser rise("rise");
   rise.add_description("Rise / transit / set / antitransit stream for a body.");
@@ -420,6 +557,22 @@ int main(int argc, char** argv) {
   with_stream(apsides_cmd);
   with_ephem(apsides_cmd);
 
+  argparse::ArgumentParser subset("subset");
+  subset.add_description("Write a smaller DE file: fewer bodies, shorter span.");
+  subset.add_argument("output").help("path of the file to write");
+  subset.add_argument("from").help("UTC start of the span to keep");
+  subset.add_argument("to").help("UTC end of the span to keep");
+  subset.add_argument("--bodies")
+      .help("comma-separated bodies (and ssb/emb) to keep; default all");
+  subset.add_argument("--nutations").flag().help("keep the nutation series");
+  subset.add_argument("--librations").flag().help("keep the lunar librations");
+  with_ephem(subset);
+
+  argparse::ArgumentParser compress("compress");
+  compress.add_description("Write a losslessly compressed copy of the ephemeris.");
+  compress.add_argument("output").help("path of the container to write");
+  with_ephem(compress);
+
   program.add_subparser(info);
   program.add_subparser(time_cmd);
   program.add_subparser(constant);
@@ -429,6 +582,8 @@ int main(int argc, char** argv) {
   program.add_subparser(rise);
   program.add_subparser(seasons);
   program.add_subparser(apsides_cmd);
+  program.add_subparser(subset);
+  program.add_subparser(compress);
 
   try {
     program.parse_args(argc, argv);
@@ -447,6 +602,8 @@ int main(int argc, char** argv) {
   if (program.is_subcommand_used("rise")) return run_rise(rise);
   if (program.is_subcommand_used("seasons")) return run_seasons(seasons);
   if (program.is_subcommand_used("apsides")) return run_apsides(apsides_cmd);
+  if (program.is_subcommand_used("subset")) return run_subset(subset);
+  if (program.is_subcommand_used("compress")) return run_compress(compress);
 
   std::cerr << program;
   return 2;
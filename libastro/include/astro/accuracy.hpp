@@ -11,6 +11,47 @@ enum class Accuracy {
   reduced = 1,
 };
 
+// Where the of-date reductions (place() for equator_equinox and equator_cio,
+// a surface observer's position) take the nutation angles from. `series`
+// evaluates IAU 2000A or NU2000K as `Accuracy` selects, exactly as NOVAS does.
+// `ephemeris` interpolates the nutation series stored in the DE file instead:
+// one short Chebyshev sum in place of the ~1,365-term series, but the file's
+// model is IAU 1980, so the pole moves by up to ~0.05 arcsec (the IAU
+// 2000A-1980 difference) and results no longer match NOVAS. Selected per
+// ephemeris with OpenOptions::nutation; calls without an ephemeris (equ2hor,
+// sidereal time) always use the series.
+enum class NutationSource {
+  series = 0,
+  ephemeris = 1,
+};
+
+// How the IAU 2000A / NU2000K series are summed (nutation_angles()).
+// `exact` is NOVAS's loop, term by term with libm sin/cos, and reproduces it
+// bit for bit. `vectorized` sums four terms at a time from structure-of-arrays
+// tables with a polynomial sincos: several times faster, within 1e-9 arcsec of
+// `exact`. `recurrence` takes sin/cos of each fundamental argument once,
+// builds its multiples by angle addition and forms each term by complex
+// multiplication: no libm call per term, also within 1e-9 arcsec of `exact`.
+// test_nutation checks all three. Selected per ephemeris with
+// OpenOptions::nutation_evaluator for place() and the other of-date
+// reductions; calls without an ephemeris use `exact`.
+enum class NutationEvaluator {
+  exact = 0,
+  vectorized = 1,
+  recurrence = 2,
+};
+
+// Where TDB - TT comes from in the reductions given an ephemeris (sidereal
+// time, a surface observer's position, place()'s TT -> TDB step). `series`
+// is tdb_minus_tt_seconds(), the Circular 179 series (~10 us).
+// `ephemeris` reads a TdbTtTable integrated from the file's own dynamics
+// (see tdb_table.hpp), at the cost of one Chebyshev sum. Selected per
+// ephemeris with OpenOptions::tdb.
+enum class TdbSource {
+  series = 0,
+  ephemeris = 1,
+};
+
 }  // namespace astro
 
 #endif  // ASTRO_ACCURACY_HPP
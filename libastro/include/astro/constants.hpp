@@ -1,48 +1,73 @@
 #ifndef ASTRO_CONSTANTS_HPP
 #define ASTRO_CONSTANTS_HPP
 
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <vector>
 
 namespace astro {
 
 // The named constant block. DE440 carries NCON=645 name/value pairs; NOVAS-C
 // discards them, and >400 names spill from CNAM into CNAM2 after LPT (research
-// doc 1.2, 1.6). Ephemeris::open() parses the names (CNAM + CNAM2) and the
-// record-2 values into this map; test/unit/test_constants.cpp checks every pair
-// against the con440.c transcription (bit-for-bit).
+// doc 1.2, 1.6). Ephemeris::open() reads the names (CNAM + CNAM2) and the
+// record-2 values but leaves them raw: the name -> value map is built on the
+// first get() or entries() (once, from whichever thread asks first), so an
+// open that never looks a constant up never pays for it. The hot constants
+// below are picked out at open without building the map.
+// test/unit/test_constants.cpp checks every pair against the con440.c
+// transcription (bit-for-bit).
 class Constants {
  public:
+  // Hashes std::string and std::string_view alike, so a lookup by view
+  // allocates nothing.
+  struct NameHash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view name) const noexcept {
+      return std::hash<std::string_view>{}(name);
+    }
+  };
+  using Map = std::unordered_map<std::string, double, NameHash, std::equal_to<>>;
+
   Constants() = default;
-  explicit Constants(std::unordered_map<std::string, double> values)
-      : values_(std::move(values)) {}
+  explicit Constants(const std::unordered_map<std::string, double>& values);
+  // As laid out in the file: `names` holds one 6-byte, blank-padded name per
+  // entry of `values` (CNAM, then CNAM2).
+  Constants(std::string names, std::vector<double> values);
 
-  std::optional<double> get(std::string_view name) const {
-    if (auto it = values_.find(std::string(name)); it != values_.end())
-      return it->second;
-    return std::nullopt;
-  }
+  std::optional<double> get(std::string_view name) const;
 
-  // Convenience accessors for the widely-used constants. Return nullopt if the
-  // ephemeris did not carry the key.
-  std::optional<double> au_km() const { return get("AU"); }
-  std::optional<double> earth_moon_ratio() const { return get("EMRAT"); }
-  std::optional<double> speed_of_light_km_s() const { return get("CLIGHT"); }
-  std::optional<double> earth_radius_km() const { return get("RE"); }
+  // Convenience accessors for the widely-used constants, resolved when the
+  // block is loaded (no lookup). Return nullopt if the ephemeris did not carry
+  // the key.
+  std::optional<double> au_km() const { return hot_[kAu]; }
+  std::optional<double> earth_moon_ratio() const { return hot_[kEmrat]; }
+  std::optional<double> speed_of_light_km_s() const { return hot_[kClight]; }
+  std::optional<double> earth_radius_km() const { return hot_[kRe]; }
+  std::optional<double> gm_sun() const { return hot_[kGms]; }          // AU^3/day^2
+  std::optional<double> gm_earth_moon() const { return hot_[kGmb]; }   // AU^3/day^2
 
-  std::size_t size() const noexcept { return values_.size(); }
-  bool empty() const noexcept { return values_.empty(); }
+  std::size_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return size_ == 0; }
 
   // All name/value pairs, for enumeration (e.g. listing every constant). The
   // order is unspecified (hash order); sort by name if you need a stable list.
-  const std::unordered_map<std::string, double>& entries() const noexcept {
-    return values_;
-  }
+  const Map& entries() const;
 
  private:
-  std::unordered_map<std::string, double> values_;
+  enum Hot { kAu, kEmrat, kClight, kRe, kGms, kGmb, kHotCount };
+  static constexpr std::array<std::string_view, kHotCount> kHotNames = {
+      "AU", "EMRAT", "CLIGHT", "RE", "GMS", "GMB"};
+
+  struct Table;  // the raw block until the map is built, then the map
+  std::shared_ptr<Table> table_;
+  std::size_t size_ = 0;
+  std::array<std::optional<double>, kHotCount> hot_{};
 };
 
 }  // namespace astro
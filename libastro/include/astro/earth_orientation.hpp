@@ -0,0 +1,99 @@
+#ifndef ASTRO_EARTH_ORIENTATION_HPP
+#define ASTRO_EARTH_ORIENTATION_HPP
+
+#include <expected>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "astro/error.hpp"
+
+namespace astro {
+
+// Polar motion (IERS Bulletin A) in arcseconds; both 0 to ignore.
+struct PolarMotion {
+  double x_arcsec = 0.0;
+  double y_arcsec = 0.0;
+};
+
+// Earth orientation parameters at one UTC instant.
+struct EarthOrientation {
+  double ut1_utc = 0.0;  // UT1 - UTC, seconds
+  PolarMotion pole{};
+};
+
+// IERS Earth orientation (UT1 - UTC, polar motion) and leap seconds, loaded
+// from local files -- the libastro counterpart of the legacy ephutil/bull_a.c,
+// without the download. The finals file is memory-mapped and parsed once into
+// a dense per-day array indexed by integer MJD, so a lookup is an index and a
+// linear interpolation: no search, whatever the span. Immutable after load(),
+// so one table may serve any number of threads.
+//
+// Finals: the IERS fixed-column "finals" format (finals2000A.daily,
+// finals2000A.data, finals.all, ...); the Bulletin A columns are used, through
+// the last day that has both UT1 - UTC and the pole (predictions included).
+// UT1 - UTC is interpolated as UT1 - TAI, so a leap second between two daily
+// values does not smear across the day.
+//
+// Leap seconds: IERS Leap_Second.dat or the IETF/NIST leap-seconds.list. With
+// none given, the built-in table (astro::tai_minus_utc) is used. Either way a
+// leap second takes effect strictly after its 0h UTC: the instant 0h itself
+// keeps the old TAI - UTC (and UT1 - UTC), as astro::tai_minus_utc.
+//
+// A default-constructed table is empty: at() always nullopt, tai_minus_utc()
+// the built-in table -- i.e. the behaviour of the calls that take no table.
+class EarthOrientationTable {
+ public:
+  EarthOrientationTable() = default;
+
+  // Errors: file_not_found; bad_header for a finals file with no usable day,
+  // a gap in its days, or a malformed leap-second line.
+  static std::expected<EarthOrientationTable, EphError> load(
+      const std::filesystem::path& finals,
+      const std::filesystem::path& leap_seconds = {});
+
+  // load(), from file contents already in memory.
+  static std::expected<EarthOrientationTable, EphError> parse(
+      std::string_view finals, std::string_view leap_seconds = {});
+
+  bool empty() const noexcept { return days_.empty(); }
+  int first_mjd() const noexcept { return first_mjd_; }
+  int last_mjd() const noexcept {
+    return first_mjd_ + static_cast<int>(days_.size()) - 1;
+  }
+  // Whether at() has a value for UTC Julian date `jd_utc`.
+  bool covers(double jd_utc) const noexcept;
+
+  // Interpolated between the daily values; nullopt outside the table.
+  std::optional<EarthOrientation> at(double jd_utc) const noexcept;
+
+  // TAI - UTC in seconds at UTC Julian date `jd_utc`: the loaded leap-second
+  // list if any, else the built-in table.
+  double tai_minus_utc(double jd_utc) const noexcept;
+
+ private:
+  struct Day {
+    double ut1_tai;  // UT1 - TAI, seconds: continuous across leap seconds
+    double x_arcsec;
+    double y_arcsec;
+    double tai_utc;  // TAI - UTC in effect that day
+  };
+  struct Leap {
+    double jd_utc;  // UTC Julian date it took effect
+    double tai_utc;
+  };
+
+  // TAI - UTC at fraction `f` of day `i`, which holds `jd_utc`: the day's
+  // own, except at 0h, which still has the day before's.
+  double day_tai_utc(std::size_t i, double f, double jd_utc) const noexcept;
+  double leap_at(double jd_utc) const noexcept;
+
+  int first_mjd_ = 0;
+  std::vector<Day> days_;
+  std::vector<Leap> leaps_;  // ascending; empty -> built-in table
+};
+
+}  // namespace astro
+
+#endif  // ASTRO_EARTH_ORIENTATION_HPP
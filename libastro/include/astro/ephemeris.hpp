@@ -6,8 +6,11 @@
 #include <expected>
 #include <filesystem>
 #include <memory>
+#include <span>
 #include <string>
+#include <vector>
 
+#include "astro/accuracy.hpp"
 #include "astro/body.hpp"
 #include "astro/constants.hpp"
 #include "astro/error.hpp"
@@ -16,6 +19,8 @@
 
 namespace astro {
 
+class TdbTtTable;
+
 // Per-group Chebyshev layout triple from the header (research doc 1.3):
 // (1-based offset into the record, coefficients per component, sub-intervals).
 struct GroupLayout {
@@ -36,17 +41,167 @@ struct Header {
   double earth_moon_ratio = 0.0; // EMRAT
   std::size_t record_length = 0; // bytes
   std::size_t record_count = 0;  // data + header records
+  bool compressed = false;       // a write_compressed() container
 
   // Groups 1..12 in IPT, plus librations (LPT) as group 13. Index by the raw
   // JPL group order (Mercury, Venus, EMB, Mars, ... Sun, Nutations, Librations).
   std::array<GroupLayout, 13> groups{};
 };
 
+// How Ephemeris::open() reaches the data records.
+enum class OpenMode {
+  // Read each record into a private buffer when state() first needs it (the
+  // eph_manager model: one read + one record-sized copy per record change).
+  buffered,
+  // Memory-map the whole file; state() interpolates straight from the mapping,
+  // so a record change costs no syscall and no copy.
+  mapped,
+};
+
+// How Ephemeris::open() stores the Chebyshev coefficients state() reads.
+enum class Precision {
+  // The file's doubles as they are: state() matches eph_manager bit for bit.
+  full,
+  // Every data record converted to float during open() and kept in memory:
+  // half the bytes per record, for screening work (visibility, conjunction
+  // candidates) that does not need sub-metre positions. Each body's position
+  // error is bounded by Ephemeris::position_error_bound().
+  float32,
+};
+
+struct OpenOptions {
+  OpenMode mode = OpenMode::buffered;
+  // mapped only: fault the whole file into the page cache during open(), so
+  // timed loops never take a page fault. Costs the file size in resident
+  // memory up front (~100 MB for DE440, ~3 GB for DE441).
+  bool populate = false;
+  // buffered only: how many data records each handle keeps in memory, evicting
+  // the least recently used. 1 matches eph_manager; a few more stop place()'s
+  // light-time and deflection epochs, or callers alternating between distant
+  // epochs, from re-reading across a record boundary. Each slot costs one
+  // record (8144 bytes for DE440/441). 0 is treated as 1.
+  std::size_t cache_records = 1;
+  // buffered only: once successive record misses advance by a constant stride
+  // (a forward or backward sweep -- tables, apsides(), tropical_moments()),
+  // ask the OS to read this many records ahead along it (posix_fadvise), so
+  // the reads overlap computation. 0 disables. Mapped files rely on the
+  // kernel's own fault read-around; both modes honour Ephemeris::prefetch().
+  std::size_t readahead_records = 8;
+  // buffered only: state_many() issues the reads of every record its batch
+  // needs and the cache lacks at once, keeping up to this many in flight
+  // (io_uring on Linux, else as many reader threads), and interpolates each
+  // record as it arrives. For scattered epochs the reads then overlap each
+  // other and the Chebyshev work instead of queueing one by one. Records read
+  // this way bypass the cache, so a batch does not evict it. Each handle
+  // sets its ring or threads up on its first batch and keeps them. Off (0)
+  // by default: records read on demand through the cache, like state(). With
+  // the file already in the page cache batching only adds overhead; turn it
+  // on (32 is a good depth) for cold or network storage.
+  std::size_t batch_queue_depth = 0;
+  // Precision::float32 reads and converts every data record in open() (half
+  // the file size in memory: ~50 MB for DE440, ~1.5 GB for DE441) and then
+  // serves state() from memory, so mode, populate, cache_records and
+  // readahead_records no longer apply.
+  Precision precision = Precision::full;
+  // Points whose coefficients open() gathers out of the body-interleaved
+  // records into one contiguous array each, in record order. state(),
+  // position(), state_many() and snapshot() then read a transposed body's
+  // few hundred bytes per record from memory, never the file or record cache,
+  // so sweeping one body over centuries touches a fraction of the bytes (the
+  // Jupiter series is 144 of DE441's 8144-byte records). Costs one pass over
+  // the file in open() and the body's share of it in memory. Earth and the
+  // Moon need two series each, the EMB one, the SSB none (as SubsetSpec);
+  // body_not_available if the file lacks one. Precision::full only -- a
+  // float32 ephemeris already holds every record in memory.
+  std::vector<Point> transposed{};
+  // Where place() and the other of-date reductions given this ephemeris take
+  // nutation from (see NutationSource). NutationSource::ephemeris needs the
+  // nutation group, else open() fails with body_not_available.
+  NutationSource nutation = NutationSource::series;
+  // How those reductions sum the nutation series under NutationSource::series
+  // (see NutationEvaluator).
+  NutationEvaluator nutation_evaluator = NutationEvaluator::exact;
+  // Where those reductions take TDB - TT from (see TdbSource).
+  // TdbSource::ephemeris makes open() generate a TdbTtTable over the file's
+  // (or set's) span, which needs every planet, the Moon and the Sun, else
+  // body_not_available. With tdb_cache set the table is read from there when
+  // it was made from the same DE number and span, and written there
+  // otherwise (TdbTtTable::cached()), so only the first open() pays for it.
+  TdbSource tdb = TdbSource::series;
+  std::filesystem::path tdb_cache{};
+};
+
+// Record-cache counters of one handle (Ephemeris::cache_stats()). A mapped
+// ephemeris has no cache -- the page cache does that job -- and reports zeros.
+struct CacheStats {
+  std::uint64_t hits = 0;        // record already resident
+  std::uint64_t misses = 0;      // record read from the file
+  std::uint64_t evictions = 0;   // resident record dropped to make room
+  std::uint64_t bytes_read = 0;  // data-record bytes read by misses
+  std::uint64_t prefetched = 0;  // records hinted to the OS ahead of need
+  // state_many()'s batched reads (OpenOptions::batch_queue_depth), also
+  // counted in misses and bytes_read. Waits run from submission until
+  // state_many() takes the record, in nanoseconds.
+  std::uint64_t batched = 0;         // records read as part of a batch
+  std::uint64_t max_queue_depth = 0; // most batched reads in flight at once
+  std::uint64_t batch_wait_ns = 0;   // summed over batched reads
+  std::uint64_t max_batch_wait_ns = 0;
+};
+
+// Earth nutation from the ephemeris's own series (Ephemeris::nutation()): in
+// longitude and in obliquity, radians, and their rates in radians/day.
+struct NutationAngles {
+  double dpsi = 0.0;
+  double deps = 0.0;
+  double dpsi_rate = 0.0;
+  double deps_rate = 0.0;
+};
+
+// Lunar mantle libration (Ephemeris::libration()): the Euler angles phi,
+// theta, psi of the Moon's body frame, radians, and their rates in
+// radians/day.
+struct LibrationAngles {
+  Vec3 angles{};
+  Vec3 rates{};
+};
+
+// What Ephemeris::write_subset() keeps. Records are copied whole, so the
+// written span is [from, to] widened out to record boundaries.
+struct SubsetSpec {
+  TdbInstant from;
+  TdbInstant to;
+  // Points state() must still answer for, as target or center; empty keeps
+  // every body. Earth and the Moon each need both the EMB and geocentric Moon
+  // series, the EMB only the former, the SSB nothing.
+  std::vector<Point> points;
+  bool nutations = false;   // keep the nutation series (group 12)
+  bool librations = false;  // keep the lunar libration series (group 13)
+};
+
+// Barycentric states of all 13 Points at one epoch (Ephemeris::snapshot()),
+// plus the raw geocentric Moon that Earth<->Moon pairs are taken from.
+struct StateSnapshot {
+  std::array<StateVector, 13> barycentric{};  // indexed by Point
+  StateVector geocentric_moon{};
+
+  const StateVector& operator[](Point p) const noexcept {
+    return barycentric[static_cast<std::size_t>(p)];
+  }
+
+  // `target` relative to `center` by subtraction; bit-identical to
+  // Ephemeris::state(target, center, t) at the snapshot's epoch and units.
+  StateVector relative(Point target, Point center) const noexcept;
+};
+
 // Layer 0: an opened DE440/DE441 file as an RAII value type. Unlike NOVAS-C's
 // eph_manager (file-scope globals, one ephemeris at a time, not reentrant --
 // research doc 2.4), instances are independent and self-contained.
 //
-// Movable, non-copyable (owns a file handle + record buffer).
+// Movable, non-copyable. Concurrency: handle() gives another Ephemeris over the
+// same open file, header and constants with its own record cursor, so distinct
+// handles may call state() (and everything layered on it) from different
+// threads without locks. A single handle is not safe for concurrent use --
+// except in OpenMode::mapped, which keeps no per-call state at all.
 class Ephemeris {
  public:
   Ephemeris(Ephemeris&&) noexcept;
@@ -57,21 +212,130 @@ class Ephemeris {
 
   // Open and parse the header. Mirrors ephem_open's failure modes via EphError.
   static std::expected<Ephemeris, EphError> open(
-      const std::filesystem::path& path);
+      const std::filesystem::path& path, OpenOptions options = {});
+  static std::expected<Ephemeris, EphError> open(
+      const std::filesystem::path& path, OpenMode mode) {
+    return open(path, OpenOptions{mode});
+  }
+
+  // One ephemeris over several files -- DE441's two parts, or DE440 for the
+  // modern era in front of DE441 -- each opened with `options`. Every call
+  // goes to the file whose span holds its epoch, found by binary search over
+  // the merged spans; where spans overlap, the earlier-listed file wins.
+  // Epochs in a gap between files fail as outside any one file would. The
+  // result is an ordinary Ephemeris, so place() and the phenomena streams
+  // run across file boundaries. invalid_argument for an empty list.
+  static std::expected<Ephemeris, EphError> open(
+      std::span<const std::filesystem::path> paths, OpenOptions options = {});
+
+  // A new handle sharing this ephemeris's file, header and constants (no I/O,
+  // no parsing; in buffered mode, an empty record cache of the same capacity
+  // with its own counters). Handles may outlive the instance they came from.
+  // Give each worker thread its own.
+  Ephemeris handle() const;
 
+  // For several files: the first one's header and constants, with jd_begin
+  // and jd_end widened to the whole set. segments() has every file's header
+  // in the order given (just header() for a single file).
   const Header& header() const noexcept;
   const Constants& constants() const noexcept;
+  std::span<const Header> segments() const noexcept;
 
   bool covers(TdbInstant t) const noexcept;
 
+  Precision precision() const noexcept;
+
+  // Upper bound, in km, on how far state(p, SSB).position may sit from its
+  // Precision::full value, from the rounding of every coefficient in the file
+  // (0 at full precision). A relative state is off by at most the sum of the
+  // two bounds. Velocities are perturbed alike but carry no bound.
+  double position_error_bound(Point p) const noexcept;
+
   // Position/velocity of `target` relative to `center` at TDB epoch `t`.
   // Reproduces planet_ephemeris, including the EMB/Moon/Earth reconstruction
   // via EMRAT (research doc 1.5). `target == center` yields the zero state.
   std::expected<StateVector, EphError> state(
       Point target, Point center, TdbInstant t, Units units = Units::au) const;
 
+  // state() plus the acceleration, from the second derivative of the same
+  // Chebyshev series and the same EMB/Moon/Earth reconstruction: position and
+  // velocity are bit-identical to state()'s. About twice the cost of state();
+  // differencing velocities instead costs two more and loses digits.
+  std::expected<PvaState, EphError> state_pva(
+      Point target, Point center, TdbInstant t, Units units = Units::au) const;
+
+  // state().position alone, bit-identical to it, skipping the derivative
+  // basis and velocity sums (about half the interpolation work). For callers
+  // that discard velocity: light-time iteration, deflector positions.
+  std::expected<Vec3, EphError> position(
+      Point target, Point center, TdbInstant t, Units units = Units::au) const;
+
+  // state() at every epoch of `t`, into out[i] (same size as `t`, else
+  // invalid_argument). Epochs are resolved up front and evaluated grouped by
+  // record -- each record looked up once -- in any input order; results are
+  // bit-identical to per-epoch state(). Buffered files read the records not
+  // already cached concurrently (OpenOptions::batch_queue_depth). Any error
+  // fails the whole batch and leaves `out` untouched: an out-of-range epoch
+  // or a body the file lacks before a record is read, a read error after.
+  std::expected<void, EphError> state_many(Point target, Point center,
+                                           std::span<const TdbInstant> t,
+                                           std::span<StateVector> out,
+                                           Units units = Units::au) const;
+
+  // The file's nutation (group 12) and lunar libration (group 13) series at
+  // `t`: one Chebyshev evaluation each, like state(). body_not_available if
+  // the file lacks the group (libration in DE200; either in a subset).
+  std::expected<NutationAngles, EphError> nutation(TdbInstant t) const;
+  std::expected<LibrationAngles, EphError> libration(TdbInstant t) const;
+  NutationSource nutation_source() const noexcept;
+  NutationEvaluator nutation_evaluator() const noexcept;
+  // The table open() made for OpenOptions::tdb = TdbSource::ephemeris; an
+  // empty one (the series everywhere) otherwise. Shared by every handle().
+  const TdbTtTable& tdb_table() const noexcept;
+
+  // Every Point's barycentric state at `t` from a single pass over one record:
+  // each raw group is interpolated once and Earth/Moon are reconstructed once,
+  // so an N-body table costs one snapshot plus N subtractions (relative()).
+  std::expected<StateSnapshot, EphError> snapshot(
+      TdbInstant t, Units units = Units::au) const;
+
+  // Write a DE-format file holding only `spec`'s bodies and span: the same
+  // header, constants and coefficients in smaller records, and fewer of them,
+  // so the subset's state() is bit-identical to this one's wherever it
+  // answers. Dropped bodies then fail with body_not_available. Errors:
+  // invalid_argument if from > to, epoch_out_of_range outside covers(),
+  // io_error if `out` cannot be written (no partial file is left behind).
+  // On a set the span must lie within one of its files: one that crosses
+  // from one file into the next fails with invalid_argument.
+  // Readers that hard-code the record length per DE number (eph_manager.c)
+  // cannot open a subset; open() derives it from the group layout.
+  std::expected<void, EphError> write_subset(const std::filesystem::path& out,
+                                             const SubsetSpec& spec) const;
+
+  // Write this ephemeris as a compressed container: the same records, coded
+  // losslessly in small blocks, which open() recognises and decodes on demand
+  // into the record cache -- so its state() is bit-identical to this one's.
+  // Each double keeps its sign and mantissa; only exponents are coded, so
+  // expect the file 10-15% smaller. A container always opens buffered.
+  // Errors: invalid_argument for several files (compress each), io_error if
+  // `out` cannot be written (no partial file is left behind).
+  std::expected<void, EphError> write_compressed(
+      const std::filesystem::path& out) const;
+
+  // Hint that epochs between `from` and `to` (either order; clamped to the
+  // file's span) are about to be read: the OS starts loading their records in
+  // the background and this returns at once. Advisory, so it cannot fail.
+  void prefetch(TdbInstant from, TdbInstant to) const noexcept;
+
+  // This handle's record-cache counters since open()/handle() or the last
+  // reset_cache_stats().
+  CacheStats cache_stats() const noexcept;
+  void reset_cache_stats() noexcept;
+
  private:
   Ephemeris();
+  // open()'s last step: the TdbSource::ephemeris table, if `options` asks.
+  std::expected<void, EphError> attach_tdb_table(const OpenOptions& options);
   struct Impl;
   std::unique_ptr<Impl> impl_;
 };
@@ -18,6 +18,7 @@ enum class EphError {
   unknown_constant,
   invalid_argument,
   no_convergence,      // light-time iteration failed to converge
+  body_not_available,  // group absent from this file (e.g. a subset)
 };
 
 constexpr std::string_view to_string(EphError e) noexcept {
@@ -32,6 +33,7 @@ constexpr std::string_view to_string(EphError e) noexcept {
     case EphError::unknown_constant:   return "unknown constant name";
     case EphError::invalid_argument:   return "invalid argument";
     case EphError::no_convergence:     return "iteration did not converge";
+    case EphError::body_not_available: return "body not in this ephemeris";
   }
   return "unknown error";
 }
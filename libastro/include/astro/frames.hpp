@@ -24,6 +24,10 @@ double mean_obliquity(double jd_tdb);
 // `t` = Julian centuries of TDB since J2000.0. `full` accuracy uses IAU 2000A;
 // `reduced` uses the NU2000K truncation. NOVAS `nutation_angles`.
 void nutation_angles(double t, Accuracy accuracy, double& dpsi, double& deps);
+// As above, summed by `evaluator` (see NutationEvaluator); the call above is
+// NutationEvaluator::exact.
+void nutation_angles(double t, Accuracy accuracy, NutationEvaluator evaluator,
+                     double& dpsi, double& deps);
 
 }  // namespace astro
 
@@ -19,9 +19,13 @@ enum class Direction { forward, backward };
 
 // Equatorial (true equator & equinox of date) -> ecliptic of date, using the
 // true obliquity. Angles in hours (ra) / degrees. Analogue of NOVAS equ2ecl
-// with coord_sys = 1; validated bit-for-bit against it.
+// with coord_sys = 1; validated bit-for-bit against it. With `eph`, TDB - TT
+// and the nutation angles come from where it was opened to take them
+// (OpenOptions::tdb, nutation, nutation_evaluator), as in place(); without,
+// from the series.
 void equ_to_ecl_of_date(double jd_tt, double ra_hours, double dec_deg,
-                        double& ecl_lon_deg, double& ecl_lat_deg);
+                        double& ecl_lon_deg, double& ecl_lat_deg,
+                        const Ephemeris* eph = nullptr);
 
 // The Sun's apparent geocentric ecliptic longitude of date, in [0, 360) degrees.
 double sun_apparent_longitude(const Ephemeris& eph, TtInstant t);
@@ -5,6 +5,7 @@
 
 #include "astro/accuracy.hpp"
 #include "astro/body.hpp"
+#include "astro/earth_orientation.hpp"
 #include "astro/ephemeris.hpp"
 #include "astro/error.hpp"
 #include "astro/state_vector.hpp"
@@ -80,6 +81,8 @@ struct SkyPos {
 //     analytic celestial-intermediate basis -- no CIO data file needed);
 //   - accuracy: `full` (IAU 2000A nutation, Sun+Jupiter+Saturn deflection) and
 //     `reduced` (NU2000K nutation, Sun-only deflection);
+//   - nutation: the series `accuracy` selects, or the ephemeris's own
+//     nutation group if `eph` was opened with NutationSource::ephemeris;
 //   - `SkyPos::radial_velocity_km_s` is computed (rad_vel); `distance_au` is 0
 //     for a star.
 //
@@ -100,12 +103,6 @@ std::expected<SkyPos, EphError> place(
     const Ephemeris& eph, const Star& star, TtInstant t, DeltaT dt,
     const SurfaceObserver& observer, CoordSys sys, Accuracy accuracy);
 
-// Polar motion (IERS Bulletin A) in arcseconds; both 0 to ignore.
-struct PolarMotion {
-  double x_arcsec = 0.0;
-  double y_arcsec = 0.0;
-};
-
 // Atmospheric refraction model for equ2hor (NOVAS ref_option).
 enum class Refraction {
   none = 0,            // no refraction; refracted RA/Dec == input
@@ -126,15 +123,35 @@ struct HorizonPos {
 // local zenith distance / azimuth for a surface observer, optionally applying
 // atmospheric refraction. Applies polar motion and Earth rotation via the
 // equinox-based terrestrial<->celestial transform. Analogue of NOVAS `equ2hor`.
+// TDB - TT and nutation come from the series.
 HorizonPos equ2hor(Ut1Instant t, DeltaT dt, Accuracy accuracy, PolarMotion pole,
                    const SurfaceObserver& observer, double ra_hours,
                    double dec_deg, Refraction refraction);
 
+// As above, with TDB - TT and nutation from where `eph` was opened to take
+// them (OpenOptions::tdb, nutation, nutation_evaluator), as place() does.
+HorizonPos equ2hor(const Ephemeris& eph, Ut1Instant t, DeltaT dt,
+                   Accuracy accuracy, PolarMotion pole,
+                   const SurfaceObserver& observer, double ra_hours,
+                   double dec_deg, Refraction refraction);
+
+// As above, with the pole interpolated from `eop` at `t` (the daily values are
+// indexed by UTC date; UT1 stands in for it, < 0.9 s off). No polar motion
+// outside the table. The series for TDB - TT and nutation.
+HorizonPos equ2hor(Ut1Instant t, DeltaT dt, Accuracy accuracy,
+                   const EarthOrientationTable& eop,
+                   const SurfaceObserver& observer, double ra_hours,
+                   double dec_deg, Refraction refraction);
+
 // Greenwich apparent sidereal time (hours, in [0, 24)) at UT1 instant `t`.
 // GAST = GMST + equation of the equinoxes. NOVAS sidereal_time (equinox method,
-// apparent). Local apparent sidereal time is GAST + longitude/15.
+// apparent). Local apparent sidereal time is GAST + longitude/15. TDB - TT and
+// nutation from the series; the `eph` overload takes them from where `eph`
+// selects, as equ2hor's does.
 double greenwich_apparent_sidereal_time(Ut1Instant t, DeltaT dt,
                                         Accuracy accuracy);
+double greenwich_apparent_sidereal_time(const Ephemeris& eph, Ut1Instant t,
+                                        DeltaT dt, Accuracy accuracy);
 
 }  // namespace astro
 
@@ -0,0 +1,105 @@
+#ifndef ASTRO_SPK_HPP
+#define ASTRO_SPK_HPP
+
+#include <expected>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+
+#include "astro/body.hpp"
+#include "astro/error.hpp"
+#include "astro/state_vector.hpp"
+#include "astro/time_scales.hpp"
+
+namespace astro {
+
+// NAIF integer ID of a Point, as SPK segments name bodies. The DE planets
+// beyond the Earth are system barycenters (Mars = 4, not 499), as in the DE
+// files themselves.
+constexpr int naif_id(Point p) noexcept {
+  switch (p) {
+    case Point::mercury:                 return 1;
+    case Point::venus:                   return 2;
+    case Point::earth:                   return 399;
+    case Point::mars:                    return 4;
+    case Point::jupiter:                 return 5;
+    case Point::saturn:                  return 6;
+    case Point::uranus:                  return 7;
+    case Point::neptune:                 return 8;
+    case Point::pluto:                   return 9;
+    case Point::moon:                    return 301;
+    case Point::sun:                     return 10;
+    case Point::solar_system_barycenter: return 0;
+    case Point::earth_moon_barycenter:   return 3;
+  }
+  return -1;
+}
+
+// One segment of an SPK file, from its DAF summary.
+struct SpkSegment {
+  int target = 0;      // NAIF ID
+  int center = 0;      // NAIF ID
+  int frame = 0;       // NAIF frame code; 1 = J2000 (ICRF)
+  int type = 0;        // SPK data type
+  double begin = 0.0;  // coverage, TDB seconds past J2000
+  double end = 0.0;
+  std::string name;    // segment identifier, trimmed
+  bool indexed = false;  // served by state(); see SpkFile
+};
+
+// A NAIF SPK (.bsp) file: asteroid, comet and spacecraft ephemerides beyond
+// the 13 DE groups, with the Layer 0 state() interface but NAIF IDs for
+// bodies. The file is memory-mapped and its segments indexed at open();
+// state() then evaluates straight from the mapping with the DE reader's
+// Chebyshev kernels. Immutable after open(), so one SpkFile may serve any
+// number of threads.
+//
+// Served: Chebyshev segments -- Type 2 (position; velocity by
+// differentiation) and Type 3 (position and velocity series) -- of up to 32
+// coefficients per component, in the J2000 frame, little-endian
+// ("LTL-IEEE"). Other segments are listed in segments() with indexed = false
+// and never used. Where segments of a body overlap, the later one in the file
+// wins (the SPICE rule); each body's coverage is flattened into one sorted
+// interval index at open(), so finding a segment is a binary search.
+//
+// state(target, center) follows segment centers from both bodies until the
+// chains meet (an asteroid's heliocentric segment and a Sun-from-SSB
+// segment, say) and returns the difference. Errors: body_not_available if
+// the chains never meet, epoch_out_of_range if one stops for want of
+// coverage at `t`. AU and AU/day use the IAU 2012 AU (149 597 870.7 km):
+// SPK carries no AU of its own.
+class SpkFile {
+ public:
+  // Errors: file_not_found; bad_header for anything but a well-formed
+  // little-endian DAF/SPK file.
+  static std::expected<SpkFile, EphError> open(const std::filesystem::path& path);
+
+  SpkFile(SpkFile&&) noexcept;
+  SpkFile& operator=(SpkFile&&) noexcept;
+  ~SpkFile();
+
+  // Every segment, in file order.
+  std::span<const SpkSegment> segments() const noexcept;
+
+  // Whether an indexed segment of `body` covers `t`.
+  bool covers(int body, TdbInstant t) const noexcept;
+
+  std::expected<StateVector, EphError> state(int target, int center,
+                                             TdbInstant t,
+                                             Units units = Units::au) const;
+
+  // state().position alone, bit-identical to it, skipping the derivative
+  // basis (Type 2) or the velocity series (Type 3).
+  std::expected<Vec3, EphError> position(int target, int center, TdbInstant t,
+                                         Units units = Units::au) const;
+
+ private:
+  SpkFile();
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace astro
+
+#endif  // ASTRO_SPK_HPP
@@ -20,6 +20,15 @@ struct StateVector {
   Units units = Units::au;
 };
 
+// StateVector plus acceleration, from Ephemeris::state_pva(): the second
+// derivative of the same Chebyshev series, not a difference of velocities.
+struct PvaState {
+  Vec3 position{};      // AU or km
+  Vec3 velocity{};      // AU/day or km/s
+  Vec3 acceleration{};  // AU/day^2 or km/s^2
+  Units units = Units::au;
+};
+
 }  // namespace astro
 
 #endif  // ASTRO_STATE_VECTOR_HPP
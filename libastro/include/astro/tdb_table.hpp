@@ -0,0 +1,89 @@
+#ifndef ASTRO_TDB_TABLE_HPP
+#define ASTRO_TDB_TABLE_HPP
+
+#include <cstddef>
+#include <expected>
+#include <filesystem>
+#include <vector>
+
+#include "astro/error.hpp"
+#include "astro/time_scales.hpp"
+
+namespace astro {
+
+class Ephemeris;
+
+// TDB - TT from a Chebyshev table integrated out of an ephemeris, for work
+// that needs more than the 7-term series of tdb_minus_tt_seconds() (~10 us).
+//
+// generate() integrates the IAU 2006 B3 rate relation over the ephemeris
+// span:
+//   d(TDB - TT)/dTDB = (w + L_G - L_B - L_G w) / (1 - L_B),
+//   w = (v_E^2 / 2 + U_ext(x_E)) / c^2,
+// with the geocentre's barycentric velocity and the potential of the Sun,
+// Moon and planets from the ephemeris itself (the same dynamics
+// Fairhead-Bretagnon's series models). The result is kept as one Chebyshev
+// series per 16 days of 13 coefficients, so a lookup costs the same as one
+// Layer 0 interpolation. The integration fixes everything but the constant
+// of integration, and any slow drift from what the rate leaves out (asteroids,
+// 1/c^4 terms). Both are taken from a least-squares fit to the series, which
+// has neither.
+//
+// Generating the table walks the whole ephemeris span once (12 snapshots per
+// 16 days, some 300,000 for DE440), so it is made once and kept: save() /
+// load(), or cached() to do both. Ephemeris::open() builds or loads one
+// itself with OpenOptions::tdb = TdbSource::ephemeris. Immutable once made;
+// any number of threads may read one.
+class TdbTtTable {
+ public:
+  // Empty: tdb_minus_tt_seconds() is the series everywhere.
+  TdbTtTable() = default;
+
+  // Errors: anything state() returns for the span (e.g. body_not_available
+  // for a subset without the planets); unknown_constant if the file lacks
+  // AU, CLIGHT, EMRAT or a GM.
+  static std::expected<TdbTtTable, EphError> generate(const Ephemeris& eph);
+
+  // Errors: file_not_found; bad_header for anything but a save() file.
+  static std::expected<TdbTtTable, EphError> load(
+      const std::filesystem::path& path);
+  // Errors: io_error (no partial file is left behind).
+  std::expected<void, EphError> save(const std::filesystem::path& path) const;
+
+  // load(path) if it holds a table of an ephemeris with eph's DE number and
+  // span; otherwise generate() and save() there. A cache that cannot be
+  // written is not an error -- the table is returned all the same.
+  static std::expected<TdbTtTable, EphError> cached(
+      const Ephemeris& eph, const std::filesystem::path& path);
+
+  bool empty() const noexcept { return coeff_.empty(); }
+  // The span the table covers, TT Julian dates.
+  double jd_begin() const noexcept { return begin_; }
+  double jd_end() const noexcept {
+    return begin_ + static_cast<double>(intervals()) * kIntervalDays;
+  }
+  bool covers(double jd_tt) const noexcept;
+
+  // TDB - TT in seconds at TT Julian date `jd_tt`: the table, or the series
+  // (astro::tdb_minus_tt_seconds) outside covers().
+  double tdb_minus_tt_seconds(double jd_tt) const noexcept;
+  double tdb_minus_tt_seconds(TtInstant t) const noexcept;
+
+ private:
+  static constexpr double kIntervalDays = 16.0;
+  static constexpr int kCoeff = 13;
+
+  std::size_t intervals() const noexcept { return coeff_.size() / kCoeff; }
+  double evaluate(double whole, double frac) const noexcept;
+
+  double begin_ = 0.0;
+  // The ephemeris it came from, for cached().
+  int denum_ = 0;
+  double eph_begin_ = 0.0;
+  double eph_end_ = 0.0;
+  std::vector<double> coeff_;  // kCoeff per interval, seconds
+};
+
+}  // namespace astro
+
+#endif  // ASTRO_TDB_TABLE_HPP
@@ -1,6 +1,13 @@
 #ifndef ASTRO_TIME_HPP
 #define ASTRO_TIME_HPP
 
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <span>
+
+#include "astro/error.hpp"
 #include "astro/time_scales.hpp"
 
 // Civil-time utilities: Gregorian calendar <-> Julian date, leap seconds, and
@@ -10,6 +17,9 @@
 
 namespace astro {
 
+class EarthOrientationTable;  // astro/earth_orientation.hpp
+class TdbTtTable;            // astro/tdb_table.hpp
+
 // Julian date of a UT-like instant from a proleptic Gregorian calendar date.
 // `hour` is the fractional hour of day [0, 24). Output shares the input's time
 // basis (UTC in -> UTC JD out, etc.). NOVAS `julian_date`.
@@ -25,10 +35,64 @@ struct CivilDate {
 // Inverse of julian_date (NOVAS `cal_date`), valid for any jd > 0.
 CivilDate calendar_date(double jd);
 
+// ---- ISO 8601 timestamps ----------------------------------------------------
+//
+// A UTC calendar instant for text I/O, with the seconds kept as decimal
+// digits (whole seconds + nanoseconds) so that what is read is exactly what is
+// written back. Parsing and formatting are locale-independent and never
+// allocate: they work in caller buffers with std::from_chars / std::to_chars
+// semantics, for streaming millions of events or states.
+struct UtcTimestamp {
+  int year = 2000;
+  int month = 1;
+  int day = 1;
+  int hour = 0;
+  int minute = 0;
+  int second = 0;               // 60 only in a leap second (23:59:60)
+  std::int32_t nanosecond = 0;  // [0, 999'999'999]
+};
+
+// The longest text format_utc_timestamp() writes: a signed 10-digit year and
+// a 9-digit fraction.
+inline constexpr std::size_t kUtcTimestampMaxChars = 37;
+
+// Parse an ISO 8601 extended-format UTC timestamp at the start of
+// [first, last): "YYYY-MM-DD", then optionally 'T' or ' ' and "hh:mm", then
+// ":ss", then '.' or ',' and 1-9 fraction digits, then 'Z'. Years outside
+// 0000-9999 take a sign ("-0044", "+12000"). Fields are range-checked against
+// the Gregorian calendar; ss = 60 only at 23:59. On success `out` is set and
+// ptr is past the timestamp; otherwise ec is std::errc::invalid_argument, ptr
+// is `first` and `out` is untouched. A fraction past nanoseconds is rejected
+// rather than rounded.
+std::from_chars_result parse_utc_timestamp(const char* first, const char* last,
+                                           UtcTimestamp& out) noexcept;
+
+// Write `t` to [first, last) as "YYYY-MM-DDThh:mm:ss[.fff]Z" with `digits`
+// (0-9) fraction digits, truncating the nanoseconds (utc_timestamp() rounds to
+// the same count first, so nothing is lost). No terminator is written. On
+// success ec is std::errc{} and ptr is past the text; if it does not fit, ec
+// is std::errc::value_too_large and ptr is `last`.
+std::to_chars_result format_utc_timestamp(char* first, char* last,
+                                          const UtcTimestamp& t,
+                                          int digits = 0) noexcept;
+
+// The UTC Julian date of `t` in two parts: 0h of its day, and the time of day
+// as a fraction. A leap second 23:59:60 falls on 0h of the next day, as
+// everywhere a UTC Julian date is used.
+JulianDate julian_date(const UtcTimestamp& t) noexcept;
+
+// The timestamp of UTC Julian date `jd_utc`, rounded to `digits` (0-9)
+// fraction digits, with any carry into the minute, day, month and year. Never
+// a leap second (see above). The two-part form resolves well below a
+// nanosecond; a one-part date near the present resolves only ~40 us.
+UtcTimestamp utc_timestamp(JulianDate jd_utc, int digits = 0) noexcept;
+
 // Cumulative leap seconds, TAI - UTC in seconds, in effect at UTC Julian date
 // `jd_utc`, from the built-in IERS table. The table is current through the last
 // entry in src/time.cpp (2017-01-01 = 37 s; no leap seconds announced since).
-// Dates before 1972 return the earliest tabulated value.
+// Each value takes effect strictly after its 0h UTC (the legacy lookup's
+// rule), so 0h itself still has the previous one. Dates before 1972 return
+// the earliest tabulated value.
 double tai_minus_utc(double jd_utc);
 
 // Time scales derived from a UTC instant. `ut1_utc` is (UT1 - UTC) in seconds
@@ -48,12 +112,73 @@ TimeScaleSet utc_time_scales(double jd_utc, double ut1_utc = 0.0);
 TimeScaleSet utc_time_scales(int year, int month, int day, double hour,
                              double ut1_utc = 0.0);
 
+// As above, with UT1 - UTC and TAI - UTC looked up in `eop` (O(1) per call),
+// so a bulk conversion needs no caller-side lookups. Outside the table's days
+// UT1 - UTC is taken as 0, as by default above.
+TimeScaleSet utc_time_scales(double jd_utc, const EarthOrientationTable& eop);
+TimeScaleSet utc_time_scales(int year, int month, int day, double hour,
+                             const EarthOrientationTable& eop);
+
 // TDB - TT, in seconds, at TT Julian date `jd_tt` (the periodic relativistic
 // term; USNO Circular 179 eq. 2.6). |TDB - TT| stays under ~2 ms.
 double tdb_minus_tt_seconds(double jd_tt);
 
 // Convert TT to TDB (the ephemeris time scale) using the term above.
 TdbInstant tdb_from_tt(TtInstant t);
+// As above with TDB - TT from `table` (the series outside it): e.g. an
+// ephemeris's own, Ephemeris::tdb_table().
+TdbInstant tdb_from_tt(TtInstant t, const TdbTtTable& table);
+
+// ---- Batch conversions ------------------------------------------------------
+//
+// The scalar calls above over arrays, for bulk ingestion. Structure-of-arrays
+// in and out: each output is a column the caller owns, element i belonging to
+// input i, and any column left empty is skipped. Every two-part result keeps
+// the input UTC Julian date as its whole part, so only the fraction is written:
+// TT = {jd_utc[i], tt_frac[i]}, etc. TDB is formed the same way (so it keeps
+// the fraction's precision, which tdb_from_tt(TtInstant) folds away).
+//
+// The TDB - TT series runs four instants at a time through a vectorized sine
+// (src/simd.hpp): within ~1e-14 s of the scalar series, not bit-identical. The
+// leap-second lookup is reused while consecutive instants stay between the
+// same two leap seconds, so sorted input costs one search per leap second.
+//
+// Errors: invalid_argument if a non-empty column's size differs from the
+// input's (nothing is written then).
+struct TimeScaleColumns {
+  std::span<double> leap_seconds;  // TAI - UTC, seconds
+  std::span<double> tt_frac;       // days
+  std::span<double> ut1_frac;      // days
+  std::span<double> tdb_frac;      // days
+  std::span<double> delta_t;       // TT - UT1, seconds
+};
+
+// `ut1_utc`: UT1 - UTC in seconds per instant; the two-argument form takes 0
+// throughout.
+std::expected<void, EphError> utc_time_scales(std::span<const double> jd_utc,
+                                              std::span<const double> ut1_utc,
+                                              const TimeScaleColumns& out);
+std::expected<void, EphError> utc_time_scales(std::span<const double> jd_utc,
+                                              const TimeScaleColumns& out);
+// UT1 - UTC and TAI - UTC from `eop`, as the scalar overload.
+std::expected<void, EphError> utc_time_scales(std::span<const double> jd_utc,
+                                              const EarthOrientationTable& eop,
+                                              const TimeScaleColumns& out);
+
+// TDB - TT in seconds at each TT Julian date.
+std::expected<void, EphError> tdb_minus_tt_seconds(std::span<const double> jd_tt,
+                                                   std::span<double> seconds);
+
+// TT -> TDB for two-part TT dates {tt_whole[i], tt_frac[i]} (`tt_frac` may be
+// empty for 0): TDB = {tt_whole[i], tdb_frac[i]}.
+std::expected<void, EphError> tdb_from_tt(std::span<const double> tt_whole,
+                                          std::span<const double> tt_frac,
+                                          std::span<double> tdb_frac);
+// As above with TDB - TT from `table`, one Chebyshev sum per instant.
+std::expected<void, EphError> tdb_from_tt(std::span<const double> tt_whole,
+                                          std::span<const double> tt_frac,
+                                          std::span<double> tdb_frac,
+                                          const TdbTtTable& table);
 
 }  // namespace astro
 
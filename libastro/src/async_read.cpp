@@ -0,0 +1,375 @@
+#include "async_read.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#  include <cstring>
+#  include <linux/io_uring.h>
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#  define ASTRO_HAVE_IO_URING 1
+#else
+#  define ASTRO_HAVE_IO_URING 0
+#endif
+
+namespace astro::io {
+
+using Clock = std::chrono::steady_clock;
+
+// Common state of the two backends; the batch mechanics are theirs.
+struct ReadQueue::Impl {
+  Impl(std::size_t depth, bool uring)
+      : depth(std::max<std::size_t>(depth, 1)), uring(uring) {}
+  virtual ~Impl() = default;
+
+  // Take on `reads` from `fd`; the previous batch has ended.
+  void begin(int f, std::span<const Read> r) {
+    fd = f;
+    reads = r;
+    issued.assign(r.size(), {});
+    stats = {};
+    stats.reads = r.size();
+    stats.uring = uring;
+    start();
+  }
+  virtual void start() = 0;
+  virtual std::optional<Completion> next() = 0;
+  // Issue none of the batch's remaining reads and wait for those in flight.
+  virtual void end() = 0;
+
+  // Account for read `i` finishing now.
+  void finished(std::size_t i) {
+    const auto wait =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - issued[i]);
+    stats.total_latency += wait;
+    stats.max_latency = std::max(stats.max_latency, wait);
+  }
+
+  std::size_t depth;
+  bool uring;
+  // The current batch.
+  int fd = -1;
+  std::span<const Read> reads;
+  std::vector<Clock::time_point> issued;  // per read
+  BatchStats stats;
+};
+
+namespace {
+
+// The whole of `r` with blocking pread()s, resuming after short reads and
+// EINTR (FileHandle::read_at).
+bool pread_all(int fd, const Read& r) {
+  auto* p = static_cast<char*>(r.dst);
+  std::size_t n = r.n;
+  std::uint64_t offset = r.offset;
+  while (n > 0) {
+    const ssize_t got = ::pread(fd, p, n, static_cast<off_t>(offset));
+    if (got < 0 && errno == EINTR) continue;
+    if (got <= 0) return false;
+    p += got;
+    n -= static_cast<std::size_t>(got);
+    offset += static_cast<std::uint64_t>(got);
+  }
+  return true;
+}
+
+// Fallback: workers, started as batches need them up to `depth`, take reads
+// in order and block in pread(); the calling thread collects their
+// completions from a queue. Between batches they sleep on `work_`.
+class ThreadBackend final : public ReadQueue::Impl {
+ public:
+  explicit ThreadBackend(std::size_t depth) : Impl(depth, false) {}
+
+  ~ThreadBackend() override {
+    {
+      std::lock_guard lock(mutex_);
+      stop_ = true;
+    }
+    work_.notify_all();
+    workers_.clear();  // joins; no batch is running
+  }
+
+  void start() override {
+    {
+      std::lock_guard lock(mutex_);
+      next_ = 0;
+      count_ = reads.size();
+      max_in_flight_ = 0;
+    }
+    returned_ = 0;
+    const std::size_t want = std::min(depth, reads.size());
+    while (workers_.size() < want) workers_.emplace_back([this] { work(); });
+    work_.notify_all();
+  }
+
+  std::optional<Completion> next() override {
+    if (returned_ == reads.size()) return std::nullopt;
+    std::unique_lock lock(mutex_);
+    ready_.wait(lock, [&] { return !done_.empty(); });
+    const Completion c = done_.back();
+    done_.pop_back();
+    stats.max_in_flight = max_in_flight_;
+    lock.unlock();
+    finished(c.index);
+    ++returned_;
+    return c;
+  }
+
+  void end() override {
+    std::unique_lock lock(mutex_);
+    count_ = 0;
+    ready_.wait(lock, [&] { return in_flight_ == 0; });
+    done_.clear();
+  }
+
+ private:
+  // Workers touch the batch (reads, fd, issued) only between taking a read
+  // index below count_ and reporting it, which start() and end() bracket.
+  void work() {
+    std::unique_lock lock(mutex_);
+    for (;;) {
+      work_.wait(lock, [&] { return stop_ || next_ < count_; });
+      if (stop_) return;
+      const std::size_t i = next_++;
+      const Read r = reads[i];
+      const int f = fd;
+      issued[i] = Clock::now();
+      max_in_flight_ = std::max(max_in_flight_, ++in_flight_);
+      lock.unlock();
+      const bool ok = pread_all(f, r);
+      lock.lock();
+      --in_flight_;
+      done_.push_back({i, ok});
+      ready_.notify_one();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable work_;   // workers: a batch started, or stop_
+  std::condition_variable ready_;  // caller: a completion, or in_flight_ fell
+  // Guarded by mutex_:
+  std::size_t next_ = 0;   // first read no worker has taken
+  std::size_t count_ = 0;  // reads workers may take; 0 between batches
+  std::size_t in_flight_ = 0;
+  std::size_t max_in_flight_ = 0;
+  bool stop_ = false;
+  std::vector<Completion> done_;
+  // The caller's own:
+  std::size_t returned_ = 0;
+  std::vector<std::jthread> workers_;  // last: joined before the rest goes
+};
+
+#if ASTRO_HAVE_IO_URING
+
+int uring_setup(unsigned entries, io_uring_params* p) {
+  return static_cast<int>(::syscall(__NR_io_uring_setup, entries, p));
+}
+
+int uring_enter(int ring, unsigned to_submit, unsigned min_complete) {
+  return static_cast<int>(::syscall(__NR_io_uring_enter, ring, to_submit,
+                                    min_complete, IORING_ENTER_GETEVENTS,
+                                    nullptr, 0));
+}
+
+// One IORING_OP_READ per read, at most `depth` in flight; next() tops the
+// submission queue up and then reaps, sleeping in io_uring_enter() only when
+// no completion is waiting. The ring is sized to `depth` and outlives batches.
+class UringBackend final : public ReadQueue::Impl {
+ public:
+  // nullptr if the kernel will not give us a ring.
+  static std::unique_ptr<UringBackend> create(std::size_t depth) {
+    auto u = std::unique_ptr<UringBackend>(new UringBackend(depth));
+    if (!u->map()) return nullptr;
+    return u;
+  }
+
+  ~UringBackend() override {
+    if (sqes_) ::munmap(sqes_, sqes_size_);
+    if (cq_ptr_ && cq_ptr_ != sq_ptr_) ::munmap(cq_ptr_, cq_size_);
+    if (sq_ptr_) ::munmap(sq_ptr_, sq_size_);
+    if (ring_ >= 0) ::close(ring_);
+  }
+
+  void start() override {
+    next_ = 0;
+    returned_ = 0;
+    submit();
+  }
+
+  std::optional<Completion> next() override {
+    if (returned_ == reads.size()) return std::nullopt;
+    submit();
+    if (done_.empty()) reap();
+    const Completion c = done_.back();
+    done_.pop_back();
+    ++returned_;
+    return c;
+  }
+
+  void end() override {
+    // The kernel may still write into buffers of reads in flight.
+    next_ = reads.size();
+    while (in_flight_ > 0) reap();
+    done_.clear();
+  }
+
+ private:
+  explicit UringBackend(std::size_t depth) : Impl(depth, true) {}
+
+  bool map() {
+    const auto entries =
+        static_cast<unsigned>(std::min<std::size_t>(depth, 4096));
+    io_uring_params p{};
+    ring_ = uring_setup(entries, &p);
+    if (ring_ < 0) return false;
+    depth = std::min<std::size_t>(depth, p.sq_entries);
+
+    sq_size_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cq_size_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    const bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+    auto ring_map = [&](std::size_t size, off_t what) -> void* {
+      void* m = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring_, what);
+      return m == MAP_FAILED ? nullptr : m;
+    };
+    sq_ptr_ = ring_map(sq_size_, IORING_OFF_SQ_RING);
+    if (!sq_ptr_) return false;
+    cq_ptr_ = single ? sq_ptr_ : ring_map(cq_size_, IORING_OFF_CQ_RING);
+    if (!cq_ptr_) return false;
+    sqes_size_ = p.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = static_cast<io_uring_sqe*>(ring_map(sqes_size_, IORING_OFF_SQES));
+    if (!sqes_) return false;
+
+    auto* sq = static_cast<char*>(sq_ptr_);
+    auto* cq = static_cast<char*>(cq_ptr_);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+    auto* array = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+    for (unsigned i = 0; i < p.sq_entries; ++i) array[i] = i;  // SQE i in slot i
+    cq_head_ = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+    return true;
+  }
+
+  // Queue reads until `depth` are in flight and hand them to the kernel. If
+  // it refuses, the reads it did not take are done here with pread().
+  void submit() {
+    unsigned queued = 0;
+    unsigned tail = *sq_tail_;  // only this thread writes it
+    while (next_ < reads.size() && in_flight_ + queued < depth) {
+      const Read& r = reads[next_];
+      io_uring_sqe& sqe = sqes_[tail & sq_mask_];
+      std::memset(&sqe, 0, sizeof sqe);
+      sqe.opcode = IORING_OP_READ;
+      sqe.fd = fd;
+      sqe.off = r.offset;
+      sqe.addr = reinterpret_cast<std::uintptr_t>(r.dst);
+      sqe.len = static_cast<unsigned>(std::min<std::size_t>(r.n, 1u << 30));
+      sqe.user_data = next_;
+      issued[next_] = Clock::now();
+      ++next_;
+      ++tail;
+      ++queued;
+    }
+    if (queued == 0) return;
+    std::atomic_ref(*sq_tail_).store(tail, std::memory_order_release);
+    in_flight_ += queued;
+    stats.max_in_flight = std::max<std::uint64_t>(stats.max_in_flight, in_flight_);
+
+    while (queued > 0) {
+      const int n = uring_enter(ring_, queued, 0);
+      if (n < 0 && (errno == EINTR || errno == EAGAIN || errno == EBUSY)) continue;
+      if (n <= 0) {
+        // Take back what the kernel never consumed and read it directly.
+        std::atomic_ref(*sq_tail_).store(tail - queued, std::memory_order_release);
+        in_flight_ -= queued;
+        for (std::size_t i = next_ - queued; i < next_; ++i) {
+          const bool ok = pread_all(fd, reads[i]);
+          finished(i);
+          done_.push_back({i, ok});
+        }
+        return;
+      }
+      queued -= static_cast<unsigned>(n);
+    }
+  }
+
+  // Move every posted completion to done_, sleeping until there is one. If
+  // the kernel will not let us wait, poll: any syscall (yield) still runs
+  // the task work that posts completions.
+  void reap() {
+    unsigned head = *cq_head_;
+    unsigned tail = std::atomic_ref(*cq_tail_).load(std::memory_order_acquire);
+    while (head == tail) {
+      if (uring_enter(ring_, 0, 1) < 0 && errno != EINTR) std::this_thread::yield();
+      tail = std::atomic_ref(*cq_tail_).load(std::memory_order_acquire);
+    }
+    for (; head != tail; ++head) {
+      const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+      const auto i = static_cast<std::size_t>(cqe.user_data);
+      const Read& r = reads[i];
+      // Short reads and errors (including an old kernel's -EINVAL for
+      // IORING_OP_READ) are finished the blocking way.
+      bool ok = cqe.res >= 0 && static_cast<std::size_t>(cqe.res) == r.n;
+      if (!ok) ok = pread_all(fd, r);
+      finished(i);
+      done_.push_back({i, ok});
+      --in_flight_;
+    }
+    std::atomic_ref(*cq_head_).store(head, std::memory_order_release);
+  }
+
+  int ring_ = -1;
+  void* sq_ptr_ = nullptr;
+  void* cq_ptr_ = nullptr;
+  io_uring_sqe* sqes_ = nullptr;
+  std::size_t sq_size_ = 0, cq_size_ = 0, sqes_size_ = 0;
+  unsigned* sq_tail_ = nullptr;
+  unsigned sq_mask_ = 0;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned cq_mask_ = 0;
+  io_uring_cqe* cqes_ = nullptr;
+
+  std::size_t next_ = 0;       // first read not yet submitted
+  std::size_t in_flight_ = 0;  // submitted, completion not yet reaped
+  std::size_t returned_ = 0;
+  std::vector<Completion> done_;  // reaped, not yet returned
+};
+
+#endif  // ASTRO_HAVE_IO_URING
+
+}  // namespace
+
+ReadQueue::ReadQueue(std::size_t depth) {
+#if ASTRO_HAVE_IO_URING
+  impl_ = UringBackend::create(depth);
+#endif
+  if (!impl_) impl_ = std::make_unique<ThreadBackend>(depth);
+}
+
+ReadQueue::~ReadQueue() = default;
+
+BatchReader::BatchReader(ReadQueue& queue, int fd, std::span<const Read> reads)
+    : queue_(*queue.impl_) {
+  queue_.begin(fd, reads);
+}
+
+BatchReader::~BatchReader() { queue_.end(); }
+
+std::optional<Completion> BatchReader::next() { return queue_.next(); }
+
+const BatchStats& BatchReader::stats() const noexcept { return queue_.stats; }
+
+}  // namespace astro::io
@@ -0,0 +1,88 @@
+#ifndef ASTRO_SRC_ASYNC_READ_HPP
+#define ASTRO_SRC_ASYNC_READ_HPP
+
+// Internal: a batch of positioned reads from one file descriptor, all issued
+// up front and handed back one by one as they complete, so the caller can work
+// on the data that has arrived while the rest is still in flight.
+//
+// On Linux the reads go through an io_uring (raw syscalls; no liburing), sized
+// to the queue depth. Where the kernel lacks io_uring or a seccomp policy
+// denies it, up to `depth` worker threads issue blocking pread()s instead.
+// Either way a read that fails or comes back short is retried with pread()
+// before it is reported, so a completion's `ok` means the same as
+// FileHandle::read_at().
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+
+namespace astro::io {
+
+// One read of a batch: `n` bytes at byte `offset` into `dst`.
+struct Read {
+  void* dst = nullptr;
+  std::size_t n = 0;
+  std::uint64_t offset = 0;
+};
+
+struct Completion {
+  std::size_t index = 0;  // into the batch's reads
+  bool ok = false;
+};
+
+// What one batch did. Latency runs from submission to completion as seen by
+// next(), so it includes any time the caller spent between next() calls.
+struct BatchStats {
+  std::uint64_t reads = 0;
+  std::uint64_t max_in_flight = 0;
+  std::chrono::nanoseconds total_latency{0};
+  std::chrono::nanoseconds max_latency{0};
+  bool uring = false;  // io_uring, not the thread fallback
+};
+
+// The engine batches run on: an io_uring, or a pool of up to `depth` reader
+// threads where the kernel will not give one. Set up once (the ring on
+// construction, the threads as batches need them) and reused by every batch,
+// so a batch pays no setup. One batch at a time; not thread-safe.
+class ReadQueue {
+ public:
+  explicit ReadQueue(std::size_t depth);
+  ~ReadQueue();
+  ReadQueue(const ReadQueue&) = delete;
+  ReadQueue& operator=(const ReadQueue&) = delete;
+
+  struct Impl;
+
+ private:
+  friend class BatchReader;
+  std::unique_ptr<Impl> impl_;
+};
+
+class BatchReader {
+ public:
+  // Starts reading every entry of `reads` from `fd` on `queue`, at most its
+  // depth in flight at a time. `queue`, `reads` and their buffers must
+  // outlive the reader, and `queue` runs no other batch meanwhile.
+  BatchReader(ReadQueue& queue, int fd, std::span<const Read> reads);
+  // Stops issuing reads and waits for those in flight (their buffers may be
+  // about to go away).
+  ~BatchReader();
+  BatchReader(const BatchReader&) = delete;
+  BatchReader& operator=(const BatchReader&) = delete;
+
+  // Blocks until another read completes and returns it; nullopt once every
+  // read has been returned.
+  std::optional<Completion> next();
+
+  const BatchStats& stats() const noexcept;
+
+ private:
+  ReadQueue::Impl& queue_;
+};
+
+}  // namespace astro::io
+
+#endif  // ASTRO_SRC_ASYNC_READ_HPP
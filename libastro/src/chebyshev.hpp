@@ -0,0 +1,265 @@
+#ifndef ASTRO_SRC_CHEBYSHEV_HPP
+#define ASTRO_SRC_CHEBYSHEV_HPP
+
+// Internal: the Chebyshev evaluators behind every ephemeris reader -- JPL DE
+// records (ephemeris.cpp) and SPK Type 2/3 segments (spk.cpp) alike. A
+// coefficient block is addressed as [subinterval][component][coeff]; an SPK
+// record is a block of one subinterval.
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+
+// std::mdspan: native <mdspan> when the toolchain ships it, else the vendored
+// Kokkos reference impl (its <experimental/mdspan> exposes std::mdspan). See
+// cmake/mdspan.cmake.
+#if defined(LIBASTRO_NATIVE_MDSPAN)
+#  include <mdspan>
+#else
+#  include <experimental/mdspan>
+#endif
+
+#include "simd.hpp"
+
+namespace astro::cheb {
+
+// Largest coefficient count per component the kernels take: DE440's largest
+// is 14 (Mercury). Bounds the local Chebyshev basis arrays without heap
+// traffic.
+constexpr int kMaxCoeff = 32;
+
+// Differentiate and interpolate one 3-component body from its Chebyshev block.
+//   buf : first coefficient of the body within the record
+//   t0  : fractional time within the whole record span, [0, 1)
+//   t1  : record span length in output time units (days for AU, s for km)
+//   ncf : coefficients per component;  na : sub-intervals in the record
+// Reproduces eph_manager.c:interpolate; the coefficient block is addressed as a
+// rank-3 std::mdspan with layout [subinterval][component][coeff] (layout_right,
+// stride: coeff=1, component=ncf, subinterval=3*ncf). Where the target has
+// 256-bit registers the three components are summed as the lanes of one.
+// kVelocity = false skips the derivative basis and sums (position-only
+// callers); `velocity` is then unused. kNcf > 0 fixes the coefficient count at
+// compile time (the `ncf` argument is then ignored), so the basis recurrences
+// and sums have constant trip counts and unroll fully; kNcf = 0 is the generic
+// runtime-`ncf` kernel. C is the stored coefficient type: double, or float
+// for Precision::float32, widened on load so the sums still run in double.
+// kComp is the number of components: 3, or 2 for the nutation angles.
+template <int kNcf, bool kVelocity = true, class C = double, int kComp = 3>
+void interpolate(const C* buf, double t0, double t1, int ncf, int na,
+                 double position[3], double velocity[3]) {
+  static_assert(kNcf == 0 || (kNcf >= 3 && kNcf <= kMaxCoeff));
+  constexpr int kBasis = kNcf > 0 ? kNcf : kMaxCoeff;
+  const int n = kNcf > 0 ? kNcf : ncf;
+  using Extents = std::extents<std::size_t, std::dynamic_extent, kComp,
+                               std::dynamic_extent>;
+  const std::mdspan<const C, Extents> coeff(
+      buf, Extents(static_cast<std::size_t>(na), static_cast<std::size_t>(n)));
+
+  const double dna = static_cast<double>(na);
+  const double dt1 = static_cast<double>(static_cast<long>(t0));
+  const double temp = dna * t0;
+  const long l = static_cast<long>(temp - dt1);          // sub-interval index
+  const double tc = 2.0 * (std::fmod(temp, 1.0) + dt1) - 1.0;  // in [-1, 1]
+  const double twot = tc + tc;
+
+  // Chebyshev polynomials T_j(tc).
+  std::array<double, kBasis> pc{};
+  pc[0] = 1.0;
+  pc[1] = tc;
+  for (int i = 2; i < n; ++i) pc[i] = twot * pc[i - 1] - pc[i - 2];
+
+  // Derivative basis dT_j/dtc.
+  std::array<double, kBasis> vc{};
+  if constexpr (kVelocity) {
+    vc[0] = 0.0;
+    vc[1] = 1.0;
+    vc[2] = 2.0 * twot;
+    for (int i = 3; i < n; ++i)
+      vc[i] = twot * vc[i - 1] + 2.0 * pc[i - 1] - vc[i - 2];
+  }
+
+  const double vfac = (2.0 * dna) / t1;
+#if ASTRO_SIMD_NATIVE_F64X4
+  if constexpr (kComp == 3) {
+    using simd::f64x4;
+    // One pass over the block with x, y, z as the lanes of one register.
+    f64x4 p{}, v{};
+    for (int j = n - 1; j >= 1; --j) {
+      const f64x4 c{coeff[l, 0, j], coeff[l, 1, j], coeff[l, 2, j], 0.0};
+      p += pc[j] * c;
+      if constexpr (kVelocity) v += vc[j] * c;
+    }
+    p += pc[0] * f64x4{coeff[l, 0, 0], coeff[l, 1, 0], coeff[l, 2, 0], 0.0};
+    for (int i = 0; i < 3; ++i) {
+      position[i] = p[i];
+      if constexpr (kVelocity) velocity[i] = v[i] * vfac;
+    }
+    return;
+  }
+#endif
+  // Narrower targets: assembling the strided x, y, z coefficients into lanes
+  // costs more than it saves, so sum each component on its own.
+  for (int i = 0; i < kComp; ++i) {
+    double sp = 0.0, sv = 0.0;
+    for (int j = n - 1; j >= 1; --j) {
+      sp += pc[j] * coeff[l, i, j];
+      if constexpr (kVelocity) sv += vc[j] * coeff[l, i, j];
+    }
+    position[i] = sp + pc[0] * coeff[l, i, 0];
+    if constexpr (kVelocity) velocity[i] = sv * vfac;
+  }
+}
+
+// interpolate() at four epochs of the same record at once, one epoch per lane:
+// the Chebyshev recurrences run on vectors of tc, and each lane repeats the
+// scalar operation sequence exactly. Lanes that share a sub-interval (the
+// usual case) broadcast each coefficient; otherwise it is gathered per lane.
+// kNcf, C and kComp as for interpolate().
+template <int kNcf, class C = double, int kComp = 3>
+void interpolate4(const C* buf, const double t0[4], double t1, int ncf,
+                  int na, double position[4][3], double velocity[4][3]) {
+  static_assert(kNcf == 0 || (kNcf >= 3 && kNcf <= kMaxCoeff));
+  constexpr int kBasis = kNcf > 0 ? kNcf : kMaxCoeff;
+  const int n = kNcf > 0 ? kNcf : ncf;
+  using simd::f64x4;
+  using Extents = std::extents<std::size_t, std::dynamic_extent, kComp,
+                               std::dynamic_extent>;
+  const std::mdspan<const C, Extents> coeff(
+      buf, Extents(static_cast<std::size_t>(na), static_cast<std::size_t>(n)));
+
+  const double dna = static_cast<double>(na);
+  long l[4];
+  f64x4 tc;
+  for (int k = 0; k < 4; ++k) {
+    const double dt1 = static_cast<double>(static_cast<long>(t0[k]));
+    const double temp = dna * t0[k];
+    l[k] = static_cast<long>(temp - dt1);
+    tc[k] = 2.0 * (std::fmod(temp, 1.0) + dt1) - 1.0;
+  }
+  const f64x4 twot = tc + tc;
+  const bool shared = l[0] == l[1] && l[0] == l[2] && l[0] == l[3];
+
+  std::array<f64x4, kBasis> pc;
+  pc[0] = f64x4{1.0, 1.0, 1.0, 1.0};
+  pc[1] = tc;
+  for (int i = 2; i < n; ++i) pc[i] = twot * pc[i - 1] - pc[i - 2];
+
+  std::array<f64x4, kBasis> vc;
+  vc[0] = f64x4{};
+  vc[1] = f64x4{1.0, 1.0, 1.0, 1.0};
+  vc[2] = 2.0 * twot;
+  for (int i = 3; i < n; ++i)
+    vc[i] = twot * vc[i - 1] + 2.0 * pc[i - 1] - vc[i - 2];
+
+  auto lanes = [&](int i, int j, f64x4& c) {  // coefficient (i, j) per lane
+    if (shared) {
+      const double x = static_cast<double>(coeff[l[0], i, j]);
+      c = f64x4{x, x, x, x};
+    } else {
+      c = f64x4{coeff[l[0], i, j], coeff[l[1], i, j], coeff[l[2], i, j],
+                coeff[l[3], i, j]};
+    }
+  };
+
+  const double vfac = (2.0 * dna) / t1;
+  for (int i = 0; i < kComp; ++i) {
+    f64x4 c, p{}, v{};
+    for (int j = n - 1; j >= 0; --j) {
+      lanes(i, j, c);
+      p += pc[j] * c;
+      if (j >= 1) v += vc[j] * c;
+    }
+    v = v * vfac;
+    for (int k = 0; k < 4; ++k) {
+      position[k][i] = p[k];
+      velocity[k][i] = v[k];
+    }
+  }
+}
+
+// The second derivative of interpolate()'s series, in t1's units, into
+// `acceleration`, from the basis T_j'' = 2 tc T_{j-1}'' + 4 T_{j-1}' - T_{j-2}''.
+// Only state_pva() runs it, so it keeps to the generic runtime-`ncf` form.
+template <class C>
+void interpolate_acceleration(const C* buf, double t0, double t1, int ncf,
+                              int na, double acceleration[3]) {
+  using Extents = std::extents<std::size_t, std::dynamic_extent, 3,
+                               std::dynamic_extent>;
+  const std::mdspan<const C, Extents> coeff(
+      buf, Extents(static_cast<std::size_t>(na), static_cast<std::size_t>(ncf)));
+
+  const double dna = static_cast<double>(na);
+  const double dt1 = static_cast<double>(static_cast<long>(t0));
+  const double temp = dna * t0;
+  const long l = static_cast<long>(temp - dt1);
+  const double tc = 2.0 * (std::fmod(temp, 1.0) + dt1) - 1.0;
+  const double twot = tc + tc;
+
+  std::array<double, kMaxCoeff> pc{}, vc{}, ac{};
+  pc[0] = 1.0;
+  pc[1] = tc;
+  vc[1] = 1.0;
+  for (int i = 2; i < ncf; ++i) {
+    pc[i] = twot * pc[i - 1] - pc[i - 2];
+    vc[i] = twot * vc[i - 1] + 2.0 * pc[i - 1] - vc[i - 2];
+    ac[i] = twot * ac[i - 1] + 4.0 * vc[i - 1] - ac[i - 2];
+  }
+
+  const double vfac = (2.0 * dna) / t1;
+  for (int i = 0; i < 3; ++i) {
+    double sa = 0.0;
+    for (int j = ncf - 1; j >= 2; --j) sa += ac[j] * coeff[l, i, j];
+    acceleration[i] = sa * vfac * vfac;
+  }
+}
+
+// The kernels of one group, picked once at open() from its coefficient count,
+// for coefficients stored as C.
+template <class C>
+struct GroupKernels {
+  using Single = void (*)(const C*, double, double, int, int, double*, double*);
+  using Batch = void (*)(const C*, const double*, double, int, int,
+                         double (*)[3], double (*)[3]);
+  Single state;
+  Single position;
+  Batch batch;
+};
+
+// Specialised for every count up to kMaxSpecialized (DE200..DE441 use 6..14
+// per body, 10 for nutations and librations); anything else -- including a
+// layout this table has never seen -- runs the generic kernels.
+constexpr int kMaxSpecialized = 18;
+
+template <class C, int kNcf>
+constexpr GroupKernels<C> make_kernels() {
+  constexpr int n = (kNcf >= 3) ? kNcf : 0;
+  return {&interpolate<n, true, C>, &interpolate<n, false, C>,
+          &interpolate4<n, C>};
+}
+
+template <class C, std::size_t... N>
+constexpr auto make_kernel_table(std::index_sequence<N...>) {
+  return std::array<GroupKernels<C>, sizeof...(N)>{
+      make_kernels<C, static_cast<int>(N)>()...};
+}
+
+template <class C>
+constexpr auto kKernelTable =
+    make_kernel_table<C>(std::make_index_sequence<kMaxSpecialized + 1>{});
+
+// Kernels for a group of `ncf` coefficients per component and `comps`
+// components; the two-angle nutation group always runs the generic ones.
+template <class C>
+GroupKernels<C> kernels_for(int ncf, int comps) {
+  if (comps == 2)
+    return {&interpolate<0, true, C, 2>, &interpolate<0, false, C, 2>,
+            &interpolate4<0, C, 2>};
+  if (ncf >= 0 && ncf <= kMaxSpecialized)
+    return kKernelTable<C>[static_cast<std::size_t>(ncf)];
+  return kKernelTable<C>[0];
+}
+
+}  // namespace astro::cheb
+
+#endif  // ASTRO_SRC_CHEBYSHEV_HPP
@@ -0,0 +1,152 @@
+#include "codec.hpp"
+
+#include <array>
+#include <bit>
+#include <cstring>
+
+namespace astro::codec {
+
+namespace {
+
+// Exponent difference codes, least significant bit first (s = 1 for a
+// negative difference):
+//   0                  0
+//   10 s               +-1
+//   110 s m            +-(2 + m),  m 1 bit
+//   1110 s mmm         +-(4 + m),  m 3 bits
+//   1111 eeeeeeeeeee   the exponent itself, 11 bits
+// then the sign bit and the 52 mantissa bits.
+constexpr int kMantissaBits = 52;
+constexpr std::uint64_t kMantissaMask = (std::uint64_t{1} << kMantissaBits) - 1;
+
+class BitWriter {
+ public:
+  explicit BitWriter(std::vector<unsigned char>& out) : out_(out) {}
+
+  // `count` <= 56 low bits of `bits`.
+  void put(std::uint64_t bits, int count) {
+    acc_ |= bits << n_;
+    n_ += count;
+    while (n_ >= 8) {
+      out_.push_back(static_cast<unsigned char>(acc_));
+      acc_ >>= 8;
+      n_ -= 8;
+    }
+  }
+
+  void flush() {
+    if (n_ > 0) out_.push_back(static_cast<unsigned char>(acc_));
+    acc_ = 0;
+    n_ = 0;
+  }
+
+ private:
+  std::vector<unsigned char>& out_;
+  std::uint64_t acc_ = 0;
+  int n_ = 0;
+};
+
+// The code starting in the low 8 bits of the stream: its length in bits and
+// the exponent difference, or length 15 for an explicit exponent. One lookup
+// per value keeps the decoder free of data-dependent branches but one.
+struct Code {
+  unsigned char length;
+  signed char delta;
+};
+constexpr std::array<Code, 256> kCodes = [] {
+  std::array<Code, 256> t{};
+  for (unsigned w = 0; w < 256; ++w) {
+    const int ones = std::countr_one(w & 0xfu);
+    const int sign = (w >> (ones + 1) & 1) ? -1 : 1;
+    int length = 15, delta = 0;
+    if (ones == 0) {
+      length = 1;
+    } else if (ones == 1) {
+      length = 3;
+      delta = sign;
+    } else if (ones == 2) {
+      length = 5;
+      delta = sign * (2 + static_cast<int>(w >> 4 & 1));
+    } else if (ones == 3) {
+      length = 8;
+      delta = sign * (4 + static_cast<int>(w >> 5 & 7));
+    }
+    t[w] = {static_cast<unsigned char>(length), static_cast<signed char>(delta)};
+  }
+  return t;
+}();
+
+// At least 57 bits of `in` from bit `bit` on, low bit first.
+std::uint64_t peek(const unsigned char* in, std::uint64_t bit) {
+  std::uint64_t word;
+  std::memcpy(&word, in + (bit >> 3), sizeof word);
+  return word >> (bit & 7);
+}
+
+unsigned exponent(double x) {
+  return static_cast<unsigned>(std::bit_cast<std::uint64_t>(x) >> kMantissaBits) &
+         0x7ffu;
+}
+
+// Exponent reference of value `at` in a block of `doubles`-double records.
+unsigned reference(const double* block, std::size_t at, std::size_t doubles) {
+  if (at >= doubles) return exponent(block[at - doubles]);
+  return at > 0 ? exponent(block[at - 1]) : 0u;
+}
+
+}  // namespace
+
+void encode_block(const double* records, std::size_t n_records,
+                  std::size_t doubles, std::vector<unsigned char>& out) {
+  BitWriter w(out);
+  for (std::size_t at = 0; at < n_records * doubles; ++at) {
+    const auto bits = std::bit_cast<std::uint64_t>(records[at]);
+    const unsigned e = exponent(records[at]);
+    const int d =
+        static_cast<int>(e) - static_cast<int>(reference(records, at, doubles));
+    const std::uint64_t s = d < 0 ? 1 : 0;
+    const unsigned m = static_cast<unsigned>(d < 0 ? -d : d);
+    if (m == 0) {
+      w.put(0b0, 1);
+    } else if (m == 1) {
+      w.put(0b01 | s << 2, 3);
+    } else if (m <= 3) {
+      w.put(0b011 | s << 3 | std::uint64_t{m - 2} << 4, 5);
+    } else if (m <= 11) {
+      w.put(0b0111 | s << 4 | std::uint64_t{m - 4} << 5, 8);
+    } else {
+      w.put(0b1111 | std::uint64_t{e} << 4, 15);
+    }
+    w.put(bits >> 63 | (bits & kMantissaMask) << 1, 1 + kMantissaBits);
+  }
+  w.flush();
+}
+
+bool decode_block(std::span<const unsigned char> in, std::size_t until,
+                  std::size_t doubles, double* out, Cursor& at) {
+  if (in.size() < kPadding) return false;
+  const std::uint64_t limit = (in.size() - kPadding) * 8;
+  const unsigned char* p = in.data();
+  std::uint64_t bit = at.bit;
+  for (std::size_t i = at.record * doubles; i < until * doubles; ++i) {
+    if (bit > limit) return false;
+    std::uint64_t w = peek(p, bit);
+    const Code c = kCodes[w & 0xff];
+    const int e = c.length == 15
+                      ? static_cast<int>(w >> 4 & 0x7ff)
+                      : static_cast<int>(reference(out, i, doubles)) + c.delta;
+    bit += c.length;
+    w = peek(p, bit);
+    bit += 1 + kMantissaBits;
+    const std::uint64_t bits = (w & 1) << 63 |
+                               std::uint64_t{static_cast<unsigned>(e) & 0x7ffu}
+                                   << kMantissaBits |
+                               (w >> 1 & kMantissaMask);
+    out[i] = std::bit_cast<double>(bits);
+  }
+  if (bit > limit) return false;
+  at = {until, bit};
+  return true;
+}
+
+}  // namespace astro::codec
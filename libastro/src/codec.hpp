@@ -0,0 +1,49 @@
+#ifndef ASTRO_SRC_CODEC_HPP
+#define ASTRO_SRC_CODEC_HPP
+
+// Internal: the lossless coefficient codec of compressed ephemeris containers
+// (Ephemeris::write_compressed()).
+//
+// A block is a run of whole data records, coded on its own so any block can be
+// decoded without the others. Each double keeps its sign and 52 mantissa bits
+// verbatim -- Chebyshev coefficients' mantissas are noise, and there is
+// nothing to gain there losslessly -- while its 11-bit exponent is coded as
+// the difference from the exponent of the same slot in the previous record
+// (the block's first record: from the previous slot of the same record). A
+// given body's coefficient of a given degree keeps its magnitude from one
+// record to the next, so the difference is usually 0 or small and costs 1 to
+// 8 bits instead of 11.
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace astro::codec {
+
+// Zero bytes the decoder needs after a block's last byte: it reads 8 bytes at
+// a time and checks bounds once per value.
+inline constexpr std::size_t kPadding = 16;
+
+// Append `n_records` records of `doubles` doubles each, read back to back
+// from `records`, to `out` as one block.
+void encode_block(const double* records, std::size_t n_records,
+                  std::size_t doubles, std::vector<unsigned char>& out);
+
+// How far decoding has got through a block: records done, and the bit they
+// end at.
+struct Cursor {
+  std::size_t record = 0;
+  std::uint64_t bit = 0;
+};
+
+// Decode the block's records from at.record up to (not including) `until`
+// into `out`, which holds the block's records back to back (those before
+// at.record already decoded), and advance `at`. `in` is the block followed
+// by kPadding zero bytes. False if the block ends early.
+bool decode_block(std::span<const unsigned char> in, std::size_t until,
+                  std::size_t doubles, double* out, Cursor& at);
+
+}  // namespace astro::codec
+
+#endif  // ASTRO_SRC_CODEC_HPP
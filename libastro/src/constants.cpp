@@ -0,0 +1,72 @@
+#include "astro/constants.hpp"
+
+#include <mutex>
+#include <utility>
+
+namespace astro {
+
+namespace {
+
+constexpr std::size_t kNameBytes = 6;
+
+// A CNAM entry without its blank (or NUL) padding.
+std::string_view name_at(const std::string& names, std::size_t i) {
+  std::string_view n(names.data() + i * kNameBytes, kNameBytes);
+  while (!n.empty() && (n.back() == ' ' || n.back() == '\0')) n.remove_suffix(1);
+  return n;
+}
+
+}  // namespace
+
+struct Constants::Table {
+  std::once_flag once;
+  std::string names;           // until built
+  std::vector<double> values;  // until built
+  Map map;
+
+  const Map& built() {
+    std::call_once(once, [this] {
+      map.reserve(values.size());
+      for (std::size_t i = 0; i < values.size(); ++i)
+        map.emplace(name_at(names, i), values[i]);
+      names = {};
+      values = {};
+    });
+    return map;
+  }
+};
+
+Constants::Constants(const std::unordered_map<std::string, double>& values)
+    : table_(std::make_shared<Table>()), size_(values.size()) {
+  std::call_once(table_->once, [&] {
+    table_->map.insert(values.begin(), values.end());
+  });
+  for (std::size_t k = 0; k < kHotCount; ++k)
+    if (auto it = values.find(std::string(kHotNames[k])); it != values.end())
+      hot_[k] = it->second;
+}
+
+Constants::Constants(std::string names, std::vector<double> values)
+    : table_(std::make_shared<Table>()), size_(values.size()) {
+  names.resize(values.size() * kNameBytes, ' ');
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    const std::string_view name = name_at(names, i);
+    for (std::size_t k = 0; k < kHotCount; ++k)
+      if (!hot_[k] && name == kHotNames[k]) hot_[k] = values[i];
+  }
+  table_->names = std::move(names);
+  table_->values = std::move(values);
+}
+
+std::optional<double> Constants::get(std::string_view name) const {
+  const Map& map = entries();
+  if (auto it = map.find(name); it != map.end()) return it->second;
+  return std::nullopt;
+}
+
+const Constants::Map& Constants::entries() const {
+  static const Map kEmpty;
+  return table_ ? table_->built() : kEmpty;
+}
+
+}  // namespace astro
@@ -0,0 +1,197 @@
+#include "astro/earth_orientation.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "astro/time.hpp"
+#include "mapped_file.hpp"
+
+namespace astro {
+
+namespace {
+
+constexpr double kMjdZero = 2400000.5;  // JD of MJD 0
+constexpr double kNtpMjd = 15020.0;     // MJD of the NTP epoch, 1900-01-01
+
+// Columns of the IERS "finals" format (0-based offset, width): the Bulletin A
+// pole and UT1 - UTC, each preceded by its I(ERS)/P(rediction) flag, which is
+// blank past the end of the predictions. As read by ephutil/bull_a.c.
+constexpr std::size_t kMjdCol = 7, kMjdWidth = 8;
+constexpr std::size_t kPoleFlagCol = 16;
+constexpr std::size_t kXCol = 18, kYCol = 37, kPoleWidth = 9;
+constexpr std::size_t kUt1FlagCol = 57;
+constexpr std::size_t kUt1Col = 58, kUt1Width = 10;
+
+std::optional<double> number(std::string_view s) {
+  while (!s.empty() && s.front() == ' ') s.remove_prefix(1);
+  while (!s.empty() && (s.back() == ' ' || s.back() == '\r')) s.remove_suffix(1);
+  double v = 0.0;
+  const auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), v);
+  if (s.empty() || ec != std::errc{} || end != s.data() + s.size())
+    return std::nullopt;
+  return v;
+}
+
+// Calls f(line) for each line of `text`, without its terminator.
+template <class F>
+bool for_each_line(std::string_view text, F&& f) {
+  while (!text.empty()) {
+    const std::size_t nl = text.find('\n');
+    const std::string_view line = text.substr(0, nl);
+    if (!f(line)) return false;
+    if (nl == std::string_view::npos) break;
+    text.remove_prefix(nl + 1);
+  }
+  return true;
+}
+
+bool flagged(std::string_view line, std::size_t col) {
+  return line.size() > col && line[col] != ' ';
+}
+
+// A read-only mapping of a whole file (an empty one is bad_header).
+std::expected<io::MappedFile, EphError> map_file(
+    const std::filesystem::path& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return std::unexpected(EphError::file_not_found);
+  io::MappedFile map;
+  const bool mapped = map.map(fd, true);
+  ::close(fd);
+  if (!mapped) return std::unexpected(EphError::bad_header);
+  return map;
+}
+
+std::string_view text(const io::MappedFile& map) {
+  return {map.data(), map.size()};
+}
+
+}  // namespace
+
+std::expected<EarthOrientationTable, EphError> EarthOrientationTable::load(
+    const std::filesystem::path& finals,
+    const std::filesystem::path& leap_seconds) {
+  auto finals_map = map_file(finals);
+  if (!finals_map) return std::unexpected(finals_map.error());
+  if (leap_seconds.empty()) return parse(text(*finals_map));
+  auto leap_map = map_file(leap_seconds);
+  if (!leap_map) return std::unexpected(leap_map.error());
+  return parse(text(*finals_map), text(*leap_map));
+}
+
+std::expected<EarthOrientationTable, EphError> EarthOrientationTable::parse(
+    std::string_view finals, std::string_view leap_seconds) {
+  EarthOrientationTable t;
+
+  // Leap seconds first: the daily UT1 - TAI values need them. Both formats
+  // have '#' comments; Leap_Second.dat lines are "MJD day month year TAI-UTC",
+  // leap-seconds.list lines "NTP-seconds TAI-UTC".
+  const bool leaps_ok = for_each_line(leap_seconds, [&](std::string_view line) {
+    line = line.substr(0, line.find('#'));
+    double field[5];
+    int n = 0;
+    while (true) {
+      const std::size_t b = line.find_first_not_of(" \t\r");
+      if (b == std::string_view::npos) break;
+      line.remove_prefix(b);
+      const std::size_t e = std::min(line.find_first_of(" \t\r"), line.size());
+      if (n == 5) return false;
+      const auto v = number(line.substr(0, e));
+      if (!v) return false;
+      field[n++] = *v;
+      line.remove_prefix(e);
+    }
+    if (n == 0) return true;
+    if (n != 2 && n != 5) return false;
+    const double mjd = n == 2 ? field[0] / 86400.0 + kNtpMjd : field[0];
+    const Leap leap{mjd + kMjdZero, field[n - 1]};
+    if (!t.leaps_.empty() && leap.jd_utc <= t.leaps_.back().jd_utc) return false;
+    t.leaps_.push_back(leap);
+    return true;
+  });
+  if (!leaps_ok) return std::unexpected(EphError::bad_header);
+
+  bool malformed = false;
+  for_each_line(finals, [&](std::string_view line) {
+    // Blank flags: no values on this line. Past the data, that is the end.
+    if (!flagged(line, kUt1FlagCol) || !flagged(line, kPoleFlagCol))
+      return t.days_.empty();
+    if (line.size() < kUt1Col + kUt1Width) {
+      malformed = true;
+      return false;
+    }
+    const auto mjd = number(line.substr(kMjdCol, kMjdWidth));
+    const auto x = number(line.substr(kXCol, kPoleWidth));
+    const auto y = number(line.substr(kYCol, kPoleWidth));
+    const auto ut1 = number(line.substr(kUt1Col, kUt1Width));
+    const int day = mjd ? static_cast<int>(*mjd) : 0;
+    // The index is dense: no gaps, no repeats.
+    if (!mjd || !x || !y || !ut1 || *mjd != day ||
+        (!t.days_.empty() && day != t.last_mjd() + 1)) {
+      malformed = true;
+      return false;
+    }
+    if (t.days_.empty()) t.first_mjd_ = day;
+    // TAI - UTC changes only at 0h UTC, so midday is safely inside the day
+    // (0h itself is the day before's; see day_tai_utc()).
+    const double tai_utc = t.leap_at(day + 0.5 + kMjdZero);
+    t.days_.push_back(Day{*ut1 - tai_utc, *x, *y, tai_utc});
+    return true;
+  });
+  if (malformed || t.days_.empty()) return std::unexpected(EphError::bad_header);
+  return t;
+}
+
+bool EarthOrientationTable::covers(double jd_utc) const noexcept {
+  const double mjd = jd_utc - kMjdZero;
+  return !days_.empty() && mjd >= first_mjd_ && mjd <= last_mjd();
+}
+
+std::optional<EarthOrientation> EarthOrientationTable::at(
+    double jd_utc) const noexcept {
+  if (!covers(jd_utc)) return std::nullopt;
+  const double mjd = jd_utc - kMjdZero;
+  // The last day has no successor; it is only reachable at f == 0.
+  const std::size_t i = std::min(static_cast<std::size_t>(mjd - first_mjd_),
+                                 days_.size() - 1);
+  const double f = mjd - (first_mjd_ + static_cast<double>(i));
+  const Day& a = days_[i];
+  const Day& b = days_[std::min(i + 1, days_.size() - 1)];
+  EarthOrientation eo;
+  eo.ut1_utc =
+      a.ut1_tai + f * (b.ut1_tai - a.ut1_tai) + day_tai_utc(i, f, jd_utc);
+  eo.pole.x_arcsec = a.x_arcsec + f * (b.x_arcsec - a.x_arcsec);
+  eo.pole.y_arcsec = a.y_arcsec + f * (b.y_arcsec - a.y_arcsec);
+  return eo;
+}
+
+double EarthOrientationTable::tai_minus_utc(double jd_utc) const noexcept {
+  if (covers(jd_utc)) {
+    const double mjd = jd_utc - kMjdZero;
+    const std::size_t i = std::min(static_cast<std::size_t>(mjd - first_mjd_),
+                                   days_.size() - 1);
+    return day_tai_utc(i, mjd - (first_mjd_ + static_cast<double>(i)), jd_utc);
+  }
+  return leap_at(jd_utc);
+}
+
+double EarthOrientationTable::day_tai_utc(std::size_t i, double f,
+                                          double jd_utc) const noexcept {
+  if (f > 0.0) return days_[i].tai_utc;
+  return i > 0 ? days_[i - 1].tai_utc : leap_at(jd_utc);
+}
+
+double EarthOrientationTable::leap_at(double jd_utc) const noexcept {
+  if (leaps_.empty()) return astro::tai_minus_utc(jd_utc);
+  // The last entry strictly before `jd_utc`, as the built-in table; before
+  // the first, the first value.
+  const auto next = std::lower_bound(
+      leaps_.begin(), leaps_.end(), jd_utc,
+      [](const Leap& l, double jd) { return l.jd_utc < jd; });
+  return next == leaps_.begin() ? next->tai_utc : std::prev(next)->tai_utc;
+}
+
+}  // namespace astro
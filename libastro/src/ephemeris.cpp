@@ -1,23 +1,29 @@
 #include "astro/ephemeris.hpp"
 
+#include <algorithm>
 #include <array>
 #include <bit>
 #include <cmath>
+#include <cerrno>
 #include <cstdint>
-#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <numeric>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
-// std::mdspan: native <mdspan> when the toolchain ships it, else the vendored
-// Kokkos reference impl (its <experimental/mdspan> exposes std::mdspan). See
-// cmake/mdspan.cmake.
-#if defined(LIBASTRO_NATIVE_MDSPAN)
-#  include <mdspan>
-#else
-#  include <experimental/mdspan>
-#endif
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "astro/tdb_table.hpp"
+#include "async_read.hpp"
+#include "chebyshev.hpp"
+#include "codec.hpp"
+#include "mapped_file.hpp"
 
 // Layer 0 implementation. `open()` parses record 1; `state()` reproduces
 // eph_manager.c's planet_ephemeris/state/interpolate (research doc 1.4, 1.5),
@@ -35,34 +41,106 @@ namespace astro {
 
 namespace {
 
+using cheb::GroupKernels;
+using cheb::interpolate_acceleration;
+using cheb::kernels_for;
+using cheb::kMaxCoeff;
+using io::FileHandle;
+using io::MappedFile;
+using io::PartialFile;
+
 // Header field sizes, in the on-disk order eph_manager.c reads them.
 constexpr std::size_t kTtlBytes = 3 * 84;    // 252
 constexpr std::size_t kCnamBytes = 400 * 6;  // 2400
+// Byte offsets of the fields write_subset() rewrites, and the end of the fixed
+// part of record 1 (CNAM2 follows when NCON > 400).
+constexpr std::size_t kSsOffset = kTtlBytes + kCnamBytes;           // 2652
+constexpr std::size_t kIptOffset = kSsOffset + 24 + 4 + 8 + 8;      // 2696
+constexpr std::size_t kLptOffset = kIptOffset + 12 * 3 * 4 + 4;    // 2844
+constexpr std::size_t kHeaderBytes = kLptOffset + 3 * 4;            // 2856
+
+// write_compressed() container, little-endian: this preamble, records 1 and 2
+// of the DE file verbatim, the data records in codec blocks (src/codec.hpp) of
+// `block_records` each (the last may be shorter), the u64 file offset of every
+// block plus the end of the last, and finally the u64 file offset of that
+// index.
+constexpr char kPackedMagic[8] = {'A', 'S', 'T', 'R', 'O', 'D', 'E', 'Z'};
+constexpr std::uint32_t kPackedVersion = 1;
+constexpr std::uint32_t kPackedBlockRecords = 8;
+struct PackedPreamble {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t block_records;
+  std::uint64_t record_length;  // of the DE file, bytes
+  std::uint64_t record_count;   // of the DE file, records 1 and 2 included
+};
+static_assert(sizeof(PackedPreamble) == 32);
 
-std::size_t record_length_for_denum(int denum) {
+// The DE numbers eph_manager.c knows (its record-length table: 6608 bytes for
+// DE200, 5824 for DE404/406, 8144 for the rest).
+bool supported_denum(int denum) {
   switch (denum) {
     case 200:
-      return 6608;
-    case 403: case 405: case 421:
+    case 403: case 404: case 405: case 406: case 421:
     case 430: case 431: case 440: case 441:
-      return 8144;
-    case 404: case 406:
-      return 5824;
+      return true;
     default:
-      return 0;  // unsupported
+      return false;
   }
 }
 
+// Components per group: nutations (group 12, index 11) carry two angles,
+// every other group three coordinates.
+constexpr int components(std::size_t g) { return g == 11 ? 2 : 3; }
+
+// Record length in bytes: where the last coefficient block ends (JPL's
+// NCOEFF), widened only if record 1's header or record 2's NCON constants
+// would not fit -- which happens just for a trimmed write_subset() file. For
+// every stock DE file this reproduces eph_manager.c's per-DE table.
+std::size_t record_length_for(const std::array<GroupLayout, 13>& groups,
+                              int ncon) {
+  std::size_t doubles = 2;  // the record's own [jd_start, jd_end]
+  for (std::size_t g = 0; g < groups.size(); ++g) {
+    const GroupLayout& l = groups[g];
+    if (l.n_coeff <= 0) continue;
+    doubles = std::max(doubles, static_cast<std::size_t>(
+                                    l.offset - 1 + l.n_coeff * components(g) *
+                                                       l.n_subintervals));
+  }
+  const std::size_t cnam2 = ncon > 400 ? static_cast<std::size_t>(ncon - 400) * 6 : 0;
+  doubles = std::max(doubles, static_cast<std::size_t>(ncon > 0 ? ncon : 0));
+  doubles = std::max(doubles, (kHeaderBytes + cnam2 + 7) / 8);
+  return doubles * sizeof(double);
+}
+
+// Doubles in group `g`'s coefficient block of one record.
+std::size_t block_doubles(const GroupLayout& l, std::size_t g) {
+  return static_cast<std::size_t>(l.n_coeff * components(g) * l.n_subintervals);
+}
+
+// Mark in `keep` the raw groups state() reads for Point `p` as target or
+// center: Earth and the Moon need the EMB (2) and geocentric Moon (9) series,
+// the EMB just the former, the SSB none. False if the file lacks one.
+bool add_groups(const std::array<GroupLayout, 13>& groups, Point p,
+                std::array<bool, 13>& keep) {
+  constexpr int kEarth = 2, kMoon = 9, kSsb = 11, kEmb = 12;
+  auto need = [&](int g) {
+    if (groups[static_cast<std::size_t>(g)].n_coeff <= 0) return false;
+    keep[static_cast<std::size_t>(g)] = true;
+    return true;
+  };
+  const int i = static_cast<int>(p);
+  if (i == kEarth || i == kMoon) return need(kEarth) && need(kMoon);
+  if (i == kEmb) return need(kEarth);
+  return i == kSsb || need(i);
+}
+
 std::string trim(const char* p, std::size_t n) {
   std::size_t end = n;
   while (end > 0 && (p[end - 1] == ' ' || p[end - 1] == '\0')) --end;
   return std::string(p, end);
 }
 
-// Largest coefficient count per component across DE440's groups is 14 (Mercury);
-// this bounds the local Chebyshev basis arrays without heap traffic.
-constexpr int kMaxCoeff = 32;
-
 // Break a double into integer and (non-negative) fractional parts, matching
 // eph_manager.c:split exactly (needed for bit-comparable epoch handling).
 void split(double tt, double fr[2]) {
@@ -73,101 +151,573 @@ void split(double tt, double fr[2]) {
   fr[1] += 1.0;
 }
 
-// Differentiate and interpolate one 3-component body from its Chebyshev block.
-//   buf : first coefficient of the body within the record
-//   t0  : fractional time within the whole record span, [0, 1)
-//   t1  : record span length in output time units (days for AU, s for km)
-//   ncf : coefficients per component;  na : sub-intervals in the record
-// Reproduces eph_manager.c:interpolate; the coefficient block is addressed as a
-// rank-3 std::mdspan with layout [subinterval][component][coeff] (layout_right,
-// stride: coeff=1, component=ncf, subinterval=3*ncf).
-void interpolate(const double* buf, double t0, double t1, int ncf, int na,
-                 double position[3], double velocity[3]) {
-  using Extents =
-      std::extents<std::size_t, std::dynamic_extent, 3, std::dynamic_extent>;
-  const std::mdspan<const double, Extents> coeff(
-      buf, Extents(static_cast<std::size_t>(na),
-                   static_cast<std::size_t>(ncf)));
-
-  const double dna = static_cast<double>(na);
-  const double dt1 = static_cast<double>(static_cast<long>(t0));
-  const double temp = dna * t0;
-  const long l = static_cast<long>(temp - dt1);          // sub-interval index
-  const double tc = 2.0 * (std::fmod(temp, 1.0) + dt1) - 1.0;  // in [-1, 1]
-  const double twot = tc + tc;
-
-  // Chebyshev polynomials T_j(tc).
-  std::array<double, kMaxCoeff> pc{};
-  pc[0] = 1.0;
-  pc[1] = tc;
-  for (int i = 2; i < ncf; ++i) pc[i] = twot * pc[i - 1] - pc[i - 2];
+// Per-handle cache of whole data records (OpenMode::buffered), evicting the
+// least recently used. Slots live in one contiguous block; recency is an
+// intrusive doubly linked list over slot indices and lookup is a hash on the
+// record number, so hits and misses are O(1) whatever the capacity. The most
+// recent slot is checked first: consecutive state() calls nearly always land in
+// the record the previous one used.
+class RecordCache {
+ public:
+  void reset(std::size_t capacity, std::size_t record_doubles) {
+    capacity_ = capacity > 0 ? capacity : 1;
+    doubles_ = record_doubles;
+    data_.assign(capacity_ * doubles_, 0.0);
+    slots_.assign(capacity_, Slot{});
+    index_.clear();
+    index_.reserve(capacity_);
+    used_ = 0;
+    head_ = tail_ = kNone;
+    stats_ = {};
+  }
 
-  for (int i = 0; i < 3; ++i) {
-    double s = 0.0;
-    for (int j = ncf - 1; j >= 0; --j) s += pc[j] * coeff[l, i, j];
-    position[i] = s;
+  std::size_t capacity() const noexcept { return capacity_; }
+  bool contains(long nr) const { return index_.contains(nr); }
+  const CacheStats& stats() const noexcept { return stats_; }
+  CacheStats& mutable_stats() noexcept { return stats_; }
+  void reset_stats() noexcept { stats_ = {}; }
+
+  // Record `nr`, calling `load(dst)` to fill a slot on a miss. nullptr if the
+  // load fails; the slot it was given is then left empty.
+  template <class Load>
+  const double* get(long nr, Load&& load) {
+    if (head_ != kNone && slots_[head_].record == nr) {
+      ++stats_.hits;
+      return slot_data(head_);
+    }
+    if (auto it = index_.find(nr); it != index_.end()) {
+      ++stats_.hits;
+      touch(it->second);
+      return slot_data(it->second);
+    }
+
+    ++stats_.misses;
+    std::size_t slot;
+    if (used_ < capacity_) {
+      slot = used_++;
+    } else {
+      slot = tail_;
+      if (slots_[slot].record >= 0) {
+        index_.erase(slots_[slot].record);
+        ++stats_.evictions;
+      }
+    }
+    slots_[slot].record = -1;
+    touch(slot);
+
+    double* dst = slot_data(slot);
+    if (!load(dst)) {
+      // Empty slot goes to the back so the next miss reuses it first.
+      unlink(slot);
+      push_back(slot);
+      return nullptr;
+    }
+    stats_.bytes_read += doubles_ * sizeof(double);
+    slots_[slot].record = nr;
+    index_.emplace(nr, slot);
+    return dst;
+  }
+
+ private:
+  static constexpr std::size_t kNone = static_cast<std::size_t>(-1);
+
+  struct Slot {
+    long record = -1;
+    std::size_t prev = kNone;
+    std::size_t next = kNone;
+  };
+
+  double* slot_data(std::size_t i) { return data_.data() + i * doubles_; }
+
+  void unlink(std::size_t i) {
+    Slot& s = slots_[i];
+    if (s.prev != kNone) slots_[s.prev].next = s.next;
+    else if (head_ == i) head_ = s.next;
+    if (s.next != kNone) slots_[s.next].prev = s.prev;
+    else if (tail_ == i) tail_ = s.prev;
+    s.prev = s.next = kNone;
+  }
+
+  void push_back(std::size_t i) {
+    slots_[i].prev = tail_;
+    if (tail_ != kNone) slots_[tail_].next = i;
+    tail_ = i;
+    if (head_ == kNone) head_ = i;
+  }
+
+  // Move slot `i` to the most-recently-used end.
+  void touch(std::size_t i) {
+    if (head_ == i) return;
+    unlink(i);
+    slots_[i].next = head_;
+    if (head_ != kNone) slots_[head_].prev = i;
+    head_ = i;
+    if (tail_ == kNone) tail_ = i;
+  }
+
+  std::size_t capacity_ = 0;
+  std::size_t doubles_ = 0;
+  std::vector<double> data_;
+  std::vector<Slot> slots_;
+  std::unordered_map<long, std::size_t> index_;
+  std::size_t used_ = 0;
+  std::size_t head_ = kNone;  // most recently used
+  std::size_t tail_ = kNone;  // least recently used
+  CacheStats stats_;
+};
+
+// The block of a compressed container a caller last read from, decoded as
+// far as the furthest record it wanted: reading a block's records in turn
+// decodes each once, and a lone record costs only the records before it.
+struct BlockMemo {
+  long block = -1;
+  std::vector<unsigned char> bytes;  // the block, then codec::kPadding zeros
+  std::vector<double> records;
+  codec::Cursor at;
+};
+
+// What open() establishes: the file (descriptor or mapping), header and
+// constants. Immutable afterwards and shared by every handle() of an
+// ephemeris, so N handles cost one open file and one parse.
+struct Source {
+  FileHandle file;     // OpenMode::buffered
+  MappedFile mapping;  // OpenMode::mapped
+  Header header;
+  Constants constants;
+  std::array<GroupKernels<double>, 13> kernels{};  // per group, from groups
+
+  // Precision::float32: every data record (record 3 on) as float, back to
+  // back, with the kernels that read them and each group's error bound.
+  Precision precision = Precision::full;
+  std::vector<float> reduced;
+  std::array<GroupKernels<float>, 13> kernels32{};
+  std::array<double, 13> error_bound{};  // km; radians for groups 12, 13
+
+  NutationSource nutation = NutationSource::series;  // for place() et al.
+  NutationEvaluator nutation_evaluator = NutationEvaluator::exact;
+
+  // OpenOptions::transposed: per raw group, its block from every data record
+  // back to back (record 3's first), or empty for a group left in the records.
+  std::array<std::vector<double>, 13> transposed{};
+
+  // A write_compressed() container: records 1 and 2 are at `packed_base`,
+  // block b of the data records at [block_offsets[b], block_offsets[b + 1]).
+  bool packed = false;
+  std::uint64_t packed_base = 0;
+  std::size_t block_records = 0;
+  std::vector<std::uint64_t> block_offsets;
+
+  // Data record `nr` (1-based, 3 on) of a container, decoded through `memo`.
+  bool unpack_record(double* dst, long nr, BlockMemo& memo) const {
+    const std::size_t doubles = header.record_length / sizeof(double);
+    const std::size_t data = header.record_count - 2;
+    const auto i = static_cast<std::size_t>(nr - 3);
+    if (nr < 3 || i >= data) return false;
+    const auto block = static_cast<long>(i / block_records);
+    const std::size_t first = static_cast<std::size_t>(block) * block_records;
+    const std::size_t n = std::min(block_records, data - first);
+    if (memo.block != block) {
+      memo.block = -1;
+      const std::uint64_t begin = block_offsets[static_cast<std::size_t>(block)];
+      const auto size = static_cast<std::size_t>(
+          block_offsets[static_cast<std::size_t>(block) + 1] - begin);
+      memo.bytes.assign(size + codec::kPadding, 0);
+      if (!file.read_at(memo.bytes.data(), size, begin)) return false;
+      memo.records.resize(n * doubles);
+      memo.at = {};
+      memo.block = block;
+    }
+    const std::size_t k = i - first;
+    if (k >= memo.at.record &&
+        !codec::decode_block(memo.bytes, k + 1, doubles, memo.records.data(),
+                             memo.at)) {
+      memo.block = -1;
+      return false;
+    }
+    std::copy_n(memo.records.data() + k * doubles, doubles, dst);
+    return true;
+  }
+
+  // The file offsets holding records [first, last] (1-based): whole blocks
+  // for a container, else the records themselves.
+  std::pair<std::uint64_t, std::uint64_t> extent(long first, long last) const {
+    const auto reclen = static_cast<std::uint64_t>(header.record_length);
+    if (!packed)
+      return {static_cast<std::uint64_t>(first - 1) * reclen,
+              static_cast<std::uint64_t>(last - first + 1) * reclen};
+    auto block = [&](long nr) {
+      return static_cast<std::size_t>(std::max(nr - 3, 0L)) / block_records;
+    };
+    const std::size_t b0 = block(first);
+    const std::size_t b1 = std::min(block(last) + 1, block_offsets.size() - 1);
+    return {block_offsets[b0], block_offsets[b1] - block_offsets[b0]};
+  }
+
+  // `n` bytes at offset `offset` of the DE file, from whichever of
+  // file/mapping is open (decoding a container's records), bypassing any
+  // record cache (write_subset(), the float32 and transposed loads).
+  bool read_raw(void* dst, std::size_t n, std::uint64_t offset) const {
+    if (packed) {
+      const std::uint64_t reclen = header.record_length;
+      auto* out = static_cast<char*>(dst);
+      BlockMemo memo;
+      std::vector<double> rec(reclen / sizeof(double));
+      while (n > 0) {
+        const std::uint64_t r = offset / reclen;  // 0-based record
+        const std::uint64_t within = offset % reclen;
+        const auto take =
+            static_cast<std::size_t>(std::min<std::uint64_t>(n, reclen - within));
+        if (r < 2) {
+          if (!file.read_at(out, take, packed_base + offset)) return false;
+        } else {
+          if (!unpack_record(rec.data(), static_cast<long>(r + 1), memo))
+            return false;
+          std::memcpy(out, reinterpret_cast<const char*>(rec.data()) + within, take);
+        }
+        out += take;
+        n -= take;
+        offset += take;
+      }
+      return true;
+    }
+    if (!mapping.data()) return file.read_at(dst, n, offset);
+    if (offset > mapping.size() || n > mapping.size() - offset) return false;
+    std::memcpy(dst, mapping.data() + offset, n);
+    return true;
+  }
+};
+
+// Precision::float32: read every data record, keep it as float, and note per
+// group the largest position error the rounding can cause. |T_j| <= 1 on
+// [-1, 1], so a component is off by at most the sum of its coefficients'
+// rounding errors; the bound is the norm of those sums over the components,
+// maximised over every sub-interval of every record.
+bool load_reduced(Source& s) {
+  const Header& h = s.header;
+  const std::size_t reclen = h.record_length;
+  const std::size_t doubles = reclen / sizeof(double);
+  const std::size_t records = h.record_count > 2 ? h.record_count - 2 : 0;
+  s.reduced.resize(records * doubles);
+
+  constexpr std::size_t kChunk = 64;  // records per read
+  std::vector<double> buf(kChunk * doubles);
+  for (std::size_t first = 0; first < records; first += kChunk) {
+    const std::size_t n = std::min(kChunk, records - first);
+    if (!s.read_raw(buf.data(), n * reclen, (first + 2) * reclen)) return false;
+    for (std::size_t r = 0; r < n; ++r) {
+      const double* in = buf.data() + r * doubles;
+      float* out = s.reduced.data() + (first + r) * doubles;
+      for (std::size_t i = 0; i < doubles; ++i) out[i] = static_cast<float>(in[i]);
+
+      for (std::size_t g = 0; g < h.groups.size(); ++g) {
+        const GroupLayout& l = h.groups[g];
+        const int nc = components(g);
+        for (int sub = 0; sub < l.n_subintervals; ++sub) {
+          double sq = 0.0;
+          for (int c = 0; c < nc; ++c) {
+            const auto at = static_cast<std::size_t>(
+                l.offset - 1 + (sub * nc + c) * l.n_coeff);
+            double e = 0.0;
+            for (std::size_t j = at; j < at + static_cast<std::size_t>(l.n_coeff); ++j)
+              e += std::abs(in[j] - static_cast<double>(out[j]));
+            sq += e * e;
+          }
+          s.error_bound[g] = std::max(s.error_bound[g], std::sqrt(sq));
+        }
+      }
+    }
+  }
+
+  for (std::size_t g = 0; g < h.groups.size(); ++g)
+    s.kernels32[g] = kernels_for<float>(h.groups[g].n_coeff, components(g));
+  s.precision = Precision::float32;
+  return true;
+}
+
+// OpenOptions::transposed: one pass over the data records, copying each
+// `groups` block into that group's stream.
+bool load_transposed(Source& s, const std::array<bool, 13>& groups) {
+  const Header& h = s.header;
+  const std::size_t reclen = h.record_length;
+  const std::size_t doubles = reclen / sizeof(double);
+  const std::size_t records = h.record_count > 2 ? h.record_count - 2 : 0;
+  for (std::size_t g = 0; g < groups.size(); ++g)
+    if (groups[g]) s.transposed[g].resize(records * block_doubles(h.groups[g], g));
+
+  constexpr std::size_t kChunk = 64;  // records per read
+  std::vector<double> buf(kChunk * doubles);
+  for (std::size_t first = 0; first < records; first += kChunk) {
+    const std::size_t n = std::min(kChunk, records - first);
+    if (!s.read_raw(buf.data(), n * reclen, (first + 2) * reclen)) return false;
+    for (std::size_t g = 0; g < groups.size(); ++g) {
+      if (!groups[g]) continue;
+      const std::size_t len = block_doubles(h.groups[g], g);
+      const auto at = static_cast<std::size_t>(h.groups[g].offset - 1);
+      for (std::size_t r = 0; r < n; ++r)
+        std::copy_n(buf.data() + r * doubles + at, len,
+                    s.transposed[g].data() + (first + r) * len);
+    }
+  }
+  return true;
+}
+
+// Port of eph_manager.c:planet_ephemeris: `tgt` relative to `ctr` (Point
+// numbering) from raw group states supplied by `read(body, pos, vel)`.
+// Shared by state() and state_many() so both produce identical bits.
+template <class Read>
+std::expected<StateVector, EphError> assemble(int tgt, int ctr, Units units,
+                                              double earth_moon_ratio,
+                                              Read&& read) {
+  if (tgt == ctr) return StateVector{{}, {}, units};
+
+  // Point numbering matches the raw state numbering except that index 2
+  // denotes Earth (raw group 2 is the Earth-Moon barycenter) and 9 denotes the
+  // geocentric Moon; both are reconstructed via EMRAT below (research doc 1.5).
+  // 11 = SSB, 12 = EMB.
+  constexpr int kEarth = 2, kMoon = 9, kSsb = 11, kEmb = 12;
+
+  const bool do_moon = (tgt == kEarth) || (ctr == kEarth);
+  const bool do_earth =
+      (tgt == kMoon) || (ctr == kMoon) || (tgt == kEmb) || (ctr == kEmb);
+
+  double pos_earth[3] = {}, vel_earth[3] = {};  // raw group 2 == EMB
+  double pos_moon[3] = {}, vel_moon[3] = {};     // raw group 9 == geocentric Moon
+
+  if (do_earth) {
+    if (auto r = read(kEarth, pos_earth, vel_earth); !r)
+      return std::unexpected(r.error());
+  }
+  if (do_moon) {
+    if (auto r = read(kMoon, pos_moon, vel_moon); !r)
+      return std::unexpected(r.error());
+  }
+
+  double tp[3] = {}, tv[3] = {}, cp[3] = {}, cv[3] = {};
+
+  if (tgt == kSsb) {
+    // barycenter -> zero state
+  } else if (tgt == kEmb) {
+    for (int i = 0; i < 3; ++i) { tp[i] = pos_earth[i]; tv[i] = vel_earth[i]; }
+  } else if (auto r = read(tgt, tp, tv); !r) {
+    return std::unexpected(r.error());
+  }
+
+  if (ctr == kSsb) {
+    // barycenter -> zero state
+  } else if (ctr == kEmb) {
+    for (int i = 0; i < 3; ++i) { cp[i] = pos_earth[i]; cv[i] = vel_earth[i]; }
+  } else if (auto r = read(ctr, cp, cv); !r) {
+    return std::unexpected(r.error());
   }
 
-  // Derivative basis dT_j/dtc.
-  std::array<double, kMaxCoeff> vc{};
-  vc[0] = 0.0;
-  vc[1] = 1.0;
-  vc[2] = 2.0 * twot;
-  for (int i = 3; i < ncf; ++i)
-    vc[i] = twot * vc[i - 1] + 2.0 * pc[i - 1] - vc[i - 2];
+  StateVector out;
+  out.units = units;
+
+  // Earth<->Moon direct pairs, then the single-endpoint EMB/Moon corrections.
+  const double emr1 = 1.0 + earth_moon_ratio;
+  if (tgt == kEarth && ctr == kMoon) {
+    for (int i = 0; i < 3; ++i) { out.position[i] = -cp[i]; out.velocity[i] = -cv[i]; }
+    return out;
+  } else if (tgt == kMoon && ctr == kEarth) {
+    for (int i = 0; i < 3; ++i) { out.position[i] = tp[i]; out.velocity[i] = tv[i]; }
+    return out;
+  } else if (tgt == kEarth) {
+    for (int i = 0; i < 3; ++i) { tp[i] -= pos_moon[i] / emr1; tv[i] -= vel_moon[i] / emr1; }
+  } else if (ctr == kEarth) {
+    for (int i = 0; i < 3; ++i) { cp[i] -= pos_moon[i] / emr1; cv[i] -= vel_moon[i] / emr1; }
+  } else if (tgt == kMoon) {
+    for (int i = 0; i < 3; ++i) {
+      tp[i] = (pos_earth[i] - tp[i] / emr1) + tp[i];
+      tv[i] = (vel_earth[i] - tv[i] / emr1) + tv[i];
+    }
+  } else if (ctr == kMoon) {
+    for (int i = 0; i < 3; ++i) {
+      cp[i] = (pos_earth[i] - cp[i] / emr1) + cp[i];
+      cv[i] = (vel_earth[i] - cv[i] / emr1) + cv[i];
+    }
+  }
 
-  const double vfac = (2.0 * dna) / t1;
   for (int i = 0; i < 3; ++i) {
-    double s = 0.0;
-    for (int j = ncf - 1; j >= 1; --j) s += vc[j] * coeff[l, i, j];
-    velocity[i] = s * vfac;
+    out.position[i] = tp[i] - cp[i];
+    out.velocity[i] = tv[i] - cv[i];
   }
+  return out;
 }
 
 }  // namespace
 
 struct Ephemeris::Impl {
-  std::ifstream file;
-  Header header;
-  Constants constants;
-  // Single-record cache (analogue of eph_manager's BUFFER/NRL). Confined to the
-  // instance rather than file-scope; a single Ephemeris is therefore not safe
-  // for concurrent state() calls -- use one instance per thread.
-  std::vector<double> buffer;
-  long cached_record = -1;
-
-  // Load 1-based physical record `nr` into `buffer` (no-op if already cached).
-  bool load_record(long nr) {
-    if (nr == cached_record) return true;
-    const auto rec = static_cast<std::streamoff>(nr - 1) *
-                     static_cast<std::streamoff>(header.record_length);
-    file.clear();
-    file.seekg(rec, std::ios::beg);
-    file.read(reinterpret_cast<char*>(buffer.data()),
-              static_cast<std::streamsize>(header.record_length));
-    if (!file) return false;
-    cached_record = nr;
-    return true;
+  std::shared_ptr<const Source> source;
+
+  // A multi-file ephemeris (open() over several paths) has no `source`; it
+  // forwards each call to one single-file Ephemeris per file, picked through
+  // `routes`: disjoint spans sorted by start, each running up to the next
+  // one's start and served by the earliest-listed file covering it.
+  struct Route {
+    double begin;
+    std::size_t part;
+  };
+  std::vector<Ephemeris> parts;
+  std::vector<Route> routes;
+  std::vector<Header> headers;  // each file's, in the order given
+  Header set_header;            // parts[0]'s, widened to the whole set
+
+  // OpenOptions::tdb = TdbSource::ephemeris: the set's or file's table, shared
+  // by its handles. Null for the series.
+  std::shared_ptr<const TdbTtTable> tdb;
+
+  bool is_set() const noexcept { return !parts.empty(); }
+
+  // The part serving TDB Julian date `jd`, by binary search. Outside every
+  // span this is the part just before (or the first), which then reports
+  // epoch_out_of_range itself.
+  const Ephemeris& route(double jd) const {
+    auto it = std::upper_bound(
+        routes.begin(), routes.end(), jd,
+        [](double x, const Route& r) { return x < r.begin; });
+    return parts[it == routes.begin() ? routes.front().part
+                                      : std::prev(it)->part];
   }
+  const Ephemeris& route(TdbInstant t) const { return route(t.jd.value()); }
+  // This handle's records (a capacity-N generalisation of eph_manager's
+  // BUFFER/NRL) -- the only thing state() mutates, so distinct handles never
+  // share it. A mapped handle leaves it empty and reads the mapping instead.
+  RecordCache cache;
 
-  // Barycentric state of one raw group (state numbering: 0=Mercury..2=EMB..
-  // 9=Moon(geo)..10=Sun) at split TDB `jed`. Mirrors eph_manager.c:state.
-  std::expected<void, EphError> read_state(int body, const double jed[2],
-                                           Units units, double pos[3],
-                                           double vel[3]) {
-    const double ss0 = header.jd_begin;
-    const double ss1 = header.jd_end;
-    const double step = header.days_per_record;
+  // Sweep detection (buffered only): consecutive misses a constant stride
+  // apart -- +1 for a forward table, -1 backwards, larger for apsides()-style
+  // strides -- start read-ahead of the next `readahead` records along it.
+  std::size_t readahead = 0;
+  long last_miss = -1;
+  long stride = 0;
+  int streak = 0;
+  long advised = -1;  // furthest record already hinted along `stride`
 
-    double interval;   // record span in output time units
-    double aufac;      // km -> output length unit
-    if (units == Units::km) {
-      interval = step * 86400.0;
-      aufac = 1.0;
+  // OpenOptions::batch_queue_depth (buffered only; 0 elsewhere), and the
+  // ring or reader threads state_many() batches run on: this handle's own,
+  // set up by its first batch and kept for the next.
+  std::size_t batch_depth = 0;
+  std::unique_ptr<io::ReadQueue> batch_queue;
+
+  // A compressed container's most recently decoded block.
+  BlockMemo unpacked;
+
+  // Hint records [first, last] (1-based, clamped to the file) to the OS.
+  void will_need(long first, long last) const {
+    const Source& src = *source;
+    const auto count = static_cast<long>(src.header.record_count);
+    first = std::max(first, 1L);
+    last = std::min(last, count);
+    if (first > last) return;
+    const auto [offset, n] = src.extent(first, last);
+    if (src.mapping.data())
+      src.mapping.will_need(static_cast<std::size_t>(offset),
+                            static_cast<std::size_t>(n));
+    else
+      src.file.will_need(offset, n);
+  }
+
+  // Called on every cache miss of record `nr`.
+  void on_miss(long nr) {
+    constexpr long kMaxStride = 64;  // records; beyond this it is not a sweep
+    const long d = nr - last_miss;
+    last_miss = nr;
+    if (d != 0 && d == stride) {
+      ++streak;
     } else {
-      interval = step;
-      aufac = 1.0 / header.au_km;
+      stride = d;
+      streak = 1;
+      advised = nr;
+    }
+    if (readahead == 0 || streak < 2 || stride == 0 || stride > kMaxStride ||
+        stride < -kMaxStride)
+      return;
+    // Hint each record not yet hinted, up to `readahead` strides ahead.
+    const long horizon = nr + stride * static_cast<long>(readahead);
+    for (long r = advised + stride; stride > 0 ? r <= horizon : r >= horizon;
+         r += stride) {
+      if (r < 1 || r > static_cast<long>(source->header.record_count)) break;
+      will_need(r, r);
+      ++cache.mutable_stats().prefetched;
+    }
+    advised = stride > 0 ? std::max(advised, horizon) : std::min(advised, horizon);
+  }
+
+  // Coefficients of 1-based physical record `nr`: a view into the mapping, or
+  // a cache slot (read on a miss). nullptr on I/O failure or a record past the
+  // end of the file.
+  const double* record(long nr) {
+    const Source& src = *source;
+    const std::size_t reclen = src.header.record_length;
+    if (src.mapping.data()) {
+      const std::size_t end = static_cast<std::size_t>(nr) * reclen;
+      if (nr < 1 || end > src.mapping.size()) return nullptr;
+      return reinterpret_cast<const double*>(src.mapping.data() + end - reclen);
+    }
+    if (nr < 1) return nullptr;
+    return cache.get(nr, [&](double* dst) {
+      on_miss(nr);
+      if (src.packed) return src.unpack_record(dst, nr, unpacked);
+      return src.file.read_at(dst, reclen,
+                              static_cast<std::uint64_t>(nr - 1) * reclen);
+    });
+  }
+
+  // Coefficients as stored at the source's precision -- a whole record
+  // (coeffs()) or one group's block (block()): exactly one pointer set, or
+  // neither on I/O failure / a record past the end.
+  struct Coeffs {
+    const double* f64 = nullptr;
+    const float* f32 = nullptr;
+    explicit operator bool() const noexcept { return f64 || f32; }
+  };
+  Coeffs coeffs(long nr) {
+    const Source& src = *source;
+    if (src.precision == Precision::full) return {record(nr), nullptr};
+    const std::size_t doubles = src.header.record_length / sizeof(double);
+    const auto i = static_cast<std::size_t>(nr - 3);
+    if (nr < 3 || (i + 1) * doubles > src.reduced.size()) return {};
+    return {nullptr, src.reduced.data() + i * doubles};
+  }
+
+  // Group `body`'s coefficient block in record `nr`. A transposed group
+  // comes from its stream, touching neither the file nor the record cache;
+  // any other from the record, fetched into `rec` on first use, so a caller
+  // reading several groups of one record fetches it once. Empty on I/O
+  // failure or a record past the end.
+  Coeffs block(long nr, int body, Coeffs& rec) {
+    const Source& src = *source;
+    const auto b = static_cast<std::size_t>(body);
+    const GroupLayout& g = src.header.groups[b];
+    if (const std::vector<double>& s = src.transposed[b]; !s.empty()) {
+      const std::size_t len = block_doubles(g, b);
+      const auto i = static_cast<std::size_t>(nr - 3);
+      if (nr < 3 || (i + 1) * len > s.size()) return {};
+      return {s.data() + i * len, nullptr};
     }
+    if (!rec) rec = coeffs(nr);
+    const auto at = static_cast<std::size_t>(g.offset - 1);
+    if (rec.f32) return {nullptr, rec.f32 + at};
+    if (rec.f64) return {rec.f64 + at, nullptr};
+    return {};
+  }
+
+  // Whether raw group `body` has coefficients in this file.
+  bool has(int body) const {
+    return source->header.groups[static_cast<std::size_t>(body)].n_coeff > 0;
+  }
+
+  // Where split TDB `jed` falls: 1-based physical record and fractional time
+  // within its span. Mirrors the epoch handling of eph_manager.c:state.
+  struct Locus {
+    long nr;
+    double t0;
+  };
+  std::expected<Locus, EphError> locate(const double jed[2]) const {
+    const Header& header = source->header;
+    const double ss0 = header.jd_begin;
+    const double ss1 = header.jd_end;
+    const double step = header.days_per_record;
 
     // Resolve the split epoch to an integer day + fraction (eph_manager:state).
     double jd[4];
@@ -185,16 +735,139 @@ struct Ephemeris::Impl {
     if (jd[0] == ss1) nr -= 2;
     const double t0 =
         ((jd[0] - (static_cast<double>(nr - 3) * step + ss0)) + jd[3]) / step;
+    return Locus{nr, t0};
+  }
 
-    if (!load_record(nr)) return std::unexpected(EphError::io_error);
+  // Barycentric state of one raw group (state numbering: 0=Mercury..2=EMB..
+  // 9=Moon(geo)..10=Sun) at time `t0` from its coefficient block `blk`.
+  // kVelocity = false evaluates the position only and leaves `vel` untouched.
+  template <bool kVelocity = true>
+  void eval(Coeffs blk, int body, double t0, Units units, double pos[3],
+            double vel[3]) const {
+    const Header& header = source->header;
+    double interval;   // record span in output time units
+    double aufac;      // km -> output length unit
+    if (units == Units::km) {
+      interval = header.days_per_record * 86400.0;
+      aufac = 1.0;
+    } else {
+      interval = header.days_per_record;
+      aufac = 1.0 / header.au_km;
+    }
 
-    const GroupLayout& g = header.groups[static_cast<std::size_t>(body)];
-    interpolate(&buffer[static_cast<std::size_t>(g.offset - 1)], t0, interval,
-                g.n_coeff, g.n_subintervals, pos, vel);
+    const auto b = static_cast<std::size_t>(body);
+    const GroupLayout& g = header.groups[b];
+    if (blk.f32) {
+      const GroupKernels<float>& k = source->kernels32[b];
+      (kVelocity ? k.state : k.position)(blk.f32, t0, interval, g.n_coeff,
+                                         g.n_subintervals, pos, vel);
+    } else {
+      const GroupKernels<double>& k = source->kernels[b];
+      (kVelocity ? k.state : k.position)(blk.f64, t0, interval, g.n_coeff,
+                                         g.n_subintervals, pos, vel);
+    }
     for (int i = 0; i < 3; ++i) {
       pos[i] *= aufac;
-      vel[i] *= aufac;
+      if constexpr (kVelocity) vel[i] *= aufac;
     }
+  }
+
+  // The acceleration matching eval(blk, body, t0, units, ...).
+  void eval_acceleration(Coeffs blk, int body, double t0, Units units,
+                         double acc[3]) const {
+    const Header& header = source->header;
+    const bool km = units == Units::km;
+    const double interval = header.days_per_record * (km ? 86400.0 : 1.0);
+    const double aufac = km ? 1.0 : 1.0 / header.au_km;
+    const GroupLayout& g = header.groups[static_cast<std::size_t>(body)];
+    if (blk.f32)
+      interpolate_acceleration(blk.f32, t0, interval, g.n_coeff,
+                               g.n_subintervals, acc);
+    else
+      interpolate_acceleration(blk.f64, t0, interval, g.n_coeff,
+                               g.n_subintervals, acc);
+    for (int i = 0; i < 3; ++i) acc[i] *= aufac;
+  }
+
+  // eval() at four epochs of block `blk` (interpolate4), indexed [lane][xyz].
+  void eval4(Coeffs blk, int body, const double t0[4], Units units,
+             double pos[4][3], double vel[4][3]) const {
+    const Header& header = source->header;
+    double interval;
+    double aufac;
+    if (units == Units::km) {
+      interval = header.days_per_record * 86400.0;
+      aufac = 1.0;
+    } else {
+      interval = header.days_per_record;
+      aufac = 1.0 / header.au_km;
+    }
+
+    const auto b = static_cast<std::size_t>(body);
+    const GroupLayout& g = header.groups[b];
+    if (blk.f32)
+      source->kernels32[b].batch(blk.f32, t0, interval, g.n_coeff,
+                                 g.n_subintervals, pos, vel);
+    else
+      source->kernels[b].batch(blk.f64, t0, interval, g.n_coeff,
+                               g.n_subintervals, pos, vel);
+    for (int k = 0; k < 4; ++k) {
+      for (int i = 0; i < 3; ++i) {
+        pos[k][i] *= aufac;
+        vel[k][i] *= aufac;
+      }
+    }
+  }
+
+  // Angle group `body` (11 = nutations, 2 angles; 12 = librations, 3) at
+  // split TDB `jed`: radians and radians/day, as stored (no unit scaling).
+  std::expected<void, EphError> read_angles(int body, const double jed[2],
+                                            double ang[3], double rate[3]) {
+    if (!has(body)) return std::unexpected(EphError::body_not_available);
+    auto at = locate(jed);
+    if (!at) return std::unexpected(at.error());
+    Coeffs rec;
+    const Coeffs blk = block(at->nr, body, rec);
+    if (!blk) return std::unexpected(EphError::io_error);
+    const auto b = static_cast<std::size_t>(body);
+    const GroupLayout& g = source->header.groups[b];
+    const double interval = source->header.days_per_record;
+    if (blk.f32)
+      source->kernels32[b].state(blk.f32, at->t0, interval, g.n_coeff,
+                                 g.n_subintervals, ang, rate);
+    else
+      source->kernels[b].state(blk.f64, at->t0, interval, g.n_coeff,
+                               g.n_subintervals, ang, rate);
+    return {};
+  }
+
+  // eval() at split TDB `jed`, loading its record. Mirrors eph_manager.c:state.
+  template <bool kVelocity = true>
+  std::expected<void, EphError> read_state(int body, const double jed[2],
+                                           Units units, double pos[3],
+                                           double vel[3]) {
+    if (!has(body)) return std::unexpected(EphError::body_not_available);
+    auto at = locate(jed);
+    if (!at) return std::unexpected(at.error());
+    Coeffs rec;
+    const Coeffs blk = block(at->nr, body, rec);
+    if (!blk) return std::unexpected(EphError::io_error);
+    eval<kVelocity>(blk, body, at->t0, units, pos, vel);
+    return {};
+  }
+
+  // read_state() plus the acceleration, from the same record.
+  std::expected<void, EphError> read_state_pva(int body, const double jed[2],
+                                               Units units, double pos[3],
+                                               double vel[3], double acc[3]) {
+    if (!has(body)) return std::unexpected(EphError::body_not_available);
+    auto at = locate(jed);
+    if (!at) return std::unexpected(at.error());
+    Coeffs rec;
+    const Coeffs blk = block(at->nr, body, rec);
+    if (!blk) return std::unexpected(EphError::io_error);
+    eval(blk, body, at->t0, units, pos, vel);
+    eval_acceleration(blk, body, at->t0, units, acc);
     return {};
   }
 };
@@ -205,12 +878,12 @@ Ephemeris& Ephemeris::operator=(Ephemeris&&) noexcept = default;
 Ephemeris::~Ephemeris() = default;
 
 std::expected<Ephemeris, EphError> Ephemeris::open(
-    const std::filesystem::path& path) {
-  Ephemeris eph;
-  Impl& s = *eph.impl_;
+    const std::filesystem::path& path, OpenOptions options) {
+  auto src = std::make_shared<Source>();
+  Source& s = *src;
 
-  s.file.open(path, std::ios::binary);
-  if (!s.file) return std::unexpected(EphError::file_not_found);
+  s.file = FileHandle(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+  if (s.file.get() < 0) return std::unexpected(EphError::file_not_found);
 
   char ttl[kTtlBytes];
   char cnam[kCnamBytes];
@@ -222,9 +895,23 @@ std::expected<Ephemeris, EphError> Ephemeris::open(
   std::int32_t denum;
   std::int32_t lpt[3];
 
+  // A write_compressed() container puts a preamble in front of the DE file's
+  // records 1 and 2; past it, the header reads exactly as from the file.
+  PackedPreamble pre{};
+  if (s.file.read_at(&pre, sizeof pre, 0) &&
+      std::memcmp(pre.magic, kPackedMagic, sizeof pre.magic) == 0) {
+    if (pre.version != kPackedVersion || pre.block_records == 0)
+      return std::unexpected(EphError::bad_header);
+    s.packed = true;
+    s.packed_base = sizeof pre;
+    s.block_records = pre.block_records;
+  }
+
+  std::uint64_t pos = 0;  // sequential cursor over the header
   auto read = [&](void* dst, std::size_t n) {
-    s.file.read(static_cast<char*>(dst), static_cast<std::streamsize>(n));
-    return static_cast<bool>(s.file);
+    if (!s.file.read_at(dst, n, s.packed_base + pos)) return false;
+    pos += n;
+    return true;
   };
 
   if (!read(ttl, sizeof ttl)) return std::unexpected(EphError::bad_header);
@@ -237,8 +924,8 @@ std::expected<Ephemeris, EphError> Ephemeris::open(
   if (!read(&denum, sizeof denum)) return std::unexpected(EphError::bad_header);
   if (!read(lpt, sizeof lpt)) return std::unexpected(EphError::bad_header);
 
-  const std::size_t reclen = record_length_for_denum(denum);
-  if (reclen == 0) return std::unexpected(EphError::unsupported_denum);
+  if (!supported_denum(denum))
+    return std::unexpected(EphError::unsupported_denum);
 
   Header& h = s.header;
   h.title = trim(ttl, 84);  // first of the three 84-char lines
@@ -249,149 +936,807 @@ std::expected<Ephemeris, EphError> Ephemeris::open(
   h.n_constants = ncon;
   h.au_km = au;
   h.earth_moon_ratio = emrat;
-  h.record_length = reclen;
 
   for (int g = 0; g < 12; ++g)
     h.groups[static_cast<std::size_t>(g)] = {ipt[g][0], ipt[g][1], ipt[g][2]};
   h.groups[12] = {lpt[0], lpt[1], lpt[2]};  // librations
 
+  // Pick each group's evaluator now, so state() dispatches without branching
+  // on the layout. A group with no coefficients is absent (DE200 librations,
+  // bodies dropped by write_subset()); counts beyond the kernels' basis arrays
+  // or blocks overlapping the record's dates are not a DE file.
+  for (std::size_t g = 0; g < h.groups.size(); ++g) {
+    const GroupLayout& l = h.groups[g];
+    if (l.n_coeff > kMaxCoeff || l.n_coeff < 0 ||
+        (l.n_coeff > 0 && (l.offset < 3 || l.n_subintervals < 1)))
+      return std::unexpected(EphError::bad_header);
+    s.kernels[g] = kernels_for<double>(l.n_coeff, components(g));
+  }
+
+  if (options.nutation == NutationSource::ephemeris && h.groups[11].n_coeff == 0)
+    return std::unexpected(EphError::body_not_available);
+  s.nutation = options.nutation;
+  s.nutation_evaluator = options.nutation_evaluator;
+
+  std::array<bool, 13> transposed{};
+  for (Point p : options.transposed)
+    if (!add_groups(h.groups, p, transposed))
+      return std::unexpected(EphError::body_not_available);
+
+  const std::size_t reclen = record_length_for(h.groups, ncon);
+  h.record_length = reclen;
+
   std::error_code ec;
   const auto bytes = std::filesystem::file_size(path, ec);
   h.record_count = ec ? 0 : static_cast<std::size_t>(bytes) / reclen;
-
-  s.buffer.resize(reclen / sizeof(double));
+  h.compressed = s.packed;
+  if (s.packed) {
+    // The block index, found through the trailing u64; its offsets must rise
+    // and stay inside the file, or decoding could read anywhere.
+    if (ec || pre.record_length != reclen || pre.record_count < 2 ||
+        bytes < sizeof pre + 8)
+      return std::unexpected(EphError::bad_header);
+    h.record_count = static_cast<std::size_t>(pre.record_count);
+    const std::size_t blocks =
+        (h.record_count - 2 + s.block_records - 1) / s.block_records;
+    std::uint64_t index = 0;
+    if (blocks >= bytes / sizeof index ||
+        !s.file.read_at(&index, sizeof index, bytes - 8) ||
+        index != bytes - 8 - (blocks + 1) * sizeof(std::uint64_t))
+      return std::unexpected(EphError::bad_header);
+    s.block_offsets.resize(blocks + 1);
+    if (!s.file.read_at(s.block_offsets.data(),
+                        s.block_offsets.size() * sizeof(std::uint64_t), index) ||
+        s.block_offsets.front() != s.packed_base + 2 * reclen ||
+        s.block_offsets.back() != index ||
+        !std::ranges::is_sorted(s.block_offsets))
+      return std::unexpected(EphError::bad_header);
+  }
 
   // Named constants (research doc 1.2, 1.6): the first 400 names are in record
   // 1's CNAM; when NCON > 400 the remainder (CNAM2) follows LPT -- which is
-  // exactly where the stream sits now -- and the NCON values start record 2.
+  // exactly where the cursor sits now -- and the NCON values start record 2.
+  // Both are kept raw; Constants builds its map on first use.
   if (ncon > 0) {
-    auto name_at = [](const char* p) {
-      std::size_t n = 6;
-      while (n > 0 && (p[n - 1] == ' ' || p[n - 1] == '\0')) --n;
-      return std::string(p, n);
-    };
-
-    std::vector<std::string> names;
-    names.reserve(static_cast<std::size_t>(ncon));
-    const int n_rec1 = ncon < 400 ? ncon : 400;
-    for (int i = 0; i < n_rec1; ++i) names.push_back(name_at(cnam + i * 6));
-    if (ncon > 400) {
-      std::vector<char> cnam2(static_cast<std::size_t>(ncon - 400) * 6);
-      if (!read(cnam2.data(), cnam2.size()))
+    const auto n = static_cast<std::size_t>(ncon);
+    const std::size_t n_rec1 = std::min<std::size_t>(n, 400);
+    std::string names(cnam, n_rec1 * 6);
+    if (n > 400) {
+      names.resize(n * 6);
+      if (!read(names.data() + n_rec1 * 6, (n - 400) * 6))
         return std::unexpected(EphError::bad_header);
-      for (int i = 0; i < ncon - 400; ++i)
-        names.push_back(name_at(cnam2.data() + i * 6));
     }
 
-    std::vector<double> values(static_cast<std::size_t>(ncon));
-    s.file.clear();
-    s.file.seekg(static_cast<std::streamoff>(reclen), std::ios::beg);
+    std::vector<double> values(n);
+    pos = reclen;
     if (!read(values.data(), values.size() * sizeof(double)))
       return std::unexpected(EphError::bad_header);
+    s.constants = Constants(std::move(names), std::move(values));
+  }
 
-    std::unordered_map<std::string, double> cmap;
-    cmap.reserve(static_cast<std::size_t>(ncon));
-    for (int i = 0; i < ncon; ++i)
-      cmap.emplace(names[static_cast<std::size_t>(i)],
-                   values[static_cast<std::size_t>(i)]);
-    s.constants = Constants(std::move(cmap));
+  // Header and constants are read through the descriptor either way. A
+  // float32 ephemeris then loads every record into memory, keeping the
+  // descriptor only for write_subset(); otherwise the transposed streams are
+  // gathered through it, and a mapped one then drops it and serves every
+  // record from the mapping. A compressed container is never mapped: its
+  // records are decoded into the record cache.
+  if (options.precision == Precision::float32) {
+    if (!load_reduced(s)) return std::unexpected(EphError::io_error);
+  } else {
+    if (std::ranges::find(transposed, true) != transposed.end() &&
+        !load_transposed(s, transposed))
+      return std::unexpected(EphError::io_error);
+    if (options.mode == OpenMode::mapped && !s.packed) {
+      if (!s.mapping.map(s.file.get(), options.populate))
+        return std::unexpected(EphError::io_error);
+      s.file = FileHandle();
+    }
   }
 
+  Ephemeris eph;
+  eph.impl_->source = std::move(src);
+  if ((options.mode == OpenMode::buffered || s.packed) &&
+      options.precision == Precision::full) {
+    eph.impl_->cache.reset(options.cache_records, reclen / sizeof(double));
+    eph.impl_->readahead = options.readahead_records;
+    // Batched reads fetch raw records; a container's must be decoded.
+    eph.impl_->batch_depth = s.packed ? 0 : options.batch_queue_depth;
+  }
+  if (auto r = eph.attach_tdb_table(options); !r)
+    return std::unexpected(r.error());
   return eph;
 }
 
-const Header& Ephemeris::header() const noexcept { return impl_->header; }
-const Constants& Ephemeris::constants() const noexcept {
-  return impl_->constants;
+std::expected<Ephemeris, EphError> Ephemeris::open(
+    std::span<const std::filesystem::path> paths, OpenOptions options) {
+  if (paths.empty()) return std::unexpected(EphError::invalid_argument);
+  if (paths.size() == 1) return open(paths.front(), options);
+
+  Ephemeris set;
+  Impl& s = *set.impl_;
+  // The TDB - TT table spans the set, not each file.
+  OpenOptions part_options = options;
+  part_options.tdb = TdbSource::series;
+  for (const auto& path : paths) {
+    auto part = open(path, part_options);
+    if (!part) return std::unexpected(part.error());
+    s.headers.push_back(part->header());
+    s.parts.push_back(std::move(*part));
+  }
+
+  // Cut the time line at every file's begin and end; each piece goes to the
+  // first file (in the order given) spanning all of it, and runs of pieces
+  // with the same file merge. Pieces no file spans are gaps: they stay with
+  // the route before them, whose file rejects them.
+  std::vector<double> cuts;
+  for (const Header& h : s.headers) {
+    cuts.push_back(h.jd_begin);
+    cuts.push_back(h.jd_end);
+  }
+  std::ranges::sort(cuts);
+  cuts.erase(std::unique(cuts.begin(), cuts.end()), cuts.end());
+  for (std::size_t i = 0; i + 1 < cuts.size(); ++i) {
+    for (std::size_t k = 0; k < s.headers.size(); ++k) {
+      if (s.headers[k].jd_begin > cuts[i] || s.headers[k].jd_end < cuts[i + 1])
+        continue;
+      if (s.routes.empty() || s.routes.back().part != k)
+        s.routes.push_back({cuts[i], k});
+      break;
+    }
+  }
+
+  s.set_header = s.headers.front();
+  s.set_header.jd_begin = cuts.front();
+  s.set_header.jd_end = cuts.back();
+  if (auto r = set.attach_tdb_table(options); !r)
+    return std::unexpected(r.error());
+  return set;
 }
 
-bool Ephemeris::covers(TdbInstant t) const noexcept {
-  const double jd = t.jd.value();
-  return jd >= impl_->header.jd_begin && jd <= impl_->header.jd_end;
+std::expected<void, EphError> Ephemeris::attach_tdb_table(
+    const OpenOptions& options) {
+  if (options.tdb != TdbSource::ephemeris) return {};
+  auto table = options.tdb_cache.empty()
+                   ? TdbTtTable::generate(*this)
+                   : TdbTtTable::cached(*this, options.tdb_cache);
+  if (!table) return std::unexpected(table.error());
+  impl_->tdb = std::make_shared<const TdbTtTable>(std::move(*table));
+  return {};
 }
 
-std::expected<StateVector, EphError> Ephemeris::state(
-    Point target, Point center, TdbInstant t, Units units) const {
-  const int tgt = static_cast<int>(target);
-  const int ctr = static_cast<int>(center);
+Ephemeris Ephemeris::handle() const {
+  Ephemeris h;
+  if (impl_->is_set()) {
+    Impl& s = *h.impl_;
+    for (const Ephemeris& part : impl_->parts) s.parts.push_back(part.handle());
+    s.routes = impl_->routes;
+    s.headers = impl_->headers;
+    s.set_header = impl_->set_header;
+    s.tdb = impl_->tdb;
+    return h;
+  }
+  h.impl_->source = impl_->source;
+  h.impl_->tdb = impl_->tdb;
+  if (!impl_->source->mapping.data() &&
+      impl_->source->precision == Precision::full) {
+    h.impl_->cache.reset(impl_->cache.capacity(),
+                         impl_->source->header.record_length / sizeof(double));
+    h.impl_->readahead = impl_->readahead;
+    h.impl_->batch_depth = impl_->batch_depth;
+  }
+  return h;
+}
 
-  if (tgt == ctr) return StateVector{{}, {}, units};
+void Ephemeris::prefetch(TdbInstant from, TdbInstant to) const noexcept {
+  if (impl_->is_set()) {  // each file overlapping [from, to] clamps itself
+    const auto [lo, hi] = std::minmax(from.jd.value(), to.jd.value());
+    for (const Ephemeris& part : impl_->parts)
+      if (part.header().jd_begin <= hi && part.header().jd_end >= lo)
+        part.prefetch(from, to);
+    return;
+  }
+  if (impl_->source->precision != Precision::full) return;  // all in memory
+  const Header& h = impl_->source->header;
+  auto record_of = [&](TdbInstant t) {
+    const double jd = std::clamp(t.jd.value(), h.jd_begin, h.jd_end);
+    return static_cast<long>((jd - h.jd_begin) / h.days_per_record) + 3;
+  };
+  long first = record_of(from), last = record_of(to);
+  if (first > last) std::swap(first, last);
+  impl_->will_need(first, last);
+  // Mapped handles keep no per-call state, so only buffered ones count it.
+  if (!impl_->source->mapping.data())
+    impl_->cache.mutable_stats().prefetched +=
+        static_cast<std::uint64_t>(last - first + 1);
+}
 
-  const double jed[2] = {t.jd.whole, t.jd.frac};
+std::expected<void, EphError> Ephemeris::write_subset(
+    const std::filesystem::path& out, const SubsetSpec& spec) const {
+  if (impl_->is_set()) {
+    // Records are copied from one file, so the span must lie within one; a
+    // span only the set as a whole covers is refused rather than stitched.
+    if (spec.from.jd.value() > spec.to.jd.value())
+      return std::unexpected(EphError::invalid_argument);
+    for (const Ephemeris& part : impl_->parts)
+      if (part.covers(spec.from) && part.covers(spec.to))
+        return part.write_subset(out, spec);
+    if (covers(spec.from) && covers(spec.to))
+      return std::unexpected(EphError::invalid_argument);
+    return std::unexpected(EphError::epoch_out_of_range);
+  }
+  const Impl& s = *impl_;
+  const Source& src = *s.source;
+  const Header& h = src.header;
 
-  // Port of eph_manager.c:planet_ephemeris. Point numbering matches the raw
-  // state numbering except that index 2 denotes Earth (raw group 2 is the
-  // Earth-Moon barycenter) and 9 denotes the geocentric Moon; both are
-  // reconstructed via EMRAT below (research doc 1.5). 11 = SSB, 12 = EMB.
-  constexpr int kEarth = 2, kMoon = 9, kSsb = 11, kEmb = 12;
+  if (spec.from.jd.value() > spec.to.jd.value())
+    return std::unexpected(EphError::invalid_argument);
 
-  const bool do_moon = (tgt == kEarth) || (ctr == kEarth);
-  const bool do_earth =
-      (tgt == kMoon) || (ctr == kMoon) || (tgt == kEmb) || (ctr == kEmb);
+  // Raw groups to keep (JPL order, as Header::groups).
+  std::array<bool, 13> keep{};
+  auto need = [&](int g) {
+    if (!s.has(g)) return false;
+    keep[static_cast<std::size_t>(g)] = true;
+    return true;
+  };
+  bool ok = true;
+  if (spec.points.empty()) {
+    for (int g = 0; g <= 10; ++g)
+      if (s.has(g)) keep[static_cast<std::size_t>(g)] = true;
+  }
+  for (Point p : spec.points) ok = add_groups(h.groups, p, keep) && ok;
+  if (spec.nutations) ok = need(11) && ok;
+  if (spec.librations) ok = need(12) && ok;
+  if (!ok) return std::unexpected(EphError::body_not_available);
 
-  double pos_earth[3] = {}, vel_earth[3] = {};  // raw group 2 == EMB
-  double pos_moon[3] = {}, vel_moon[3] = {};     // raw group 9 == geocentric Moon
+  // Data records holding [from, to], resolved exactly as state() would so
+  // every epoch in the span lands in a copied record. t == jd_end resolves
+  // to an earlier record past its end (eph_manager's quirk, t0 > 1); copy
+  // through the last record then.
+  const double from[2] = {spec.from.jd.whole, spec.from.jd.frac};
+  const double to[2] = {spec.to.jd.whole, spec.to.jd.frac};
+  auto first = s.locate(from);
+  auto last = s.locate(to);
+  if (!first || !last) return std::unexpected(EphError::epoch_out_of_range);
+  const long nr0 = first->nr;
+  const long nr1 = last->t0 > 1.0 ? static_cast<long>(h.record_count) : last->nr;
+  if (nr1 > static_cast<long>(h.record_count) || nr0 > nr1)
+    return std::unexpected(EphError::epoch_out_of_range);
 
-  Impl& s = *impl_;
-  if (do_earth) {
-    if (auto r = s.read_state(kEarth, jed, units, pos_earth, vel_earth); !r)
-      return std::unexpected(r.error());
+  // Compacted layout: kept blocks packed in JPL order after the record's
+  // dates, dropped groups (0, 0, 0) as for an absent series.
+  std::array<GroupLayout, 13> groups{};
+  int offset = 3;
+  for (std::size_t g = 0; g < groups.size(); ++g) {
+    if (!keep[g]) continue;
+    const GroupLayout& l = h.groups[g];
+    groups[g] = {offset, l.n_coeff, l.n_subintervals};
+    offset += l.n_coeff * components(g) * l.n_subintervals;
   }
-  if (do_moon) {
-    if (auto r = s.read_state(kMoon, jed, units, pos_moon, vel_moon); !r)
-      return std::unexpected(r.error());
+  const std::size_t in_len = h.record_length;
+  const std::size_t out_len = record_length_for(groups, h.n_constants);
+
+  // Record 1: the original header bytes (titles, names, AU, EMRAT, DE number,
+  // CNAM2) with the span, IPT and LPT rewritten.
+  const std::size_t cnam2 =
+      h.n_constants > 400 ? static_cast<std::size_t>(h.n_constants - 400) * 6 : 0;
+  std::vector<char> buf(std::max(in_len, out_len), '\0');
+  if (!src.read_raw(buf.data(), kHeaderBytes + cnam2, 0))
+    return std::unexpected(EphError::io_error);
+  double dates[4];
+  if (!src.read_raw(dates, 2 * sizeof(double),
+                    static_cast<std::uint64_t>(nr0 - 1) * in_len) ||
+      !src.read_raw(dates + 2, 2 * sizeof(double),
+                    static_cast<std::uint64_t>(nr1 - 1) * in_len))
+    return std::unexpected(EphError::io_error);
+  const double ss[3] = {dates[0], dates[3], h.days_per_record};
+  std::memcpy(buf.data() + kSsOffset, ss, sizeof ss);
+  for (std::size_t g = 0; g < groups.size(); ++g) {
+    const std::int32_t triple[3] = {groups[g].offset, groups[g].n_coeff,
+                                    groups[g].n_subintervals};
+    const std::size_t at = g < 12 ? kIptOffset + g * sizeof triple : kLptOffset;
+    std::memcpy(buf.data() + at, triple, sizeof triple);
   }
 
-  double tp[3] = {}, tv[3] = {}, cp[3] = {}, cv[3] = {};
+  PartialFile file(out);
+  if (!file.is_open() || !file.write(buf.data(), out_len))
+    return std::unexpected(EphError::io_error);
 
-  if (tgt == kSsb) {
-    // barycenter -> zero state
-  } else if (tgt == kEmb) {
-    for (int i = 0; i < 3; ++i) { tp[i] = pos_earth[i]; tv[i] = vel_earth[i]; }
-  } else if (auto r = s.read_state(tgt, jed, units, tp, tv); !r) {
-    return std::unexpected(r.error());
+  // Record 2: the NCON constant values.
+  std::fill(buf.begin(), buf.end(), '\0');
+  if (h.n_constants > 0 &&
+      !src.read_raw(buf.data(),
+                    static_cast<std::size_t>(h.n_constants) * sizeof(double),
+                    in_len))
+    return std::unexpected(EphError::io_error);
+  if (!file.write(buf.data(), out_len))
+    return std::unexpected(EphError::io_error);
+
+  // Data records: dates plus the kept blocks, coefficients copied verbatim.
+  std::vector<double> in(in_len / sizeof(double));
+  std::vector<double> rec(out_len / sizeof(double), 0.0);
+  for (long nr = nr0; nr <= nr1; ++nr) {
+    if (!src.read_raw(in.data(), in_len,
+                      static_cast<std::uint64_t>(nr - 1) * in_len))
+      return std::unexpected(EphError::io_error);
+    rec[0] = in[0];
+    rec[1] = in[1];
+    for (std::size_t g = 0; g < groups.size(); ++g) {
+      if (!keep[g]) continue;
+      const GroupLayout& l = h.groups[g];
+      const auto n = static_cast<std::size_t>(l.n_coeff * components(g) *
+                                              l.n_subintervals);
+      std::copy_n(in.data() + (l.offset - 1), n,
+                  rec.data() + (groups[g].offset - 1));
+    }
+    if (!file.write(rec.data(), out_len))
+      return std::unexpected(EphError::io_error);
   }
 
-  if (ctr == kSsb) {
-    // barycenter -> zero state
-  } else if (ctr == kEmb) {
-    for (int i = 0; i < 3; ++i) { cp[i] = pos_earth[i]; cv[i] = vel_earth[i]; }
-  } else if (auto r = s.read_state(ctr, jed, units, cp, cv); !r) {
-    return std::unexpected(r.error());
+  if (!file.commit()) return std::unexpected(EphError::io_error);
+  return {};
+}
+
+std::expected<void, EphError> Ephemeris::write_compressed(
+    const std::filesystem::path& out) const {
+  if (impl_->is_set()) return std::unexpected(EphError::invalid_argument);
+  const Source& src = *impl_->source;
+  const Header& h = src.header;
+  const std::size_t reclen = h.record_length;
+  const std::size_t doubles = reclen / sizeof(double);
+  if (h.record_count < 2) return std::unexpected(EphError::io_error);
+
+  PartialFile file(out);
+  PackedPreamble pre{};
+  std::memcpy(pre.magic, kPackedMagic, sizeof pre.magic);
+  pre.version = kPackedVersion;
+  pre.block_records = kPackedBlockRecords;
+  pre.record_length = reclen;
+  pre.record_count = h.record_count;
+  std::vector<double> recs(kPackedBlockRecords * doubles);
+  if (!file.is_open() || !file.write(&pre, sizeof pre) ||
+      !src.read_raw(recs.data(), 2 * reclen, 0) ||
+      !file.write(recs.data(), 2 * reclen))
+    return std::unexpected(EphError::io_error);
+
+  std::uint64_t at = sizeof pre + 2 * reclen;
+  std::vector<std::uint64_t> index{at};
+  std::vector<unsigned char> bytes;
+  const std::size_t data = h.record_count - 2;
+  for (std::size_t first = 0; first < data; first += kPackedBlockRecords) {
+    const std::size_t n = std::min<std::size_t>(kPackedBlockRecords, data - first);
+    bytes.clear();
+    if (!src.read_raw(recs.data(), n * reclen, (first + 2) * reclen))
+      return std::unexpected(EphError::io_error);
+    codec::encode_block(recs.data(), n, doubles, bytes);
+    if (!file.write(bytes.data(), bytes.size()))
+      return std::unexpected(EphError::io_error);
+    at += bytes.size();
+    index.push_back(at);
   }
+  if (!file.write(index.data(), index.size() * sizeof(std::uint64_t)) ||
+      !file.write(&at, sizeof at) || !file.commit())
+    return std::unexpected(EphError::io_error);
+  return {};
+}
 
-  StateVector out;
-  out.units = units;
+std::expected<StateSnapshot, EphError> Ephemeris::snapshot(
+    TdbInstant t, Units units) const {
+  if (impl_->is_set()) return impl_->route(t).snapshot(t, units);
+  constexpr int kEarth = 2, kMoon = 9, kSun = 10, kEmb = 12;
+  Impl& s = *impl_;
+  const double jed[2] = {t.jd.whole, t.jd.frac};
+  auto at = s.locate(jed);
+  if (!at) return std::unexpected(at.error());
+  Impl::Coeffs rec;
+
+  // Raw groups 0..10 once each (2 = EMB, 9 = geocentric Moon), then the same
+  // EMRAT reconstruction assemble() applies, so every entry matches
+  // state(p, SSB) bit for bit.
+  StateSnapshot snap;
+  for (StateVector& v : snap.barycentric) v.units = units;
+  snap.geocentric_moon.units = units;
+  double pos[kSun + 1][3], vel[kSun + 1][3];
+  for (int b = 0; b <= kSun; ++b) {
+    if (s.has(b)) {
+      const Impl::Coeffs blk = s.block(at->nr, b, rec);
+      if (!blk) return std::unexpected(EphError::io_error);
+      s.eval(blk, b, at->t0, units, pos[b], vel[b]);
+    } else {  // absent from a subset file: NaN, and so is anything built on it
+      for (int i = 0; i < 3; ++i)
+        pos[b][i] = vel[b][i] = std::numeric_limits<double>::quiet_NaN();
+    }
+  }
 
-  // Earth<->Moon direct pairs, then the single-endpoint EMB/Moon corrections.
   const double emr1 = 1.0 + header().earth_moon_ratio;
-  if (tgt == kEarth && ctr == kMoon) {
-    for (int i = 0; i < 3; ++i) { out.position[i] = -cp[i]; out.velocity[i] = -cv[i]; }
-    return out;
-  } else if (tgt == kMoon && ctr == kEarth) {
-    for (int i = 0; i < 3; ++i) { out.position[i] = tp[i]; out.velocity[i] = tv[i]; }
-    return out;
-  } else if (tgt == kEarth) {
-    for (int i = 0; i < 3; ++i) { tp[i] -= pos_moon[i] / emr1; tv[i] -= vel_moon[i] / emr1; }
-  } else if (ctr == kEarth) {
-    for (int i = 0; i < 3; ++i) { cp[i] -= pos_moon[i] / emr1; cv[i] -= vel_moon[i] / emr1; }
-  } else if (tgt == kMoon) {
+  for (int b = 0; b <= kSun; ++b) {
+    StateVector& out = snap.barycentric[static_cast<std::size_t>(b)];
     for (int i = 0; i < 3; ++i) {
-      tp[i] = (pos_earth[i] - tp[i] / emr1) + tp[i];
-      tv[i] = (vel_earth[i] - tv[i] / emr1) + tv[i];
+      out.position[i] = pos[b][i];
+      out.velocity[i] = vel[b][i];
     }
-  } else if (ctr == kMoon) {
+  }
+  StateVector& earth = snap.barycentric[kEarth];
+  StateVector& moon = snap.barycentric[kMoon];
+  StateVector& emb = snap.barycentric[kEmb];
+  for (int i = 0; i < 3; ++i) {
+    snap.geocentric_moon.position[i] = pos[kMoon][i];
+    snap.geocentric_moon.velocity[i] = vel[kMoon][i];
+    emb.position[i] = pos[kEarth][i];
+    emb.velocity[i] = vel[kEarth][i];
+    earth.position[i] = pos[kEarth][i] - pos[kMoon][i] / emr1;
+    earth.velocity[i] = vel[kEarth][i] - vel[kMoon][i] / emr1;
+    moon.position[i] = (pos[kEarth][i] - pos[kMoon][i] / emr1) + pos[kMoon][i];
+    moon.velocity[i] = (vel[kEarth][i] - vel[kMoon][i] / emr1) + vel[kMoon][i];
+  }
+  return snap;  // SSB stays the zero state
+}
+
+StateVector StateSnapshot::relative(Point target, Point center) const noexcept {
+  const StateVector& t = (*this)[target];
+  StateVector out;
+  out.units = t.units;
+  if (target == center) return out;
+  // state() returns the Earth<->Moon pair straight from the geocentric Moon.
+  if (target == Point::moon && center == Point::earth) return geocentric_moon;
+  if (target == Point::earth && center == Point::moon) {
     for (int i = 0; i < 3; ++i) {
-      cp[i] = (pos_earth[i] - cp[i] / emr1) + cp[i];
-      cv[i] = (vel_earth[i] - cv[i] / emr1) + cv[i];
+      out.position[i] = -geocentric_moon.position[i];
+      out.velocity[i] = -geocentric_moon.velocity[i];
     }
+    return out;
   }
-
+  const StateVector& c = (*this)[center];
   for (int i = 0; i < 3; ++i) {
-    out.position[i] = tp[i] - cp[i];
-    out.velocity[i] = tv[i] - cv[i];
+    out.position[i] = t.position[i] - c.position[i];
+    out.velocity[i] = t.velocity[i] - c.velocity[i];
   }
   return out;
 }
 
+Precision Ephemeris::precision() const noexcept {
+  if (impl_->is_set()) return impl_->parts.front().precision();
+  return impl_->source->precision;
+}
+
+double Ephemeris::position_error_bound(Point p) const noexcept {
+  if (impl_->is_set()) {
+    double bound = 0.0;
+    for (const Ephemeris& part : impl_->parts)
+      bound = std::max(bound, part.position_error_bound(p));
+    return bound;
+  }
+  const Source& src = *impl_->source;
+  const auto& e = src.error_bound;
+  const double emr1 = 1.0 + src.header.earth_moon_ratio;
+  switch (p) {
+    case Point::solar_system_barycenter:
+      return 0.0;
+    case Point::earth_moon_barycenter:
+      return e[2];
+    case Point::earth:  // EMB - Moon/(1 + EMRAT)
+      return e[2] + e[9] / emr1;
+    case Point::moon:   // EMB + Moon * EMRAT/(1 + EMRAT)
+      return e[2] + e[9] * (src.header.earth_moon_ratio / emr1);
+    default:
+      return e[static_cast<std::size_t>(p)];
+  }
+}
+
+NutationSource Ephemeris::nutation_source() const noexcept {
+  if (impl_->is_set()) return impl_->parts.front().nutation_source();
+  return impl_->source->nutation;
+}
+
+NutationEvaluator Ephemeris::nutation_evaluator() const noexcept {
+  if (impl_->is_set()) return impl_->parts.front().nutation_evaluator();
+  return impl_->source->nutation_evaluator;
+}
+
+const TdbTtTable& Ephemeris::tdb_table() const noexcept {
+  static const TdbTtTable kSeries;
+  return impl_->tdb ? *impl_->tdb : kSeries;
+}
+
+std::expected<NutationAngles, EphError> Ephemeris::nutation(
+    TdbInstant t) const {
+  if (impl_->is_set()) return impl_->route(t).nutation(t);
+  const double jed[2] = {t.jd.whole, t.jd.frac};
+  double ang[3], rate[3];
+  if (auto r = impl_->read_angles(11, jed, ang, rate); !r)
+    return std::unexpected(r.error());
+  return NutationAngles{ang[0], ang[1], rate[0], rate[1]};
+}
+
+std::expected<LibrationAngles, EphError> Ephemeris::libration(
+    TdbInstant t) const {
+  if (impl_->is_set()) return impl_->route(t).libration(t);
+  const double jed[2] = {t.jd.whole, t.jd.frac};
+  LibrationAngles out;
+  if (auto r = impl_->read_angles(12, jed, out.angles.data(), out.rates.data());
+      !r)
+    return std::unexpected(r.error());
+  return out;
+}
+
+CacheStats Ephemeris::cache_stats() const noexcept {
+  if (!impl_->is_set()) return impl_->cache.stats();
+  CacheStats sum;
+  for (const Ephemeris& part : impl_->parts) {
+    const CacheStats c = part.cache_stats();
+    sum.hits += c.hits;
+    sum.misses += c.misses;
+    sum.evictions += c.evictions;
+    sum.bytes_read += c.bytes_read;
+    sum.prefetched += c.prefetched;
+    sum.batched += c.batched;
+    sum.max_queue_depth = std::max(sum.max_queue_depth, c.max_queue_depth);
+    sum.batch_wait_ns += c.batch_wait_ns;
+    sum.max_batch_wait_ns = std::max(sum.max_batch_wait_ns, c.max_batch_wait_ns);
+  }
+  return sum;
+}
+void Ephemeris::reset_cache_stats() noexcept {
+  impl_->cache.reset_stats();
+  for (Ephemeris& part : impl_->parts) part.reset_cache_stats();
+}
+
+const Header& Ephemeris::header() const noexcept {
+  if (impl_->is_set()) return impl_->set_header;
+  return impl_->source->header;
+}
+const Constants& Ephemeris::constants() const noexcept {
+  if (impl_->is_set()) return impl_->parts.front().constants();
+  return impl_->source->constants;
+}
+
+std::span<const Header> Ephemeris::segments() const noexcept {
+  if (impl_->is_set()) return impl_->headers;
+  return {&impl_->source->header, 1};
+}
+
+bool Ephemeris::covers(TdbInstant t) const noexcept {
+  if (impl_->is_set()) return impl_->route(t).covers(t);
+  const Header& h = impl_->source->header;
+  const double jd = t.jd.value();
+  return jd >= h.jd_begin && jd <= h.jd_end;
+}
+
+std::expected<StateVector, EphError> Ephemeris::state(
+    Point target, Point center, TdbInstant t, Units units) const {
+  if (impl_->is_set()) return impl_->route(t).state(target, center, t, units);
+  const double jed[2] = {t.jd.whole, t.jd.frac};
+  Impl& s = *impl_;
+  return assemble(static_cast<int>(target), static_cast<int>(center), units,
+                  header().earth_moon_ratio,
+                  [&](int body, double pos[3], double vel[3]) {
+                    return s.read_state(body, jed, units, pos, vel);
+                  });
+}
+
+std::expected<PvaState, EphError> Ephemeris::state_pva(
+    Point target, Point center, TdbInstant t, Units units) const {
+  if (impl_->is_set()) return impl_->route(t).state_pva(target, center, t, units);
+  const double jed[2] = {t.jd.whole, t.jd.frac};
+  const int tgt = static_cast<int>(target);
+  const int ctr = static_cast<int>(center);
+  const double emrat = header().earth_moon_ratio;
+  Impl& s = *impl_;
+  std::array<Vec3, 13> acc{};  // per raw group read
+  auto pv = assemble(tgt, ctr, units, emrat,
+                     [&](int body, double pos[3], double vel[3]) {
+                       return s.read_state_pva(
+                           body, jed, units, pos, vel,
+                           acc[static_cast<std::size_t>(body)].data());
+                     });
+  if (!pv) return std::unexpected(pv.error());
+  // The reconstruction treats each vector alike and linearly, so the
+  // accelerations go through it again in the position slot.
+  auto a = assemble(tgt, ctr, units, emrat,
+                    [&](int body, double pos[3], double vel[3]) {
+                      const Vec3& g = acc[static_cast<std::size_t>(body)];
+                      for (int i = 0; i < 3; ++i) {
+                        pos[i] = g[static_cast<std::size_t>(i)];
+                        vel[i] = 0.0;
+                      }
+                      return std::expected<void, EphError>{};
+                    });
+  return PvaState{pv->position, pv->velocity, a->position, units};
+}
+
+std::expected<Vec3, EphError> Ephemeris::position(
+    Point target, Point center, TdbInstant t, Units units) const {
+  if (impl_->is_set())
+    return impl_->route(t).position(target, center, t, units);
+  const double jed[2] = {t.jd.whole, t.jd.frac};
+  Impl& s = *impl_;
+  // Velocities are left at zero and only feed assemble()'s discarded half.
+  auto st = assemble(static_cast<int>(target), static_cast<int>(center), units,
+                     header().earth_moon_ratio,
+                     [&](int body, double pos[3], double vel[3]) {
+                       vel[0] = vel[1] = vel[2] = 0.0;
+                       return s.read_state<false>(body, jed, units, pos, vel);
+                     });
+  if (!st) return std::unexpected(st.error());
+  return st->position;
+}
+
+std::expected<void, EphError> Ephemeris::state_many(
+    Point target, Point center, std::span<const TdbInstant> t,
+    std::span<StateVector> out, Units units) const {
+  if (out.size() != t.size()) return std::unexpected(EphError::invalid_argument);
+  if (impl_->is_set()) {
+    // Split the batch by file (each keeping its epochs' input order), run
+    // each file's share, and scatter the results only once all succeeded.
+    std::vector<std::vector<std::size_t>> share(impl_->parts.size());
+    for (std::size_t i = 0; i < t.size(); ++i)
+      share[static_cast<std::size_t>(&impl_->route(t[i]) -
+                                     impl_->parts.data())].push_back(i);
+    std::vector<StateVector> all(t.size());
+    std::vector<TdbInstant> ts;
+    std::vector<StateVector> res;
+    for (std::size_t k = 0; k < share.size(); ++k) {
+      if (share[k].empty()) continue;
+      ts.clear();
+      for (std::size_t i : share[k]) ts.push_back(t[i]);
+      res.resize(ts.size());
+      auto r = impl_->parts[k].state_many(target, center, ts, res, units);
+      if (!r) return r;
+      for (std::size_t j = 0; j < ts.size(); ++j) all[share[k][j]] = res[j];
+    }
+    std::ranges::copy(all, out.begin());
+    return {};
+  }
+  const int tgt = static_cast<int>(target);
+  const int ctr = static_cast<int>(center);
+  Impl& s = *impl_;
+
+  // Pass 1: resolve every epoch to (record, offset) -- the split()/range work
+  // state() repeats per call -- and reject the batch before writing anything
+  // if one is out of range.
+  std::vector<Impl::Locus> at(t.size());
+  bool sorted = true;
+  for (std::size_t i = 0; i < t.size(); ++i) {
+    const double jed[2] = {t[i].jd.whole, t[i].jd.frac};
+    auto a = s.locate(jed);
+    if (!a) return std::unexpected(a.error());
+    at[i] = *a;
+    if (i > 0 && at[i].nr < at[i - 1].nr) sorted = false;
+  }
+  // Likewise a body the file lacks (a subset), which state() would report.
+  std::array<bool, 13> groups{};
+  if (tgt != ctr && !(add_groups(s.source->header.groups, target, groups) &&
+                      add_groups(s.source->header.groups, center, groups)))
+    return std::unexpected(EphError::body_not_available);
+
+  // Pass 2: visit epochs grouped by record (input order when it is already
+  // non-decreasing, else a stable sort by record), so each record is looked
+  // up once. Epochs of a record go through the kernel four at a time, one per
+  // SIMD lane, and each raw group is interpolated once per four epochs.
+  // Results go to `res` and reach `out` only once every epoch has succeeded,
+  // so a read error part-way leaves `out` as it was.
+  std::vector<StateVector> res(t.size());
+  std::vector<std::size_t> order;
+  if (!sorted) {
+    order.resize(t.size());
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    std::ranges::stable_sort(order, {}, [&](std::size_t i) { return at[i].nr; });
+  }
+  auto visit = [&](std::size_t k) { return sorted ? k : order[k]; };
+
+  // The epochs visit(k0) .. visit(k1 - 1), all in record `nr`. `rec` is the
+  // record if the caller has it, else empty and fetched by the first
+  // non-transposed group that needs it.
+  constexpr int kGroups = 11;  // raw groups state() reads: Mercury..Sun
+  const double emrat = header().earth_moon_ratio;
+  auto evaluate = [&](std::size_t k0, std::size_t k1, long nr,
+                      Impl::Coeffs rec) -> std::expected<void, EphError> {
+    for (std::size_t k = k0; k < k1;) {
+      std::size_t idx[4];
+      double t0[4];
+      int lanes = 0;
+      for (; lanes < 4 && k < k1; ++lanes, ++k) {
+        idx[lanes] = visit(k);
+        t0[lanes] = at[idx[lanes]].t0;
+      }
+      for (int lane = lanes; lane < 4; ++lane) t0[lane] = t0[0];  // padding
+
+      double pos[kGroups][4][3], vel[kGroups][4][3];
+      bool have[kGroups] = {};
+      for (int lane = 0; lane < lanes; ++lane) {
+        auto st = assemble(tgt, ctr, units, emrat,
+                           [&](int body, double p[3], double v[3])
+                               -> std::expected<void, EphError> {
+                             if (!s.has(body))
+                               return std::unexpected(EphError::body_not_available);
+                             if (!have[body]) {
+                               const Impl::Coeffs blk = s.block(nr, body, rec);
+                               if (!blk)
+                                 return std::unexpected(EphError::io_error);
+                               s.eval4(blk, body, t0, units, pos[body], vel[body]);
+                               have[body] = true;
+                             }
+                             for (int i = 0; i < 3; ++i) {
+                               p[i] = pos[body][lane][i];
+                               v[i] = vel[body][lane][i];
+                             }
+                             return {};
+                           });
+        if (!st) return std::unexpected(st.error());
+        res[idx[lane]] = *st;
+      }
+    }
+    return {};
+  };
+
+  // Runs of epochs sharing a record, in visiting order.
+  struct Run {
+    long nr;
+    std::size_t begin, end;
+  };
+  std::vector<Run> runs;
+  for (std::size_t k = 0; k < t.size(); ++k) {
+    const long nr = at[visit(k)].nr;
+    if (runs.empty() || runs.back().nr != nr) runs.push_back({nr, k, k});
+    runs.back().end = k + 1;
+  }
+
+  // Buffered: when two or more of the records the batch reads from the file
+  // are not cached, read them all concurrently into a batch buffer and
+  // evaluate the cached ones, then each of the others as it arrives.
+  std::vector<std::size_t> fetch;  // into runs
+  const Source& src = *s.source;
+  if (s.batch_depth > 0 && !src.mapping.data() &&
+      src.precision == Precision::full) {
+    bool from_records = false;
+    for (std::size_t g = 0; g < groups.size(); ++g)
+      from_records = from_records || (groups[g] && src.transposed[g].empty());
+    for (std::size_t r = 0; from_records && r < runs.size(); ++r)
+      if (!s.cache.contains(runs[r].nr)) fetch.push_back(r);
+  }
+  if (fetch.size() < 2) {
+    for (const Run& r : runs)
+      if (auto e = evaluate(r.begin, r.end, r.nr, {}); !e) return e;
+    std::ranges::copy(res, out.begin());
+    return {};
+  }
+
+  const std::size_t reclen = src.header.record_length;
+  const std::size_t doubles = reclen / sizeof(double);
+  std::vector<double> buf(fetch.size() * doubles);
+  std::vector<io::Read> reads(fetch.size());
+  std::vector<bool> fetched(runs.size());
+  for (std::size_t i = 0; i < fetch.size(); ++i) {
+    reads[i] = {buf.data() + i * doubles, reclen,
+                static_cast<std::uint64_t>(runs[fetch[i]].nr - 1) * reclen};
+    fetched[fetch[i]] = true;
+  }
+  if (!s.batch_queue)
+    s.batch_queue = std::make_unique<io::ReadQueue>(s.batch_depth);
+  io::BatchReader reader(*s.batch_queue, src.file.get(), reads);
+  for (std::size_t r = 0; r < runs.size(); ++r)
+    if (!fetched[r])
+      if (auto e = evaluate(runs[r].begin, runs[r].end, runs[r].nr, {}); !e)
+        return e;
+  while (auto c = reader.next()) {
+    if (!c->ok) return std::unexpected(EphError::io_error);
+    const Run& r = runs[fetch[c->index]];
+    if (auto e = evaluate(r.begin, r.end, r.nr,
+                          {buf.data() + c->index * doubles, nullptr});
+        !e)
+      return e;
+  }
+  std::ranges::copy(res, out.begin());
+
+  const io::BatchStats& b = reader.stats();
+  CacheStats& stats = s.cache.mutable_stats();
+  stats.misses += b.reads;
+  stats.bytes_read += b.reads * reclen;
+  stats.batched += b.reads;
+  stats.max_queue_depth = std::max(stats.max_queue_depth, b.max_in_flight);
+  stats.batch_wait_ns += static_cast<std::uint64_t>(b.total_latency.count());
+  stats.max_batch_wait_ns = std::max(
+      stats.max_batch_wait_ns, static_cast<std::uint64_t>(b.max_latency.count()));
+  return {};
+}
+
 }  // namespace astro
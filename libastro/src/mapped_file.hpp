@@ -0,0 +1,188 @@
+#ifndef ASTRO_SRC_MAPPED_FILE_HPP
+#define ASTRO_SRC_MAPPED_FILE_HPP
+
+// Internal: POSIX file plumbing shared across the library -- an owned
+// descriptor, a write-then-rename output file (write_subset(),
+// write_compressed(), the TDB - TT cache), and a read-only whole-file mapping
+// (the DE reader's OpenMode::mapped, the SPK reader, the EOP table).
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace astro::io {
+
+// Owned POSIX file descriptor. Records are read with pread(), which carries its
+// own offset, so handles sharing one descriptor never race on a seek position.
+class FileHandle {
+ public:
+  FileHandle() = default;
+  explicit FileHandle(int fd) : fd_(fd) {}
+  FileHandle(FileHandle&& o) noexcept : fd_(std::exchange(o.fd_, -1)) {}
+  FileHandle& operator=(FileHandle&& o) noexcept {
+    std::swap(fd_, o.fd_);
+    return *this;
+  }
+  FileHandle(const FileHandle&) = delete;
+  FileHandle& operator=(const FileHandle&) = delete;
+  ~FileHandle() {
+    if (fd_ >= 0) ::close(fd_);
+  }
+
+  int get() const noexcept { return fd_; }
+  int release() noexcept { return std::exchange(fd_, -1); }
+
+  // Read exactly `n` bytes at byte `offset`; false on error or end of file.
+  bool read_at(void* dst, std::size_t n, std::uint64_t offset) const {
+    auto* p = static_cast<char*>(dst);
+    while (n > 0) {
+      const ssize_t r = ::pread(fd_, p, n, static_cast<off_t>(offset));
+      if (r < 0 && errno == EINTR) continue;
+      if (r <= 0) return false;
+      p += r;
+      n -= static_cast<std::size_t>(r);
+      offset += static_cast<std::uint64_t>(r);
+    }
+    return true;
+  }
+
+  // Ask the OS to start reading [offset, offset + n) into the page cache
+  // (asynchronous; a later read_at() of the range then finds it resident).
+  // Advisory: a no-op where posix_fadvise is unavailable (e.g. macOS).
+  void will_need(std::uint64_t offset, std::uint64_t n) const noexcept {
+#if defined(POSIX_FADV_WILLNEED)
+    ::posix_fadvise(fd_, static_cast<off_t>(offset), static_cast<off_t>(n),
+                    POSIX_FADV_WILLNEED);
+#else
+    (void)offset;
+    (void)n;
+#endif
+  }
+
+ private:
+  int fd_ = -1;
+};
+
+// A writer's output file. Bytes go to "<path>.part", which commit() renames
+// over `path`; until then the destructor removes it. So a failed write leaves
+// nothing behind, and `path` may even name the ephemeris being read (its open
+// descriptor or mapping keeps the old file alive).
+class PartialFile {
+ public:
+  explicit PartialFile(std::filesystem::path path)
+      : path_(std::move(path)), part_(path_) {
+    part_ += ".part";
+    file_ = FileHandle(::open(part_.c_str(),
+                              O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+    opened_ = file_.get() >= 0;
+  }
+  PartialFile(const PartialFile&) = delete;
+  PartialFile& operator=(const PartialFile&) = delete;
+  ~PartialFile() {
+    if (opened_ && !committed_) ::unlink(part_.c_str());
+  }
+
+  bool is_open() const noexcept { return opened_; }
+
+  // Append exactly `n` bytes; false on error.
+  bool write(const void* src, std::size_t n) {
+    auto* p = static_cast<const char*>(src);
+    while (n > 0) {
+      const ssize_t w = ::write(file_.get(), p, n);
+      if (w < 0 && errno == EINTR) continue;
+      if (w <= 0) return false;
+      p += w;
+      n -= static_cast<std::size_t>(w);
+    }
+    return true;
+  }
+
+  // Close and move into place. A close() error (e.g. deferred ENOSPC on
+  // some filesystems) fails the commit like a write error would.
+  bool commit() {
+    if (::close(file_.release()) != 0) return false;
+    if (::rename(part_.c_str(), path_.c_str()) != 0) return false;
+    committed_ = true;
+    return true;
+  }
+
+ private:
+  std::filesystem::path path_;
+  std::filesystem::path part_;
+  FileHandle file_;
+  bool opened_ = false;
+  bool committed_ = false;
+};
+
+// Read-only mapping of a whole file (OpenMode::mapped). POSIX mmap; both
+// target platforms provide it. The mapping outlives the descriptor it was
+// made from.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  MappedFile(MappedFile&& o) noexcept
+      : data_(std::exchange(o.data_, nullptr)), size_(std::exchange(o.size_, 0)) {}
+  MappedFile& operator=(MappedFile&& o) noexcept {
+    std::swap(data_, o.data_);
+    std::swap(size_, o.size_);
+    return *this;
+  }
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile() {
+    if (data_) ::munmap(data_, size_);
+  }
+
+  bool map(int fd, bool populate) {
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0) return false;
+    int flags = MAP_PRIVATE;
+#if defined(MAP_POPULATE)
+    if (populate) flags |= MAP_POPULATE;
+#endif
+    void* p = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ,
+                     flags, fd, 0);
+    if (p == MAP_FAILED) return false;
+    data_ = p;
+    size_ = static_cast<std::size_t>(st.st_size);
+#if !defined(MAP_POPULATE)
+    if (populate) {  // no MAP_POPULATE (e.g. macOS): ask, then touch each page
+      ::madvise(data_, size_, MADV_WILLNEED);
+      const long page = ::sysconf(_SC_PAGESIZE);
+      volatile const char* c = static_cast<const char*>(data_);
+      for (std::size_t i = 0; i < size_; i += static_cast<std::size_t>(page))
+        (void)c[i];
+    }
+#endif
+    return true;
+  }
+
+  const char* data() const noexcept { return static_cast<const char*>(data_); }
+  std::size_t size() const noexcept { return size_; }
+
+  // madvise(WILLNEED) over the pages covering [offset, offset + n): the kernel
+  // starts faulting them in so the first touch does not block on I/O.
+  void will_need(std::size_t offset, std::size_t n) const noexcept {
+    if (!data_ || offset >= size_) return;
+    const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    const std::size_t begin = offset / page * page;
+    const std::size_t end = std::min(offset + n, size_);
+    ::madvise(static_cast<char*>(data_) + begin, end - begin, MADV_WILLNEED);
+  }
+
+ private:
+  void* data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+}  // namespace astro::io
+
+#endif  // ASTRO_SRC_MAPPED_FILE_HPP
@@ -1,10 +1,14 @@
 #include "astro/frames.hpp"
 
 #include <cmath>
+#include <cstddef>
+
+#include "simd.hpp"
 
 // IAU 2000 nutation series + fundamental arguments + mean obliquity, ported
 // from NOVAS-C (nutation.c, novas.c). The large coefficient tables are
-// extracted verbatim into nutation_tables.inc by tools/extract_nutation_tables.py.
+// extracted verbatim into nutation_tables.inc by tools/extract_nutation_tables.py,
+// together with the structure-of-arrays copies the vectorized evaluator reads.
 
 namespace astro {
 
@@ -18,8 +22,166 @@ constexpr double kTwoPi = 6.283185307179586476925287;
 
 #include "nutation_tables.inc"
 
+// ---- Vectorized evaluator (NutationEvaluator::vectorized) ----
+//
+// Four terms per step from the *_soa tables: the argument is the same dot
+// product as NOVAS's, left to right, but reduced and passed to simd::sincos()
+// instead of fmod + std::sin + std::cos, and the four lanes are summed
+// separately and added at the end. Both change the rounding, not the model:
+// against the exact loops the angles differ by ~1e-13 arcsec.
+
+void load(const double* p, simd::f64x4& out) noexcept {
+  out = simd::f64x4{p[0], p[1], p[2], p[3]};
+}
+
+double lane_sum(const simd::f64x4& v) noexcept {
+  return (v[0] + v[1]) + (v[2] + v[3]);
+}
+
+// Luni-solar sums of a series (`n` multipliers of the five Delaunay
+// arguments `a`, `c` coefficients), in the tables' units (0.1 uas).
+template <std::size_t N>
+void luni_solar_vectorized(const double (&n)[5][N], const double (&c)[6][N],
+                           const double a[5], double t, double& dp,
+                           double& de) noexcept {
+  using simd::f64x4;
+  f64x4 sp{}, se{};
+  for (std::size_t i = 0; i < N; i += 4) {
+    f64x4 arg, m;
+    load(&n[0][i], m);
+    arg = m * a[0];
+    for (int j = 1; j < 5; ++j) {
+      load(&n[j][i], m);
+      arg += m * a[j];
+    }
+    f64x4 s, co, c0, c1, c2, c3, c4, c5;
+    simd::sincos(arg, s, co);
+    load(&c[0][i], c0);
+    load(&c[1][i], c1);
+    load(&c[2][i], c2);
+    load(&c[3][i], c3);
+    load(&c[4][i], c4);
+    load(&c[5][i], c5);
+    sp += (c0 + c1 * t) * s + c2 * co;
+    se += (c3 + c4 * t) * co + c5 * s;
+  }
+  dp = lane_sum(sp);
+  de = lane_sum(se);
+}
+
+// Planetary sums: `n` multiplies the fourteen arguments `a`.
+template <std::size_t N>
+void planetary_vectorized(const double (&n)[14][N], const double (&c)[4][N],
+                          const double a[14], double& dp,
+                          double& de) noexcept {
+  using simd::f64x4;
+  f64x4 sp{}, se{};
+  for (std::size_t i = 0; i < N; i += 4) {
+    f64x4 arg, m;
+    load(&n[0][i], m);
+    arg = m * a[0];
+    for (int j = 1; j < 14; ++j) {
+      load(&n[j][i], m);
+      arg += m * a[j];
+    }
+    f64x4 s, co, c0, c1, c2, c3;
+    simd::sincos(arg, s, co);
+    load(&c[0][i], c0);
+    load(&c[1][i], c1);
+    load(&c[2][i], c2);
+    load(&c[3][i], c3);
+    sp += c0 * s + c1 * co;
+    se += c2 * s + c3 * co;
+  }
+  dp = lane_sum(sp);
+  de = lane_sum(se);
+}
+
+// ---- Recurrence evaluator (NutationEvaluator::recurrence) ----
+//
+// A term's argument is an integer combination sum(n_j a_j), so its cosine and
+// sine are the real and imaginary parts of the product of exp(i n_j a_j).
+// Those come from a table of the multiples k a_j, |k| <= kMaxMultiplier, built
+// from one libm sin/cos of a_j by angle addition: two libm calls per argument
+// instead of two per term. Rounding grows with k but stays ~1e-14 relative,
+// well under 1e-12 arcsec in the sums.
+
+// cos(k x) and sin(k x) at [k + kMaxMultiplier].
+struct Multiples {
+  double c[2 * kMaxMultiplier + 1];
+  double s[2 * kMaxMultiplier + 1];
+};
+
+void multiples(double x, Multiples& m) noexcept {
+  constexpr int z = kMaxMultiplier;
+  const double c1 = std::cos(x), s1 = std::sin(x);
+  m.c[z] = 1.0;
+  m.s[z] = 0.0;
+  for (int k = 1; k <= z; ++k) {
+    const double c = m.c[z + k - 1] * c1 - m.s[z + k - 1] * s1;
+    const double s = m.s[z + k - 1] * c1 + m.c[z + k - 1] * s1;
+    m.c[z + k] = m.c[z - k] = c;
+    m.s[z + k] = s;
+    m.s[z - k] = -s;
+  }
+}
+
+// cos and sin of the argument with multipliers `n` of the arguments `m`.
+template <std::size_t K>
+void term(const int (&n)[K], const Multiples (&m)[K], double& carg,
+          double& sarg) noexcept {
+  carg = m[0].c[n[0] + kMaxMultiplier];
+  sarg = m[0].s[n[0] + kMaxMultiplier];
+  for (std::size_t j = 1; j < K; ++j) {
+    if (n[j] == 0) continue;  // most planetary terms use a few of the 14
+    const double c = m[j].c[n[j] + kMaxMultiplier];
+    const double s = m[j].s[n[j] + kMaxMultiplier];
+    const double next = carg * c - sarg * s;
+    sarg = sarg * c + carg * s;
+    carg = next;
+  }
+}
+
+// Luni-solar sums, in the exact loop's order, of the series (`n`, `c`) over
+// the five Delaunay arguments' multiples `m`.
+template <std::size_t N>
+void luni_solar_recurrence(const int (&n)[N][5], const double (&c)[N][6],
+                           const Multiples (&m)[5], double t, double& dp,
+                           double& de) noexcept {
+  dp = 0.0;
+  de = 0.0;
+  for (std::size_t i = N; i-- > 0;) {
+    double carg, sarg;
+    term(n[i], m, carg, sarg);
+    dp += (c[i][0] + c[i][1] * t) * sarg + c[i][2] * carg;
+    de += (c[i][3] + c[i][4] * t) * carg + c[i][5] * sarg;
+  }
+}
+
+// Planetary sums over the fourteen arguments' multiples `m`.
+template <std::size_t N>
+void planetary_recurrence(const int (&n)[N][14], const double (&c)[N][4],
+                          const Multiples (&m)[14], double& dp,
+                          double& de) noexcept {
+  dp = 0.0;
+  de = 0.0;
+  for (std::size_t i = N; i-- > 0;) {
+    double carg, sarg;
+    term(n[i], m, carg, sarg);
+    dp += c[i][0] * sarg + c[i][1] * carg;
+    de += c[i][2] * sarg + c[i][3] * carg;
+  }
+}
+
+// The multiples of each of `K` arguments.
+template <std::size_t K>
+void multiples(const double (&a)[K], Multiples (&m)[K]) noexcept {
+  for (std::size_t j = 0; j < K; ++j) multiples(a[j], m[j]);
+}
+
 // IAU 2000A nutation (radians). jd = jd_high + jd_low (TDB). NOVAS iau2000a.
-void iau2000a(double jd_high, double jd_low, double* dpsi, double* deps) {
+void iau2000a(double jd_high, double jd_low, NutationEvaluator evaluator,
+              double* dpsi, double* deps) {
   const double t = ((jd_high - kT0) + jd_low) / 36525.0;
 
   double a[5];
@@ -27,14 +189,22 @@ void iau2000a(double jd_high, double jd_low, double* dpsi, double* deps) {
 
   // Luni-solar terms (summed in reverse, as in NOVAS, for bit-for-bit match).
   double dp = 0.0, de = 0.0;
-  for (int i = 677; i >= 0; --i) {
-    const double arg = std::fmod(
-        nals_a[i][0] * a[0] + nals_a[i][1] * a[1] + nals_a[i][2] * a[2] +
-            nals_a[i][3] * a[3] + nals_a[i][4] * a[4],
-        kTwoPi);
-    const double sarg = std::sin(arg), carg = std::cos(arg);
-    dp += (cls_a[i][0] + cls_a[i][1] * t) * sarg + cls_a[i][2] * carg;
-    de += (cls_a[i][3] + cls_a[i][4] * t) * carg + cls_a[i][5] * sarg;
+  if (evaluator == NutationEvaluator::vectorized) {
+    luni_solar_vectorized(nals_a_soa, cls_a_soa, a, t, dp, de);
+  } else if (evaluator == NutationEvaluator::recurrence) {
+    Multiples m[5];
+    multiples(a, m);
+    luni_solar_recurrence(nals_a, cls_a, m, t, dp, de);
+  } else {
+    for (int i = 677; i >= 0; --i) {
+      const double arg = std::fmod(
+          nals_a[i][0] * a[0] + nals_a[i][1] * a[1] + nals_a[i][2] * a[2] +
+              nals_a[i][3] * a[3] + nals_a[i][4] * a[4],
+          kTwoPi);
+      const double sarg = std::sin(arg), carg = std::cos(arg);
+      dp += (cls_a[i][0] + cls_a[i][1] * t) * sarg + cls_a[i][2] * carg;
+      de += (cls_a[i][3] + cls_a[i][4] * t) * carg + cls_a[i][5] * sarg;
+    }
   }
   const double factor = 1.0e-7 * kAsec2Rad;
   const double dpsils = dp * factor, depsls = de * factor;
@@ -57,38 +227,58 @@ void iau2000a(double jd_high, double jd_low, double* dpsi, double* deps) {
 
   dp = 0.0;
   de = 0.0;
-  for (int i = 686; i >= 0; --i) {
-    const double arg = std::fmod(
-        napl_a[i][0] * al + napl_a[i][1] * alsu + napl_a[i][2] * af +
-            napl_a[i][3] * ad + napl_a[i][4] * aom + napl_a[i][5] * alme +
-            napl_a[i][6] * alve + napl_a[i][7] * alea + napl_a[i][8] * alma +
-            napl_a[i][9] * alju + napl_a[i][10] * alsa + napl_a[i][11] * alur +
-            napl_a[i][12] * alne + napl_a[i][13] * apa,
-        kTwoPi);
-    const double sarg = std::sin(arg), carg = std::cos(arg);
-    dp += cpl_a[i][0] * sarg + cpl_a[i][1] * carg;
-    de += cpl_a[i][2] * sarg + cpl_a[i][3] * carg;
+  const double pa[14] = {al,   alsu, af,   ad,   aom,  alme, alve,
+                         alea, alma, alju, alsa, alur, alne, apa};
+  if (evaluator == NutationEvaluator::vectorized) {
+    planetary_vectorized(napl_a_soa, cpl_a_soa, pa, dp, de);
+  } else if (evaluator == NutationEvaluator::recurrence) {
+    Multiples m[14];
+    multiples(pa, m);
+    planetary_recurrence(napl_a, cpl_a, m, dp, de);
+  } else {
+    for (int i = 686; i >= 0; --i) {
+      const double arg = std::fmod(
+          napl_a[i][0] * al + napl_a[i][1] * alsu + napl_a[i][2] * af +
+              napl_a[i][3] * ad + napl_a[i][4] * aom + napl_a[i][5] * alme +
+              napl_a[i][6] * alve + napl_a[i][7] * alea + napl_a[i][8] * alma +
+              napl_a[i][9] * alju + napl_a[i][10] * alsa +
+              napl_a[i][11] * alur + napl_a[i][12] * alne +
+              napl_a[i][13] * apa,
+          kTwoPi);
+      const double sarg = std::sin(arg), carg = std::cos(arg);
+      dp += cpl_a[i][0] * sarg + cpl_a[i][1] * carg;
+      de += cpl_a[i][2] * sarg + cpl_a[i][3] * carg;
+    }
   }
   *dpsi = dp * factor + dpsils;
   *deps = de * factor + depsls;
 }
 
 // NU2000K truncated nutation (radians). NOVAS nu2000k.
-void nu2000k(double jd_high, double jd_low, double* dpsi, double* deps) {
+void nu2000k(double jd_high, double jd_low, NutationEvaluator evaluator,
+             double* dpsi, double* deps) {
   const double t = ((jd_high - kT0) + jd_low) / 36525.0;
 
   double a[5];
   fundamental_arguments(t, a);
 
   double dp = 0.0, de = 0.0;
-  for (int i = 322; i >= 0; --i) {
-    const double arg = std::fmod(
-        nals_k[i][0] * a[0] + nals_k[i][1] * a[1] + nals_k[i][2] * a[2] +
-            nals_k[i][3] * a[3] + nals_k[i][4] * a[4],
-        kTwoPi);
-    const double sarg = std::sin(arg), carg = std::cos(arg);
-    dp += (cls_k[i][0] + cls_k[i][1] * t) * sarg + cls_k[i][2] * carg;
-    de += (cls_k[i][3] + cls_k[i][4] * t) * carg + cls_k[i][5] * sarg;
+  if (evaluator == NutationEvaluator::vectorized) {
+    luni_solar_vectorized(nals_k_soa, cls_k_soa, a, t, dp, de);
+  } else if (evaluator == NutationEvaluator::recurrence) {
+    Multiples m[5];
+    multiples(a, m);
+    luni_solar_recurrence(nals_k, cls_k, m, t, dp, de);
+  } else {
+    for (int i = 322; i >= 0; --i) {
+      const double arg = std::fmod(
+          nals_k[i][0] * a[0] + nals_k[i][1] * a[1] + nals_k[i][2] * a[2] +
+              nals_k[i][3] * a[3] + nals_k[i][4] * a[4],
+          kTwoPi);
+      const double sarg = std::sin(arg), carg = std::cos(arg);
+      dp += (cls_k[i][0] + cls_k[i][1] * t) * sarg + cls_k[i][2] * carg;
+      de += (cls_k[i][3] + cls_k[i][4] * t) * carg + cls_k[i][5] * sarg;
+    }
   }
   const double factor = 1.0e-7 * kAsec2Rad;
   const double dpsils = dp * factor, depsls = de * factor;
@@ -107,17 +297,28 @@ void nu2000k(double jd_high, double jd_low, double* dpsi, double* deps) {
 
   dp = 0.0;
   de = 0.0;
-  for (int i = 164; i >= 0; --i) {
-    const double arg = std::fmod(
-        napl_k[i][0] * a[0] + napl_k[i][1] * a[1] + napl_k[i][2] * a[2] +
-            napl_k[i][3] * a[3] + napl_k[i][4] * a[4] + napl_k[i][5] * alme +
-            napl_k[i][6] * alve + napl_k[i][7] * alea + napl_k[i][8] * alma +
-            napl_k[i][9] * alju + napl_k[i][10] * alsa + napl_k[i][11] * alur +
-            napl_k[i][12] * alne + napl_k[i][13] * apa,
-        kTwoPi);
-    const double sarg = std::sin(arg), carg = std::cos(arg);
-    dp += cpl_k[i][0] * sarg + cpl_k[i][1] * carg;
-    de += cpl_k[i][2] * sarg + cpl_k[i][3] * carg;
+  const double pa[14] = {a[0], a[1], a[2], a[3], a[4], alme, alve,
+                         alea, alma, alju, alsa, alur, alne, apa};
+  if (evaluator == NutationEvaluator::vectorized) {
+    planetary_vectorized(napl_k_soa, cpl_k_soa, pa, dp, de);
+  } else if (evaluator == NutationEvaluator::recurrence) {
+    Multiples m[14];
+    multiples(pa, m);
+    planetary_recurrence(napl_k, cpl_k, m, dp, de);
+  } else {
+    for (int i = 164; i >= 0; --i) {
+      const double arg = std::fmod(
+          napl_k[i][0] * a[0] + napl_k[i][1] * a[1] + napl_k[i][2] * a[2] +
+              napl_k[i][3] * a[3] + napl_k[i][4] * a[4] + napl_k[i][5] * alme +
+              napl_k[i][6] * alve + napl_k[i][7] * alea + napl_k[i][8] * alma +
+              napl_k[i][9] * alju + napl_k[i][10] * alsa +
+              napl_k[i][11] * alur + napl_k[i][12] * alne +
+              napl_k[i][13] * apa,
+          kTwoPi);
+      const double sarg = std::sin(arg), carg = std::cos(arg);
+      dp += cpl_k[i][0] * sarg + cpl_k[i][1] * carg;
+      de += cpl_k[i][2] * sarg + cpl_k[i][3] * carg;
+    }
   }
   *dpsi = dp * factor + dpsils;
   *deps = de * factor + depsls;
@@ -164,12 +365,17 @@ double mean_obliquity(double jd_tdb) {
 }
 
 void nutation_angles(double t, Accuracy accuracy, double& dpsi, double& deps) {
+  nutation_angles(t, accuracy, NutationEvaluator::exact, dpsi, deps);
+}
+
+void nutation_angles(double t, Accuracy accuracy, NutationEvaluator evaluator,
+                     double& dpsi, double& deps) {
   const double t1 = t * 36525.0;
   double dp, de;
   if (accuracy == Accuracy::full)
-    iau2000a(kT0, t1, &dp, &de);
+    iau2000a(kT0, t1, evaluator, &dp, &de);
   else
-    nu2000k(kT0, t1, &dp, &de);
+    nu2000k(kT0, t1, evaluator, &dp, &de);
   dpsi = dp / kAsec2Rad;  // radians -> arcseconds
   deps = de / kAsec2Rad;
 }
@@ -0,0 +1,47 @@
+#ifndef ASTRO_SRC_OF_DATE_HPP
+#define ASTRO_SRC_OF_DATE_HPP
+
+// Internal: where the of-date reductions -- place() and sidereal time
+// (reductions.cpp), the ecliptic of date and the tropical moments
+// (phenomena.cpp) -- take their nutation angles and TDB - TT from, given the
+// ephemeris they work against (OpenOptions::nutation, nutation_evaluator,
+// tdb). Without one, the series, as NOVAS.
+
+#include "astro/accuracy.hpp"
+#include "astro/ephemeris.hpp"
+#include "astro/frames.hpp"  // nutation_angles
+#include "astro/tdb_table.hpp"
+#include "astro/time.hpp"    // tdb_minus_tt_seconds
+
+namespace astro::of_date {
+
+// Nutation in longitude and obliquity, arcseconds, at TDB `jd_tdb`: the
+// ephemeris's own series when `eph` was opened with NutationSource::ephemeris
+// and covers the epoch, else the IAU 2000A/NU2000K series (nutation_angles),
+// summed as `eph` selects.
+inline void nutation_arcsec(double jd_tdb, Accuracy accuracy,
+                            const Ephemeris* eph, double& dpsi, double& deps) {
+  constexpr double kT0 = 2451545.0;
+  constexpr double kAsec2Rad = 4.848136811095359935899141e-6;
+  if (eph && eph->nutation_source() == NutationSource::ephemeris) {
+    if (auto n = eph->nutation(TdbInstant{JulianDate{jd_tdb}})) {
+      dpsi = n->dpsi / kAsec2Rad;
+      deps = n->deps / kAsec2Rad;
+      return;
+    }
+  }
+  nutation_angles((jd_tdb - kT0) / 36525.0, accuracy,
+                  eph ? eph->nutation_evaluator() : NutationEvaluator::exact,
+                  dpsi, deps);
+}
+
+// TDB - TT in seconds at TT `jd_tt`: `eph`'s table when it was opened with
+// TdbSource::ephemeris (and covers the epoch), else the series.
+inline double tdb_minus_tt(double jd_tt, const Ephemeris* eph) {
+  return eph ? eph->tdb_table().tdb_minus_tt_seconds(jd_tt)
+             : tdb_minus_tt_seconds(jd_tt);
+}
+
+}  // namespace astro::of_date
+
+#endif  // ASTRO_SRC_OF_DATE_HPP
@@ -4,15 +4,16 @@
 #include <cmath>
 #include <limits>
 
-#include "astro/frames.hpp"      // mean_obliquity, nutation_angles
+#include "astro/frames.hpp"      // mean_obliquity
 #include "astro/reductions.hpp"  // place
-#include "astro/time.hpp"        // tdb_minus_tt_seconds
+#include "astro/tdb_table.hpp"
+#include "astro/time.hpp"        // tdb_from_tt
+#include "of_date.hpp"            // nutation_arcsec, tdb_minus_tt
 
 namespace astro {
 
 namespace {
 
-constexpr double kT0 = 2451545.0;
 constexpr double kDeg2Rad = 0.017453292519943296;
 constexpr double kRad2Deg = 57.295779513082321;
 constexpr double kTwoPi = 6.283185307179586476925287;
@@ -65,10 +66,11 @@ double brent(F f, double a, double b, double fa, double fb, double tol) {
 }  // namespace
 
 void equ_to_ecl_of_date(double jd_tt, double ra_hours, double dec_deg,
-                        double& ecl_lon_deg, double& ecl_lat_deg) {
-  const double jd_tdb = jd_tt + tdb_minus_tt_seconds(jd_tt) / 86400.0;
+                        double& ecl_lon_deg, double& ecl_lat_deg,
+                        const Ephemeris* eph) {
+  const double jd_tdb = jd_tt + of_date::tdb_minus_tt(jd_tt, eph) / 86400.0;
   double dpsi, deps;
-  nutation_angles((jd_tdb - kT0) / 36525.0, Accuracy::full, dpsi, deps);
+  of_date::nutation_arcsec(jd_tdb, Accuracy::full, eph, dpsi, deps);
   // True obliquity of date, degrees: mean obliquity + nutation in obliquity.
   const double obl = (mean_obliquity(jd_tdb) + deps) / 3600.0 * kDeg2Rad;
 
@@ -91,7 +93,8 @@ double sun_apparent_longitude(const Ephemeris& eph, TtInstant t) {
                    Accuracy::full);
   if (!sky) return std::numeric_limits<double>::quiet_NaN();
   double lon, lat;
-  equ_to_ecl_of_date(t.jd.value(), sky->ra_hours, sky->dec_deg, lon, lat);
+  equ_to_ecl_of_date(t.jd.value(), sky->ra_hours, sky->dec_deg, lon, lat,
+                     &eph);
   return lon;
 }
 
@@ -176,7 +179,7 @@ std::generator<SkyEvent> horizon_events(const Ephemeris& eph, Point body,
                      CoordSys::equator_equinox, Accuracy::full);
     if (!sky) return std::numeric_limits<double>::quiet_NaN();
     const Ut1Instant ut1{JulianDate{t - dt.seconds / 86400.0}};
-    const auto hor = equ2hor(ut1, dt, Accuracy::full, PolarMotion{}, obs,
+    const auto hor = equ2hor(eph, ut1, dt, Accuracy::full, PolarMotion{}, obs,
                              sky->ra_hours, sky->dec_deg, Refraction::none);
     return 90.0 - hor.zenith_distance_deg;
   };
@@ -187,7 +190,8 @@ std::generator<SkyEvent> horizon_events(const Ephemeris& eph, Point body,
                      CoordSys::equator_equinox, Accuracy::full);
     if (!sky) return std::numeric_limits<double>::quiet_NaN();
     const Ut1Instant ut1{JulianDate{t - dt.seconds / 86400.0}};
-    const double gast = greenwich_apparent_sidereal_time(ut1, dt, Accuracy::full);
+    const double gast =
+        greenwich_apparent_sidereal_time(eph, ut1, dt, Accuracy::full);
     const double ha = gast + obs.longitude_deg / 15.0 - sky->ra_hours;  // hours
     return std::sin(ha * kPi / 12.0);
   };
@@ -195,7 +199,7 @@ std::generator<SkyEvent> horizon_events(const Ephemeris& eph, Point body,
     auto sky = place(eph, body, TtInstant{JulianDate{t}}, dt, obs,
                      CoordSys::equator_equinox, Accuracy::full);
     const Ut1Instant ut1{JulianDate{t - dt.seconds / 86400.0}};
-    const auto hor = equ2hor(ut1, dt, Accuracy::full, PolarMotion{}, obs,
+    const auto hor = equ2hor(eph, ut1, dt, Accuracy::full, PolarMotion{}, obs,
                              sky ? sky->ra_hours : 0.0, sky ? sky->dec_deg : 0.0,
                              Refraction::none);
     return SkyEvent{k, TtInstant{JulianDate{t}}, 90.0 - hor.zenith_distance_deg,
@@ -246,12 +250,12 @@ namespace {
 double gm_center(const Ephemeris& eph, Point center) {
   const auto& c = eph.constants();
   if (center == Point::earth) {
-    const auto gmb = c.get("GMB");        // Earth-Moon barycenter GM
-    const auto emrat = c.get("EMRAT");    // M_earth / M_moon
+    const auto gmb = c.gm_earth_moon();   // Earth-Moon barycenter GM
+    const auto emrat = c.earth_moon_ratio();  // M_earth / M_moon
     if (gmb && emrat) return *gmb * (*emrat) / (*emrat + 1.0);  // Earth's share
     return 8.887e-10;
   }
-  return c.get("GMS").value_or(2.9591220828411951e-4);  // Sun (default)
+  return c.gm_sun().value_or(2.9591220828411951e-4);  // Sun (default)
 }
 
 }  // namespace
@@ -276,7 +280,7 @@ std::generator<ApsisEvent> apsides(const Ephemeris& eph, Point body,
     return p[0] * v[0] + p[1] * v[1] + p[2] * v[2];
   };
 
-  double t = tdb_from_tt(start).jd.value();
+  double t = tdb_from_tt(start, eph.tdb_table()).jd.value();
 
   // Estimate the orbital period (vis-viva) to size the march stride.
   auto st0 = eph.state(body, center, TdbInstant{JulianDate{t}}, Units::au);
@@ -310,7 +314,8 @@ std::generator<ApsisEvent> apsides(const Ephemeris& eph, Point body,
       rv(root, &dist);
       // r.v ascending through 0 (- -> +) = periapsis (distance minimum).
       const Apsis kind = (gl > ge) ? Apsis::periapsis : Apsis::apoapsis;
-      const double tt_jd = root - tdb_minus_tt_seconds(root) / 86400.0;
+      const double tt_jd =
+          root - eph.tdb_table().tdb_minus_tt_seconds(root) / 86400.0;
       co_yield ApsisEvent{kind, TtInstant{JulianDate{tt_jd}}, dist};
     }
     t = t1;
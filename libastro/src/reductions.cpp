@@ -4,6 +4,9 @@
 #include <cmath>
 
 #include "astro/frames.hpp"  // nutation_angles, mean_obliquity
+#include "astro/tdb_table.hpp"
+#include "astro/time.hpp"    // tdb_minus_tt_seconds
+#include "of_date.hpp"        // nutation_arcsec, tdb_minus_tt
 
 // Layer 2 reductions -- port of NOVAS-C's place() pipeline (research doc 2.2).
 // Covers a geocentric or surface observer and the GCRS, astrometric, and
@@ -58,18 +61,6 @@ double norm_ang(double angle) {
   return a;
 }
 
-// USNO Circular 179 eq. 2.6: TDB - TT in seconds. NOVAS tdb2tt.
-double tdb_minus_tt_seconds(double jd) {
-  const double t = (jd - kT0) / 36525.0;
-  return 0.001657 * std::sin(628.3076 * t + 6.2401) +
-         0.000022 * std::sin(575.3385 * t + 4.2970) +
-         0.000014 * std::sin(1256.6152 * t + 6.1969) +
-         0.000005 * std::sin(606.9777 * t + 4.0212) +
-         0.000005 * std::sin(52.9691 * t + 0.4444) +
-         0.000002 * std::sin(21.3299 * t + 5.5431) +
-         0.000010 * t * std::sin(628.3076 * t + 4.2490);
-}
-
 std::expected<void, EphError> bary_state(const Ephemeris& eph, Point p,
                                          double whole, double frac,
                                          double pos[3], double vel[3]) {
@@ -83,6 +74,17 @@ std::expected<void, EphError> bary_state(const Ephemeris& eph, Point p,
   return {};
 }
 
+// bary_state() without the velocity, for callers that would discard it.
+std::expected<void, EphError> bary_position(const Ephemeris& eph, Point p,
+                                            double whole, double frac,
+                                            double pos[3]) {
+  auto r = eph.position(p, Point::solar_system_barycenter,
+                        TdbInstant{JulianDate{whole, frac}}, Units::au);
+  if (!r) return std::unexpected(r.error());
+  for (int i = 0; i < 3; ++i) pos[i] = (*r)[i];
+  return {};
+}
+
 void bary2obs(const double pos[3], const double pos_obs[3], double pos2[3],
               double* lighttime) {
   for (int j = 0; j < 3; ++j) pos2[j] = pos[j] - pos_obs[j];
@@ -111,11 +113,11 @@ std::expected<double, EphError> light_time(const Ephemeris& eph, Point body,
     t1 = jd_tdb;
     t2 = jd_tdb - tlight0;
   }
-  double t3 = 0.0, tlight = 0.0, pos1[3], vel1[3];
+  double t3 = 0.0, tlight = 0.0, pos1[3];
   for (int iter = 0;; ++iter) {
     if (iter > 10) return std::unexpected(EphError::no_convergence);
     if (iter > 0) t2 = t3;
-    if (auto r = bary_state(eph, body, jd0, t2, pos1, vel1); !r)
+    if (auto r = bary_position(eph, body, jd0, t2, pos1); !r)
       return std::unexpected(r.error());
     bary2obs(pos1, pos_obs, pos, &tlight);
     t3 = t1 - tlight;
@@ -171,23 +173,23 @@ std::expected<void, EphError> grav_def(const Ephemeris& eph, double jd_tdb,
   const double tlt = vlen(pos1) / kCAuDay;
 
   for (int k = 0; k < nbodies; ++k) {
-    double pbody[3], vbody[3], pbodyo[3], x;
-    if (auto r = bary_state(eph, kBodies[k].point, jd_tdb, 0.0, pbody, vbody); !r)
+    double pbody[3], pbodyo[3], x;
+    if (auto r = bary_position(eph, kBodies[k].point, jd_tdb, 0.0, pbody); !r)
       return std::unexpected(r.error());
     bary2obs(pbody, pos_obs, pbodyo, &x);
     const double dlt = d_light(pos2, pbodyo);
     double tclose = jd_tdb;
     if (dlt > 0.0) tclose = jd_tdb - dlt;
     if (tlt < dlt) tclose = jd_tdb - tlt;
-    if (auto r = bary_state(eph, kBodies[k].point, tclose, 0.0, pbody, vbody); !r)
+    if (auto r = bary_position(eph, kBodies[k].point, tclose, 0.0, pbody); !r)
       return std::unexpected(r.error());
     grav_vec(pos2, pos_obs, pbody,
              kRmass[static_cast<std::size_t>(kBodies[k].rmass_index)], pos2);
   }
 
   if (loc != 0) {  // Earth deflection
-    double pbody[3], vbody[3];
-    if (auto r = bary_state(eph, Point::earth, jd_tdb, 0.0, pbody, vbody); !r)
+    double pbody[3];
+    if (auto r = bary_position(eph, Point::earth, jd_tdb, 0.0, pbody); !r)
       return std::unexpected(r.error());
     grav_vec(pos2, pos_obs, pbody, kRmass[3], pos2);
   }
@@ -397,12 +399,18 @@ double ee_ct(double jd_high, double jd_low, Accuracy accuracy) {
   return c_terms * kAsec2Rad;
 }
 
+using of_date::nutation_arcsec;
+using of_date::tdb_minus_tt;
+
 // Obliquity + nutation angles + equation of the equinoxes (novas.c:e_tilt).
 // Outputs: mean/true obliquity (deg), eq. of equinoxes (s), dpsi/deps (arcsec).
+// `eph`, where given, may supply the nutation angles (nutation_arcsec); so
+// for every function below that takes one.
 void e_tilt(double jd_tdb, Accuracy accuracy, double* mobl, double* tobl,
-            double* ee, double* dpsi, double* deps) {
+            double* ee, double* dpsi, double* deps,
+            const Ephemeris* eph = nullptr) {
   double dp, de;
-  nutation_angles((jd_tdb - kT0) / 36525.0, accuracy, dp, de);  // arcsec
+  nutation_arcsec(jd_tdb, accuracy, eph, dp, de);  // arcsec
   const double c_terms = ee_ct(jd_tdb, 0.0, accuracy) / kAsec2Rad;  // arcsec
   const double d_psi = dp;  // PSI_COR = 0
   const double d_eps = de;  // EPS_COR = 0
@@ -420,9 +428,10 @@ void e_tilt(double jd_tdb, Accuracy accuracy, double* mobl, double* tobl,
 
 // Apply (direction 0) or invert (direction != 0) nutation (novas.c:nutation).
 void nutation_rot(double jd_tdb, int direction, Accuracy accuracy,
-                  const double pos[3], double pos2[3]) {
+                  const double pos[3], double pos2[3],
+                  const Ephemeris* eph = nullptr) {
   double oblm, oblt, eqeq, psi, eps;
-  e_tilt(jd_tdb, accuracy, &oblm, &oblt, &eqeq, &psi, &eps);
+  e_tilt(jd_tdb, accuracy, &oblm, &oblt, &eqeq, &psi, &eps, eph);
   const double cobm = std::cos(oblm * kDeg2Rad), sobm = std::sin(oblm * kDeg2Rad);
   const double cobt = std::cos(oblt * kDeg2Rad), sobt = std::sin(oblt * kDeg2Rad);
   const double cpsi = std::cos(psi * kAsec2Rad), spsi = std::sin(psi * kAsec2Rad);
@@ -460,16 +469,17 @@ double era_deg(double jd_high, double jd_low) {
 // method=1). `apparent` selects GAST (gst_type=1, adds the equation of the
 // equinoxes) over GMST (gst_type=0).
 double sidereal_time_hours(double jd_ut1_high, double jd_ut1_low,
-                           double delta_t, bool apparent, Accuracy accuracy) {
+                           double delta_t, bool apparent, Accuracy accuracy,
+                           const Ephemeris* eph = nullptr) {
   const double jd_ut1 = jd_ut1_high + jd_ut1_low;
   const double jd_tt = jd_ut1 + delta_t / 86400.0;
-  const double jd_tdb = jd_tt + tdb_minus_tt_seconds(jd_tt) / 86400.0;
+  const double jd_tdb = jd_tt + tdb_minus_tt(jd_tt, eph) / 86400.0;
   const double t = (jd_tdb - kT0) / 36525.0;
   const double theta = era_deg(jd_ut1_high, jd_ut1_low);
   double eqeq = 0.0;
   if (apparent) {
     double oblm, oblt, ee, psi, eps;
-    e_tilt(jd_tdb, accuracy, &oblm, &oblt, &ee, &psi, &eps);
+    e_tilt(jd_tdb, accuracy, &oblm, &oblt, &ee, &psi, &eps, eph);
     eqeq = ee * 15.0;  // seconds of time -> arcseconds
   }
   const double st = eqeq + 0.014506 +
@@ -511,20 +521,21 @@ void terra(const SurfaceObserver& loc, double st, double pos[3], double vel[3])
 // (novas.c:geo_posvel, where == 1).
 void geo_posvel_surface(double jd_tt, double delta_t, Accuracy accuracy,
                         const SurfaceObserver& loc, double pos[3],
-                        double vel[3]) {
-  const double jd_tdb = jd_tt + tdb_minus_tt_seconds(jd_tt) / 86400.0;
+                        double vel[3], const Ephemeris* eph = nullptr) {
+  const double jd_tdb = jd_tt + tdb_minus_tt(jd_tt, eph) / 86400.0;
   const double jd_ut1 = jd_tt - delta_t / 86400.0;
-  const double gmst = sidereal_time_hours(jd_ut1, 0.0, delta_t, false, accuracy);
+  const double gmst =
+      sidereal_time_hours(jd_ut1, 0.0, delta_t, false, accuracy, eph);
   double oblm, oblt, eqeq, psi, eps;
-  e_tilt(jd_tdb, accuracy, &oblm, &oblt, &eqeq, &psi, &eps);
+  e_tilt(jd_tdb, accuracy, &oblm, &oblt, &eqeq, &psi, &eps, eph);
   const double gast = gmst + eqeq / 3600.0;  // eqeq is in seconds of time
 
   double pos1[3], vel1[3], pos2[3], vel2[3], pos3[3], vel3[3];
   terra(loc, gast, pos1, vel1);
-  nutation_rot(jd_tdb, -1, accuracy, pos1, pos2);
+  nutation_rot(jd_tdb, -1, accuracy, pos1, pos2, eph);
   precession(jd_tdb, pos2, kT0, pos3);
   frame_tie(pos3, -1, pos);
-  nutation_rot(jd_tdb, -1, accuracy, vel1, vel2);
+  nutation_rot(jd_tdb, -1, accuracy, vel1, vel2, eph);
   precession(jd_tdb, vel2, kT0, vel3);
   frame_tie(vel3, -1, vel);
 }
@@ -581,12 +592,14 @@ void wobble(double tjd, double xp, double yp, const double pos1[3],
 
 // Terrestrial -> celestial (equator & equinox of date), equinox method with
 // `option == 1` (stop after Earth rotation). novas.c:ter2cel(method=1,option=1).
+// TDB - TT and the nutation angles as `eph` selects; the series without one.
 void ter2cel_equinox(double jd_ut1_high, double jd_ut1_low, double delta_t,
                      Accuracy accuracy, double xp, double yp,
-                     const double vec1[3], double vec2[3]) {
+                     const double vec1[3], double vec2[3],
+                     const Ephemeris* eph = nullptr) {
   const double jd_ut1 = jd_ut1_high + jd_ut1_low;
   const double jd_tt = jd_ut1 + delta_t / 86400.0;
-  const double jd_tdb = jd_tt + tdb_minus_tt_seconds(jd_tt) / 86400.0;
+  const double jd_tdb = jd_tt + tdb_minus_tt(jd_tt, eph) / 86400.0;
 
   double v1[3];
   if (xp == 0.0 && yp == 0.0)
@@ -594,8 +607,8 @@ void ter2cel_equinox(double jd_ut1_high, double jd_ut1_low, double delta_t,
   else
     wobble(jd_tdb, xp, yp, vec1, v1);
 
-  const double gast =
-      sidereal_time_hours(jd_ut1_high, jd_ut1_low, delta_t, true, accuracy);
+  const double gast = sidereal_time_hours(jd_ut1_high, jd_ut1_low, delta_t,
+                                          true, accuracy, eph);
   spin(-gast * 15.0, v1, vec2);  // option == 1: done
 }
 
@@ -617,10 +630,11 @@ double refract_zd(const SurfaceObserver& loc, Refraction ref, double zd_obs) {
 
 // RA of the true equinox (= -equation of origins), in hours. novas.c:ira_equinox
 // with equinox = 1 (true equinox).
-double ira_equinox(double jd_tdb, Accuracy accuracy) {
+double ira_equinox(double jd_tdb, Accuracy accuracy,
+                   const Ephemeris* eph = nullptr) {
   const double t = (jd_tdb - kT0) / 36525.0;
   double u, v, ee, w, x;
-  e_tilt(jd_tdb, accuracy, &u, &v, &ee, &w, &x);  // ee: eq. of equinoxes (s)
+  e_tilt(jd_tdb, accuracy, &u, &v, &ee, &w, &x, eph);  // ee: eq. of equinoxes (s)
   const double prec_ra =
       0.014506 + ((((-0.0000000368 * t - 0.000029956) * t - 0.00000044) * t +
                    1.3915817) * t + 4612.156534) * t;
@@ -631,16 +645,16 @@ double ira_equinox(double jd_tdb, Accuracy accuracy) {
 // of the CIO in the equinox-of-date system (ref_sys 2 -- the analytic, no-CIO-
 // file path). novas.c:cio_basis case 2.
 void cio_basis(double jd_tdb, double ra_cio, Accuracy accuracy, double x[3],
-               double y[3], double z[3]) {
+               double y[3], double z[3], const Ephemeris* eph = nullptr) {
   double w1[3], w2[3];
   const double z0[3] = {0.0, 0.0, 1.0};
-  nutation_rot(jd_tdb, -1, accuracy, z0, w1);
+  nutation_rot(jd_tdb, -1, accuracy, z0, w1, eph);
   precession(jd_tdb, w1, kT0, w2);
   frame_tie(w2, -1, z);  // z toward the celestial pole, in GCRS
 
   const double w0[3] = {std::cos(ra_cio * 15.0 * kDeg2Rad),
                         std::sin(ra_cio * 15.0 * kDeg2Rad), 0.0};
-  nutation_rot(jd_tdb, -1, accuracy, w0, w1);
+  nutation_rot(jd_tdb, -1, accuracy, w0, w1, eph);
   precession(jd_tdb, w1, kT0, w2);
   frame_tie(w2, -1, x);  // x toward the CIO, in GCRS
 
@@ -761,19 +775,19 @@ std::expected<SkyPos, EphError> place_impl(const Ephemeris& eph,
   }
 
   const bool full = (accuracy == Accuracy::full);
-  const double jd_tdb = jd_tt + tdb_minus_tt_seconds(jd_tt) / 86400.0;
+  const double jd_tdb = jd_tt + tdb_minus_tt(jd_tt, &eph) / 86400.0;
 
-  double peb[3], veb[3], psb[3], vsb[3];
+  double peb[3], veb[3], psb[3];
   if (auto r = bary_state(eph, Point::earth, jd_tdb, 0.0, peb, veb); !r)
     return std::unexpected(r.error());
-  if (auto r = bary_state(eph, Point::sun, jd_tdb, 0.0, psb, vsb); !r)
+  if (auto r = bary_position(eph, Point::sun, jd_tdb, 0.0, psb); !r)
     return std::unexpected(r.error());
 
   // Observer geocentric offset.
   double pog[3] = {}, vog[3] = {};
   int locc = 0;
   if (surface) {
-    geo_posvel_surface(jd_tt, delta_t, accuracy, loc, pog, vog);
+    geo_posvel_surface(jd_tt, delta_t, accuracy, loc, pog, vog, &eph);
     locc = 1;
   }
   double pob[3], vob[3];
@@ -819,12 +833,12 @@ std::expected<SkyPos, EphError> place_impl(const Ephemeris& eph,
     double pos6[3], pos7[3];
     frame_tie(pos5, 1, pos6);
     precession(kT0, pos6, jd_tdb, pos7);
-    nutation_rot(jd_tdb, 0, accuracy, pos7, pos8);
+    nutation_rot(jd_tdb, 0, accuracy, pos7, pos8, &eph);
   } else if (sys == CoordSys::equator_cio) {
     // Project onto the celestial intermediate system (equator & CIO of date).
-    const double ra_cio = -ira_equinox(jd_tdb, accuracy);
+    const double ra_cio = -ira_equinox(jd_tdb, accuracy, &eph);
     double px[3], py[3], pz[3];
-    cio_basis(jd_tdb, ra_cio, accuracy, px, py, pz);
+    cio_basis(jd_tdb, ra_cio, accuracy, px, py, pz, &eph);
     pos8[0] = dot3(px, pos5);
     pos8[1] = dot3(py, pos5);
     pos8[2] = dot3(pz, pos5);
@@ -896,9 +910,20 @@ double greenwich_apparent_sidereal_time(Ut1Instant t, DeltaT dt,
                              /*apparent=*/true, accuracy);
 }
 
-HorizonPos equ2hor(Ut1Instant t, DeltaT dt, Accuracy accuracy, PolarMotion pole,
-                   const SurfaceObserver& obs, double ra_hours, double dec_deg,
-                   Refraction refraction) {
+double greenwich_apparent_sidereal_time(const Ephemeris& eph, Ut1Instant t,
+                                        DeltaT dt, Accuracy accuracy) {
+  return sidereal_time_hours(t.jd.whole, t.jd.frac, dt.seconds,
+                             /*apparent=*/true, accuracy, &eph);
+}
+
+namespace {
+
+// equ2hor(), with TDB - TT and nutation as `eph` selects (the series when
+// null).
+HorizonPos equ2hor_impl(const Ephemeris* eph, Ut1Instant t, DeltaT dt,
+                        Accuracy accuracy, PolarMotion pole,
+                        const SurfaceObserver& obs, double ra_hours,
+                        double dec_deg, Refraction refraction) {
   const double jd_hi = t.jd.whole, jd_lo = t.jd.frac;
   const double sinlat = std::sin(obs.latitude_deg * kDeg2Rad);
   const double coslat = std::cos(obs.latitude_deg * kDeg2Rad);
@@ -917,11 +942,11 @@ HorizonPos equ2hor(Ut1Instant t, DeltaT dt, Accuracy accuracy, PolarMotion pole,
   // Rotate the basis to the celestial system of date.
   double uz[3], un[3], uw[3];
   ter2cel_equinox(jd_hi, jd_lo, dt.seconds, accuracy, pole.x_arcsec,
-                  pole.y_arcsec, uze, uz);
+                  pole.y_arcsec, uze, uz, eph);
   ter2cel_equinox(jd_hi, jd_lo, dt.seconds, accuracy, pole.x_arcsec,
-                  pole.y_arcsec, une, un);
+                  pole.y_arcsec, une, un, eph);
   ter2cel_equinox(jd_hi, jd_lo, dt.seconds, accuracy, pole.x_arcsec,
-                  pole.y_arcsec, uwe, uw);
+                  pole.y_arcsec, uwe, uw, eph);
 
   const double p[3] = {cosdc * cosra, cosdc * sinra, sindc};
   const double pz = dot3(p, uz), pn = dot3(p, un), pw = dot3(p, uw);
@@ -968,4 +993,29 @@ HorizonPos equ2hor(Ut1Instant t, DeltaT dt, Accuracy accuracy, PolarMotion pole,
   return out;
 }
 
+}  // namespace
+
+HorizonPos equ2hor(Ut1Instant t, DeltaT dt, Accuracy accuracy, PolarMotion pole,
+                   const SurfaceObserver& obs, double ra_hours, double dec_deg,
+                   Refraction refraction) {
+  return equ2hor_impl(nullptr, t, dt, accuracy, pole, obs, ra_hours, dec_deg,
+                      refraction);
+}
+
+HorizonPos equ2hor(const Ephemeris& eph, Ut1Instant t, DeltaT dt,
+                   Accuracy accuracy, PolarMotion pole,
+                   const SurfaceObserver& obs, double ra_hours, double dec_deg,
+                   Refraction refraction) {
+  return equ2hor_impl(&eph, t, dt, accuracy, pole, obs, ra_hours, dec_deg,
+                      refraction);
+}
+
+HorizonPos equ2hor(Ut1Instant t, DeltaT dt, Accuracy accuracy,
+                   const EarthOrientationTable& eop, const SurfaceObserver& obs,
+                   double ra_hours, double dec_deg, Refraction refraction) {
+  const PolarMotion pole =
+      eop.at(t.jd.value()).value_or(EarthOrientation{}).pole;
+  return equ2hor(t, dt, accuracy, pole, obs, ra_hours, dec_deg, refraction);
+}
+
 }  // namespace astro
@@ -0,0 +1,141 @@
+#ifndef ASTRO_SRC_SIMD_HPP
+#define ASTRO_SRC_SIMD_HPP
+
+// Internal: a minimal 4 x double vector for libastro's inner kernels.
+//
+// On GCC/Clang this is a compiler vector extension, which the backend lowers
+// to whatever the target flags allow -- one AVX2/AVX-512 ymm register with
+// -march=x86-64-v3 and up, an SSE2 or NEON register pair by default. Other
+// compilers get a plain 4-element struct with the same operators.
+//
+// Only element-wise +, -, * are provided (no horizontal reductions, no
+// reassociation), so each lane performs exactly the operation sequence of the
+// scalar code it replaces and results stay bit-identical to it. The one
+// exceptions are sin() and sincos() at the bottom, which are within a few ulp
+// of std::sin / std::cos but not bit-identical; the kernels that use them say
+// so.
+
+namespace astro::simd {
+
+#if defined(__GNUC__) || defined(__clang__)
+
+// Mixed vector/scalar operands broadcast the scalar (a built-in rule of the
+// extension). Kernels pass these by reference or keep them local: by value
+// across a call boundary, vectors wider than the enabled ISA change the ABI.
+using f64x4 = double __attribute__((vector_size(32)));
+
+// 1 when an f64x4 is a single hardware register (AVX and up); elsewhere it is
+// split into two 128-bit halves (SSE2, NEON) and lanes that must be gathered
+// from strided memory may not pay for themselves.
+#if defined(__AVX__)
+#  define ASTRO_SIMD_NATIVE_F64X4 1
+#endif
+
+#else
+
+struct f64x4 {
+  double v[4];
+  double& operator[](int i) noexcept { return v[i]; }
+  double operator[](int i) const noexcept { return v[i]; }
+};
+
+#define ASTRO_SIMD_OP(op)                                                  \
+  inline f64x4 operator op(const f64x4& a, const f64x4& b) noexcept {      \
+    return {a[0] op b[0], a[1] op b[1], a[2] op b[2], a[3] op b[3]};       \
+  }                                                                        \
+  inline f64x4 operator op(double a, const f64x4& b) noexcept {            \
+    return {a op b[0], a op b[1], a op b[2], a op b[3]};                   \
+  }                                                                        \
+  inline f64x4 operator op(const f64x4& a, double b) noexcept {            \
+    return {a[0] op b, a[1] op b, a[2] op b, a[3] op b};                   \
+  }
+ASTRO_SIMD_OP(+)
+ASTRO_SIMD_OP(-)
+ASTRO_SIMD_OP(*)
+#undef ASTRO_SIMD_OP
+
+inline f64x4& operator+=(f64x4& a, const f64x4& b) noexcept { return a = a + b; }
+
+#endif
+
+#if !defined(ASTRO_SIMD_NATIVE_F64X4)
+#  define ASTRO_SIMD_NATIVE_F64X4 0
+#endif
+
+// out = sin(x), lane-wise, for |x| < 2^29 (an out-parameter, not a return
+// value: see the ABI note on f64x4). x = k pi + r with |r| <= pi/2 (k rounded
+// by the 1.5 * 2^52 trick, pi split Cody-Waite style so k * pi is exact), then
+// sin x = (-1)^k sin r by an odd Taylor polynomial through r^19 (truncation
+// < 3e-16). Only +, -, * -- no branches, masks or integer lanes -- so the
+// fallback struct gets it too.
+inline void sin(const f64x4& x, f64x4& out) noexcept {
+  constexpr double kRound = 0x1.8p52;  // x + kRound - kRound == rint(x)
+  constexpr double kInvPi = 0.3183098861837907;
+  constexpr double kPi1 = 3.141592502593994;       // 24 bits
+  constexpr double kPi2 = 1.5099578831723193e-07;  // 24 bits
+  constexpr double kPi3 = 1.0780605716316238e-14;
+  const f64x4 k = (x * kInvPi + kRound) - kRound;
+  const f64x4 r = ((x - k * kPi1) - k * kPi2) - k * kPi3;
+  // k - 2 rint(k/2) is 0 for even k and +-1 for odd, so this is (-1)^k.
+  const f64x4 odd = k - 2.0 * ((k * 0.5 + kRound) - kRound);
+  const f64x4 sign = 1.0 - 2.0 * (odd * odd);
+  const f64x4 r2 = r * r;
+  f64x4 p = r2 * -8.2206352466243300e-18 + 2.8114572543455206e-15;  // 1/19!, 1/17!
+  p = p * r2 - 7.6471637318198160e-13;                              // 1/15!
+  p = p * r2 + 1.6059043836821613e-10;                              // 1/13!
+  p = p * r2 - 2.5052108385441720e-08;                              // 1/11!
+  p = p * r2 + 2.7557319223985893e-06;                              // 1/9!
+  p = p * r2 - 1.9841269841269841e-04;                              // 1/7!
+  p = p * r2 + 8.3333333333333333e-03;                              // 1/5!
+  p = p * r2 - 1.6666666666666667e-01;                              // 1/3!
+  out = sign * (r + r * (r2 * p));
+}
+
+// s = sin(x), c = cos(x), lane-wise, for |x| < 2^29. As sin() but reduced by
+// pi/2, x = k pi/2 + r with |r| <= pi/4, so both Taylor polynomials are short
+// (through r^15 and r^16, truncation < 2e-17); the quadrant k mod 4 then
+// swaps and negates them arithmetically:
+//   sin x = ( s_r,  c_r, -s_r, -c_r)[k mod 4]
+//   cos x = ( c_r, -s_r, -c_r,  s_r)[k mod 4].
+inline void sincos(const f64x4& x, f64x4& s, f64x4& c) noexcept {
+  constexpr double kRound = 0x1.8p52;  // x + kRound - kRound == rint(x)
+  constexpr double k2OverPi = 0.6366197723675814;
+  constexpr double kHalfPi1 = 0.5 * 3.141592502593994;  // as sin()'s, halved
+  constexpr double kHalfPi2 = 0.5 * 1.5099578831723193e-07;
+  constexpr double kHalfPi3 = 0.5 * 1.0780605716316238e-14;
+  const f64x4 k = (x * k2OverPi + kRound) - kRound;
+  const f64x4 r = ((x - k * kHalfPi1) - k * kHalfPi2) - k * kHalfPi3;
+  const f64x4 r2 = r * r;
+
+  // 1/15!, 1/13!, ..., 1/3! and 1/16!, 1/14!, ..., 1/4!
+  f64x4 ps = r2 * -7.6471637318198160e-13 + 1.6059043836821613e-10;
+  ps = ps * r2 - 2.5052108385441720e-08;
+  ps = ps * r2 + 2.7557319223985893e-06;
+  ps = ps * r2 - 1.9841269841269841e-04;
+  ps = ps * r2 + 8.3333333333333333e-03;
+  ps = ps * r2 - 1.6666666666666667e-01;
+  const f64x4 sr = r + r * (r2 * ps);
+  f64x4 pc = r2 * 4.7794773323873853e-14 - 1.1470745597729725e-11;
+  pc = pc * r2 + 2.0876756987868099e-09;
+  pc = pc * r2 - 2.7557319223985891e-07;
+  pc = pc * r2 + 2.4801587301587302e-05;
+  pc = pc * r2 - 1.3888888888888889e-03;
+  pc = pc * r2 + 4.1666666666666667e-02;
+  const f64x4 cr = (1.0 - 0.5 * r2) + (r2 * r2) * pc;
+
+  // v - 2 rint(v/2) is 0 for even v and +-1 for odd, so its square is v's
+  // parity. Odd k swaps the pair; odd floor(k/2) negates sin and odd
+  // floor((k+1)/2) cos, those being rint(k/2 - 1/4) and rint(k/2 + 1/4).
+  const f64x4 kodd = k - 2.0 * ((k * 0.5 + kRound) - kRound);
+  const f64x4 lo = ((k * 0.5 - 0.25) + kRound) - kRound;
+  const f64x4 hi = ((k * 0.5 + 0.25) + kRound) - kRound;
+  const f64x4 lodd = lo - 2.0 * ((lo * 0.5 + kRound) - kRound);
+  const f64x4 hodd = hi - 2.0 * ((hi * 0.5 + kRound) - kRound);
+  const f64x4 swap = kodd * kodd;
+  s = (1.0 - 2.0 * (lodd * lodd)) * (sr + swap * (cr - sr));
+  c = (1.0 - 2.0 * (hodd * hodd)) * (cr + swap * (sr - cr));
+}
+
+}  // namespace astro::simd
+
+#endif  // ASTRO_SRC_SIMD_HPP
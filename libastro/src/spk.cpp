@@ -0,0 +1,323 @@
+#include "astro/spk.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "chebyshev.hpp"
+#include "mapped_file.hpp"
+
+// SPK reader. A DAF file is 1024-byte records: the file record (ID word, ND,
+// NI, FWARD, ...), then a doubly linked list of summary records from FWARD on,
+// each followed by its name record, with the segments' data between them,
+// addressed in 1-based doubles. SPK summaries are ND = 2 doubles (coverage)
+// and NI = 6 ints (target, center, frame, type, first and last address).
+//
+// A Type 2/3 segment is N records of RSIZE doubles -- MID, RADIUS, then the
+// coefficients of X, Y, Z (Type 3: and of VX, VY, VZ) -- covering INTLEN
+// seconds each from INIT, with INIT, INTLEN, RSIZE, N as its last four
+// doubles. Each record is a Chebyshev block of one subinterval spanning
+// MID +- RADIUS, so the DE kernels evaluate it unchanged.
+
+namespace astro {
+
+namespace {
+
+constexpr std::size_t kRecordBytes = 1024;
+constexpr std::int32_t kNd = 2;
+constexpr std::int32_t kNi = 6;
+constexpr std::size_t kSummaryDoubles = kNd + (kNi + 1) / 2;  // 5
+constexpr std::size_t kNameBytes = 8 * kSummaryDoubles;       // 40
+constexpr std::size_t kMaxSummaries = (kRecordBytes / 8 - 3) / kSummaryDoubles;
+constexpr int kJ2000 = 1;
+constexpr double kAuKm = 149597870.7;  // IAU 2012
+constexpr double kDaySeconds = 86400.0;
+constexpr int kMaxChain = 32;  // center hops before giving up (a cyclic file)
+
+// An indexed Type 2/3 segment, as state() reads it.
+struct Series {
+  int target = 0;
+  int center = 0;
+  int type = 0;
+  double begin = 0.0;
+  double end = 0.0;
+  const double* records = nullptr;  // first record, in the mapping
+  double init = 0.0;
+  double intlen = 0.0;
+  std::size_t rsize = 0;
+  std::size_t n = 0;
+  int ncf = 0;
+  cheb::GroupKernels<double> kernels{};
+};
+
+// One body's coverage flattened: elementary interval [bounds[i], bounds[i+1]]
+// is served by series[seg[i]], or by nothing when seg[i] < 0.
+struct Coverage {
+  std::vector<double> bounds;
+  std::vector<int> seg;
+};
+
+std::string trim(const char* p, std::size_t n) {
+  std::size_t end = n;
+  while (end > 0 && (p[end - 1] == ' ' || p[end - 1] == '\0')) --end;
+  return std::string(p, end);
+}
+
+// A DAF double holding an integer (record numbers, counts), or -1.
+long whole(double x) {
+  if (!(x >= 0.0 && x < 1e15) || x != std::floor(x)) return -1;
+  return static_cast<long>(x);
+}
+
+double seconds_past_j2000(TdbInstant t) {
+  return ((t.jd.whole - 2451545.0) + t.jd.frac) * kDaySeconds;
+}
+
+// Barycentric-style state of `s`'s target from its center at `et` (km,
+// km/s). kVelocity = false leaves `vel` untouched.
+template <bool kVelocity>
+void evaluate(const Series& s, double et, double pos[3], double vel[3]) {
+  const double at = std::floor((et - s.init) / s.intlen);
+  const std::size_t idx =
+      at <= 0.0 ? 0 : std::min(static_cast<std::size_t>(at), s.n - 1);
+  const double* rec = s.records + idx * s.rsize;
+  // The kernels take the fraction of the block's span, [0, 1].
+  const double x = std::clamp((et - rec[0]) / rec[1], -1.0, 1.0);
+  const double t0 = 0.5 * (x + 1.0);
+  const double span = 2.0 * rec[1];
+  if (s.type == 2) {
+    (kVelocity ? s.kernels.state : s.kernels.position)(rec + 2, t0, span, s.ncf,
+                                                       1, pos, vel);
+    return;
+  }
+  double unused[3];
+  s.kernels.position(rec + 2, t0, span, s.ncf, 1, pos, unused);
+  if constexpr (kVelocity)
+    s.kernels.position(rec + 2 + 3 * s.ncf, t0, span, s.ncf, 1, vel, unused);
+}
+
+}  // namespace
+
+struct SpkFile::Impl {
+  io::MappedFile map;
+  std::vector<SpkSegment> segments;
+  std::vector<Series> series;
+  std::unordered_map<int, Coverage> coverage;
+
+  // The series serving `body` at `et`, or nullptr -- with `gap` set when the
+  // body has coverage, just not at `et`.
+  const Series* find(int body, double et, bool& gap) const {
+    const auto it = coverage.find(body);
+    if (it == coverage.end()) return nullptr;
+    const Coverage& c = it->second;
+    const auto ub = std::ranges::upper_bound(c.bounds, et);
+    if (ub == c.bounds.begin() || (ub == c.bounds.end() && et > c.bounds.back())) {
+      gap = true;
+      return nullptr;
+    }
+    auto i = static_cast<std::size_t>(ub - c.bounds.begin()) - 1;
+    if (i == c.seg.size()) --i;  // exactly the last bound
+    if (c.seg[i] < 0) {
+      gap = true;
+      return nullptr;
+    }
+    return &series[static_cast<std::size_t>(c.seg[i])];
+  }
+
+  // `target` from `center` at `et`: each body's chain of segment centers is
+  // followed until the two meet, and the segments below the meeting point
+  // summed on either side.
+  template <bool kVelocity>
+  std::expected<StateVector, EphError> relative(int target, int center,
+                                                double et, Units units) const {
+    struct Chain {
+      int ids[kMaxChain + 1];
+      const Series* links[kMaxChain];
+      int length = 0;  // links; ids holds one more
+    };
+    bool gap = false;
+    auto climb = [&](int body, Chain& c) {
+      c.ids[0] = body;
+      while (c.length < kMaxChain) {
+        const Series* s = find(c.ids[c.length], et, gap);
+        if (!s) break;
+        c.links[c.length] = s;
+        c.ids[++c.length] = s->center;
+      }
+    };
+    Chain t, c;
+    climb(target, t);
+    climb(center, c);
+
+    for (int i = 0; i <= t.length; ++i) {
+      const int* meet = std::find(c.ids, c.ids + c.length + 1, t.ids[i]);
+      if (meet == c.ids + c.length + 1) continue;
+      StateVector out;
+      out.units = units;
+      double p[3], v[3];
+      for (int k = 0; k < i; ++k) {
+        evaluate<kVelocity>(*t.links[k], et, p, v);
+        for (std::size_t j = 0; j < 3; ++j) {
+          out.position[j] += p[j];
+          if constexpr (kVelocity) out.velocity[j] += v[j];
+        }
+      }
+      for (int k = 0; k < meet - c.ids; ++k) {
+        evaluate<kVelocity>(*c.links[k], et, p, v);
+        for (std::size_t j = 0; j < 3; ++j) {
+          out.position[j] -= p[j];
+          if constexpr (kVelocity) out.velocity[j] -= v[j];
+        }
+      }
+      if (units == Units::au) {
+        for (std::size_t j = 0; j < 3; ++j) {
+          out.position[j] /= kAuKm;
+          if constexpr (kVelocity) out.velocity[j] *= kDaySeconds / kAuKm;
+        }
+      }
+      return out;
+    }
+    return std::unexpected(gap ? EphError::epoch_out_of_range
+                               : EphError::body_not_available);
+  }
+};
+
+SpkFile::SpkFile() : impl_(std::make_unique<Impl>()) {}
+SpkFile::SpkFile(SpkFile&&) noexcept = default;
+SpkFile& SpkFile::operator=(SpkFile&&) noexcept = default;
+SpkFile::~SpkFile() = default;
+
+std::expected<SpkFile, EphError> SpkFile::open(const std::filesystem::path& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return std::unexpected(EphError::file_not_found);
+  SpkFile spk;
+  Impl& s = *spk.impl_;
+  const bool mapped = s.map.map(fd, false);
+  ::close(fd);
+  if (!mapped || s.map.size() < 2 * kRecordBytes)
+    return std::unexpected(EphError::bad_header);
+
+  const char* base = s.map.data();
+  const std::size_t size = s.map.size();
+  const auto* words = reinterpret_cast<const double*>(base);
+  std::int32_t nd, ni, fward;
+  std::memcpy(&nd, base + 8, 4);
+  std::memcpy(&ni, base + 12, 4);
+  std::memcpy(&fward, base + 76, 4);
+  if (std::memcmp(base, "DAF/SPK ", 8) != 0 || nd != kNd || ni != kNi ||
+      std::memcmp(base + 88, "LTL-IEEE", 8) != 0)
+    return std::unexpected(EphError::bad_header);
+
+  const std::size_t records = size / kRecordBytes;
+  long rec = fward;
+  for (std::size_t hops = 0; rec != 0; ++hops) {
+    // A summary record and its name record, inside the file, a finite list.
+    if (rec < 2 || static_cast<std::size_t>(rec) + 1 > records || hops > records)
+      return std::unexpected(EphError::bad_header);
+    const double* summary = words + (static_cast<std::size_t>(rec) - 1) * 128;
+    const char* names = base + static_cast<std::size_t>(rec) * kRecordBytes;
+    const long next = whole(summary[0]);
+    const long count = whole(summary[2]);
+    if (next < 0 || count < 0 || static_cast<std::size_t>(count) > kMaxSummaries)
+      return std::unexpected(EphError::bad_header);
+
+    for (std::size_t i = 0; i < static_cast<std::size_t>(count); ++i) {
+      const double* sum = summary + 3 + i * kSummaryDoubles;
+      std::int32_t ic[kNi];
+      std::memcpy(ic, sum + kNd, sizeof ic);
+      SpkSegment seg{.target = ic[0],
+                     .center = ic[1],
+                     .frame = ic[2],
+                     .type = ic[3],
+                     .begin = sum[0],
+                     .end = sum[1],
+                     .name = trim(names + i * kNameBytes, kNameBytes)};
+      const std::int32_t first = ic[4], last = ic[5];
+      if (first < 1 || last < first ||
+          static_cast<std::size_t>(last) * sizeof(double) > size)
+        return std::unexpected(EphError::bad_header);
+
+      if ((seg.type == 2 || seg.type == 3) && seg.frame == kJ2000) {
+        const auto length = static_cast<std::size_t>(last - first + 1);
+        const double* dir = words + last - 4;  // INIT, INTLEN, RSIZE, N
+        const long rsize = length >= 4 ? whole(dir[2]) : -1;
+        const long n = length >= 4 ? whole(dir[3]) : -1;
+        const long comps = seg.type == 2 ? 3 : 6;
+        if (rsize < 2 + comps || n < 1 || (rsize - 2) % comps != 0 ||
+            !(dir[1] > 0.0) ||
+            static_cast<std::size_t>(rsize * n) + 4 != length)
+          return std::unexpected(EphError::bad_header);
+        const int ncf = static_cast<int>((rsize - 2) / comps);
+        if (ncf <= cheb::kMaxCoeff && seg.begin < seg.end) {
+          s.series.push_back({.target = seg.target,
+                              .center = seg.center,
+                              .type = seg.type,
+                              .begin = seg.begin,
+                              .end = seg.end,
+                              .records = words + first - 1,
+                              .init = dir[0],
+                              .intlen = dir[1],
+                              .rsize = static_cast<std::size_t>(rsize),
+                              .n = static_cast<std::size_t>(n),
+                              .ncf = ncf,
+                              .kernels = cheb::kernels_for<double>(ncf, 3)});
+          seg.indexed = true;
+        }
+      }
+      s.segments.push_back(std::move(seg));
+    }
+    rec = next;
+  }
+
+  // Flatten each body's segments into elementary intervals between their
+  // coverage bounds, each served by the last segment in the file covering it.
+  for (std::size_t k = 0; k < s.series.size(); ++k) {
+    Coverage& c = s.coverage[s.series[k].target];
+    c.bounds.push_back(s.series[k].begin);
+    c.bounds.push_back(s.series[k].end);
+  }
+  for (auto& [body, c] : s.coverage) {
+    std::ranges::sort(c.bounds);
+    c.bounds.erase(std::unique(c.bounds.begin(), c.bounds.end()), c.bounds.end());
+    c.seg.assign(c.bounds.size() - 1, -1);
+    for (std::size_t k = 0; k < s.series.size(); ++k) {
+      const Series& x = s.series[k];
+      if (x.target != body) continue;
+      const auto lo = std::ranges::lower_bound(c.bounds, x.begin) - c.bounds.begin();
+      const auto hi = std::ranges::lower_bound(c.bounds, x.end) - c.bounds.begin();
+      for (auto i = lo; i < hi; ++i) c.seg[static_cast<std::size_t>(i)] = static_cast<int>(k);
+    }
+  }
+  return spk;
+}
+
+std::span<const SpkSegment> SpkFile::segments() const noexcept {
+  return impl_->segments;
+}
+
+bool SpkFile::covers(int body, TdbInstant t) const noexcept {
+  bool gap = false;
+  return impl_->find(body, seconds_past_j2000(t), gap) != nullptr;
+}
+
+std::expected<StateVector, EphError> SpkFile::state(int target, int center,
+                                                    TdbInstant t,
+                                                    Units units) const {
+  return impl_->relative<true>(target, center, seconds_past_j2000(t), units);
+}
+
+std::expected<Vec3, EphError> SpkFile::position(int target, int center,
+                                                TdbInstant t, Units units) const {
+  auto st = impl_->relative<false>(target, center, seconds_past_j2000(t), units);
+  if (!st) return std::unexpected(st.error());
+  return st->position;
+}
+
+}  // namespace astro
@@ -0,0 +1,261 @@
+#include "astro/tdb_table.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <numbers>
+#include <string_view>
+
+#include "astro/ephemeris.hpp"
+#include "astro/time.hpp"
+#include "chebyshev.hpp"
+#include "mapped_file.hpp"
+
+namespace astro {
+
+namespace {
+
+using io::FileHandle;
+using io::PartialFile;
+
+// IAU 2006 B3 defining constants: TT and TDB rates against TCG and TCB.
+constexpr double kLg = 6.969290134e-10;
+constexpr double kLb = 1.550519768e-8;
+
+// The bodies whose potential the geocentre feels, with their GM constant in
+// the DE file. The Moon's comes from GMB and EMRAT.
+struct Source {
+  Point point;
+  std::string_view gm;
+};
+constexpr std::array<Source, 9> kSources = {{
+    {Point::sun, "GMS"},     {Point::mercury, "GM1"}, {Point::venus, "GM2"},
+    {Point::mars, "GM4"},    {Point::jupiter, "GM5"}, {Point::saturn, "GM6"},
+    {Point::uranus, "GM7"},  {Point::neptune, "GM8"}, {Point::pluto, "GM9"},
+}};
+
+// save() file, little-endian: this header, then the coefficients.
+struct FileHeader {
+  char magic[8];       // kMagic
+  std::uint32_t version;
+  std::uint32_t coeff;  // per interval
+  std::uint64_t intervals;
+  double interval_days;
+  double begin;
+  std::int32_t denum;
+  std::int32_t reserved;
+  double eph_begin;
+  double eph_end;
+};
+constexpr char kMagic[8] = {'A', 'S', 'T', 'R', 'O', 'T', 'D', 'B'};
+constexpr std::uint32_t kVersion = 1;
+
+}  // namespace
+
+std::expected<TdbTtTable, EphError> TdbTtTable::generate(const Ephemeris& eph) {
+  const Constants& c = eph.constants();
+  const auto au = c.au_km(), emrat = c.earth_moon_ratio();
+  const auto clight = c.speed_of_light_km_s(), gmb = c.gm_earth_moon();
+  std::array<double, kSources.size()> gm{};
+  for (std::size_t i = 0; i < kSources.size(); ++i) {
+    const auto v = c.get(kSources[i].gm);
+    if (!v) return std::unexpected(EphError::unknown_constant);
+    gm[i] = *v;
+  }
+  if (!au || !emrat || !clight || !gmb)
+    return std::unexpected(EphError::unknown_constant);
+  const double gm_moon = *gmb / (1.0 + *emrat);
+  const double c_au_day = *clight * 86400.0 / *au;
+  const double inv_c2 = 1.0 / (c_au_day * c_au_day);
+
+  // d(TDB - TT)/dTDB at TDB `jd`, from one snapshot (AU, days).
+  auto rate = [&](double jd) -> std::expected<double, EphError> {
+    auto snap = eph.snapshot(TdbInstant{JulianDate{jd}}, Units::au);
+    if (!snap) return std::unexpected(snap.error());
+    const StateVector& e = (*snap)[Point::earth];
+    const StateVector& m = (*snap)[Point::moon];
+    const auto dist = [&](const Vec3& p) {
+      const double d[3] = {p[0] - e.position[0], p[1] - e.position[1],
+                           p[2] - e.position[2]};
+      return std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+    };
+    double u = gm_moon / dist(m.position);
+    for (std::size_t i = 0; i < kSources.size(); ++i)
+      u += gm[i] / dist((*snap)[kSources[i].point].position);
+    const Vec3& v = e.velocity;
+    const double v2 = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+    const double w = (0.5 * v2 + u) * inv_c2;
+    // A body absent from a subset file comes back NaN.
+    if (std::isnan(w)) return std::unexpected(EphError::body_not_available);
+    return ((w - (kLb - kLg)) - kLg * w) / (1.0 - kLb);
+  };
+
+  const Header& h = eph.header();
+  const auto n =
+      static_cast<std::size_t>((h.jd_end - h.jd_begin) / kIntervalDays);
+  if (n == 0) return std::unexpected(EphError::epoch_out_of_range);
+
+  TdbTtTable table;
+  table.begin_ = h.jd_begin;
+  table.denum_ = h.denum;
+  table.eph_begin_ = h.jd_begin;
+  table.eph_end_ = h.jd_end;
+  table.coeff_.assign(n * kCoeff, 0.0);
+
+  // Per interval: the rate at kNodes Chebyshev nodes -> its coefficients ->
+  // the integral's, in seconds, with the constant term chained so each
+  // interval starts where the last one ended.
+  constexpr int kNodes = kCoeff - 1;
+  std::array<double, kNodes> x{};
+  for (int k = 0; k < kNodes; ++k)
+    x[k] = std::cos(std::numbers::pi * (k + 0.5) / kNodes);
+  const double half = 0.5 * kIntervalDays;
+  double start = 0.0;  // TDB - TT at the interval's start, before fitting
+  for (std::size_t i = 0; i < n; ++i) {
+    const double mid =
+        h.jd_begin + (static_cast<double>(i) + 0.5) * kIntervalDays;
+    std::array<double, kNodes> f{};
+    for (int k = 0; k < kNodes; ++k) {
+      auto r = rate(mid + half * x[k]);
+      if (!r) return std::unexpected(r.error());
+      f[k] = *r;
+    }
+    std::array<double, kNodes + 1> a{};  // rate, with a[kNodes] = 0
+    for (int j = 0; j < kNodes; ++j) {
+      double sum = 0.0;
+      for (int k = 0; k < kNodes; ++k)
+        sum += f[k] * std::cos(std::numbers::pi * j * (k + 0.5) / kNodes);
+      a[j] = (j == 0 ? 1.0 : 2.0) * sum / kNodes;
+    }
+    double* out = &table.coeff_[i * kCoeff];
+    const double scale = half * 86400.0;  // d/dx -> seconds
+    out[1] = scale * (a[0] - 0.5 * a[2]);
+    for (int j = 2; j < kCoeff; ++j)
+      out[j] =
+          scale * (a[j - 1] - (j + 1 <= kNodes ? a[j + 1] : 0.0)) / (2.0 * j);
+    double at_minus1 = 0.0, at_plus1 = 0.0;  // the series at x = -1, +1
+    for (int j = 1; j < kCoeff; ++j) {
+      at_minus1 += (j % 2 ? -out[j] : out[j]);
+      at_plus1 += out[j];
+    }
+    out[0] = start - at_minus1;
+    start = out[0] + at_plus1;
+  }
+
+  // Constant of integration and residual drift: least squares of the table
+  // minus the series at the interval midpoints, removed from each interval
+  // (the drift's slope enters the T_1 term).
+  const double t_mid = 0.5 * (h.jd_begin + table.jd_end());
+  double sd = 0.0, sdt = 0.0, stt = 0.0;
+  for (std::size_t i = 0; i < n; ++i) {
+    const double mid =
+        h.jd_begin + (static_cast<double>(i) + 0.5) * kIntervalDays;
+    // At x = 0 the series is c0 - c2 + c4 - ...
+    double value = 0.0;
+    for (int j = 0; j < kCoeff; j += 2)
+      value += (j % 4 ? -1.0 : 1.0) * table.coeff_[i * kCoeff + j];
+    const double d = value - astro::tdb_minus_tt_seconds(mid);
+    const double dt = mid - t_mid;
+    sd += d;
+    sdt += d * dt;
+    stt += dt * dt;
+  }
+  const double offset = sd / static_cast<double>(n);
+  const double slope = stt > 0.0 ? sdt / stt : 0.0;  // seconds per day
+  for (std::size_t i = 0; i < n; ++i) {
+    const double mid =
+        h.jd_begin + (static_cast<double>(i) + 0.5) * kIntervalDays;
+    table.coeff_[i * kCoeff] -= offset + slope * (mid - t_mid);
+    table.coeff_[i * kCoeff + 1] -= slope * half;
+  }
+  return table;
+}
+
+std::expected<TdbTtTable, EphError> TdbTtTable::load(
+    const std::filesystem::path& path) {
+  const FileHandle file(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+  if (file.get() < 0) return std::unexpected(EphError::file_not_found);
+  FileHeader fh;
+  if (!file.read_at(&fh, sizeof fh, 0) ||
+      std::memcmp(fh.magic, kMagic, sizeof kMagic) != 0 ||
+      fh.version != kVersion || fh.coeff != kCoeff ||
+      fh.interval_days != kIntervalDays || fh.intervals == 0 ||
+      fh.intervals > (std::uint64_t{1} << 32))
+    return std::unexpected(EphError::bad_header);
+  std::error_code ec;
+  const auto bytes = std::filesystem::file_size(path, ec);
+  const std::uint64_t want = sizeof fh + fh.intervals * kCoeff * sizeof(double);
+  if (ec || bytes != want) return std::unexpected(EphError::bad_header);
+
+  TdbTtTable table;
+  table.begin_ = fh.begin;
+  table.denum_ = fh.denum;
+  table.eph_begin_ = fh.eph_begin;
+  table.eph_end_ = fh.eph_end;
+  table.coeff_.resize(static_cast<std::size_t>(fh.intervals) * kCoeff);
+  if (!file.read_at(table.coeff_.data(), table.coeff_.size() * sizeof(double),
+                    sizeof fh))
+    return std::unexpected(EphError::bad_header);
+  return table;
+}
+
+std::expected<void, EphError> TdbTtTable::save(
+    const std::filesystem::path& path) const {
+  FileHeader fh{};
+  std::memcpy(fh.magic, kMagic, sizeof kMagic);
+  fh.version = kVersion;
+  fh.coeff = kCoeff;
+  fh.intervals = intervals();
+  fh.interval_days = kIntervalDays;
+  fh.begin = begin_;
+  fh.denum = denum_;
+  fh.eph_begin = eph_begin_;
+  fh.eph_end = eph_end_;
+  PartialFile file(path);
+  if (!file.is_open() || !file.write(&fh, sizeof fh) ||
+      !file.write(coeff_.data(), coeff_.size() * sizeof(double)) ||
+      !file.commit())
+    return std::unexpected(EphError::io_error);
+  return {};
+}
+
+std::expected<TdbTtTable, EphError> TdbTtTable::cached(
+    const Ephemeris& eph, const std::filesystem::path& path) {
+  const Header& h = eph.header();
+  if (auto t = load(path);
+      t && t->denum_ == h.denum && t->eph_begin_ == h.jd_begin &&
+      t->eph_end_ == h.jd_end)
+    return t;
+  auto t = generate(eph);
+  if (t) (void)t->save(path);
+  return t;
+}
+
+bool TdbTtTable::covers(double jd_tt) const noexcept {
+  return !empty() && jd_tt >= begin_ && jd_tt <= jd_end();
+}
+
+double TdbTtTable::evaluate(double whole, double frac) const noexcept {
+  const double x = ((whole - begin_) + frac) / kIntervalDays;
+  const auto i = std::min(static_cast<std::size_t>(x), intervals() - 1);
+  double value[3], unused[3];
+  cheb::interpolate<kCoeff, false, double, 1>(
+      &coeff_[i * kCoeff], x - static_cast<double>(i), kIntervalDays, kCoeff,
+      1, value, unused);
+  return value[0];
+}
+
+double TdbTtTable::tdb_minus_tt_seconds(double jd_tt) const noexcept {
+  if (!covers(jd_tt)) return astro::tdb_minus_tt_seconds(jd_tt);
+  return evaluate(jd_tt, 0.0);
+}
+
+double TdbTtTable::tdb_minus_tt_seconds(TtInstant t) const noexcept {
+  const double jd_tt = t.jd.value();
+  if (!covers(jd_tt)) return astro::tdb_minus_tt_seconds(jd_tt);
+  return evaluate(t.jd.whole, t.jd.frac);
+}
+
+}  // namespace astro
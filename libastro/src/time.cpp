@@ -1,6 +1,16 @@
 #include "astro/time.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <utility>
+
+#include "astro/earth_orientation.hpp"
+#include "astro/tdb_table.hpp"
+#include "simd.hpp"
 
 namespace astro {
 
@@ -27,6 +37,168 @@ constexpr LeapEntry kLeap[] = {
     {2454832.5, 34.0}, {2456109.5, 35.0}, {2457204.5, 36.0}, {2457754.5, 37.0},
     {5373119.5, 37.0}};  // sentinel (far-future, carries latest value)
 
+constexpr std::size_t kLeapCount = std::size(kLeap);
+
+// Index of the kLeap entry in effect at `jd_utc`: the last one strictly before
+// it (the legacy lookup's rule), or the first before 1972. The far-future
+// sentinel means a date past the last leap second still finds an entry.
+std::size_t leap_index(double jd_utc) {
+  const LeapEntry* next = std::lower_bound(
+      std::begin(kLeap), std::end(kLeap), jd_utc,
+      [](const LeapEntry& l, double jd) { return l.jd_utc < jd; });
+  return next == std::begin(kLeap) ? 0 : next - std::begin(kLeap) - 1;
+}
+
+// leap_index() for a run of instants: entry i holds on
+// (kLeap[i].jd_utc, kLeap[i + 1].jd_utc], so the search is skipped while
+// consecutive instants stay inside the last interval found.
+class LeapCursor {
+ public:
+  double operator()(double jd_utc) noexcept {
+    if (!(jd_utc > lo_ && jd_utc <= hi_)) {
+      constexpr double kInf = std::numeric_limits<double>::infinity();
+      i_ = leap_index(jd_utc);
+      lo_ = i_ == 0 ? -kInf : kLeap[i_].jd_utc;
+      hi_ = i_ + 1 < kLeapCount ? kLeap[i_ + 1].jd_utc : kInf;
+    }
+    return kLeap[i_].tai_utc;
+  }
+
+ private:
+  std::size_t i_ = 0;
+  double lo_ = 1.0, hi_ = 0.0;  // empty: the first call searches
+};
+
+TimeScaleSet time_scales(double jd_utc, double leap_seconds, double ut1_utc) {
+  TimeScaleSet ts;
+  ts.jd_utc = jd_utc;
+  ts.leap_seconds = leap_seconds;
+  // Keep the offset in the fractional part rather than folding it into a single
+  // double: preserves precision near JD ~2.4e6 (the whole point of the two-part
+  // form; research doc 1.4).
+  ts.tt = TtInstant{JulianDate{jd_utc, (ts.leap_seconds + kTtMinusTai) / 86400.0}};
+  ts.ut1 = Ut1Instant{JulianDate{jd_utc, ut1_utc / 86400.0}};
+  ts.delta_t = DeltaT{kTtMinusTai + ts.leap_seconds - ut1_utc};
+  return ts;
+}
+
+// tdb_minus_tt_seconds() at jd_tt[0..n), n <= 4, one vector for all four
+// (short blocks padded with their first date).
+void tdb_minus_tt_block(const double* jd_tt, std::size_t n, double* out) {
+  using simd::f64x4;
+  f64x4 jd{};
+  for (std::size_t j = 0; j < 4; ++j) jd[j] = jd_tt[j < n ? j : 0];
+  const f64x4 t = (jd - 2451545.0) * (1.0 / 36525.0);
+  // The seven terms of tdb_minus_tt_seconds(double), in its order.
+  f64x4 s[7];
+  simd::sin(628.3076 * t + 6.2401, s[0]);
+  simd::sin(575.3385 * t + 4.2970, s[1]);
+  simd::sin(1256.6152 * t + 6.1969, s[2]);
+  simd::sin(606.9777 * t + 4.0212, s[3]);
+  simd::sin(52.9691 * t + 0.4444, s[4]);
+  simd::sin(21.3299 * t + 5.5431, s[5]);
+  simd::sin(628.3076 * t + 4.2490, s[6]);
+  const f64x4 sum = 0.001657 * s[0] + 0.000022 * s[1] + 0.000014 * s[2] +
+                    0.000005 * s[3] + 0.000005 * s[4] + 0.000002 * s[5] +
+                    0.000010 * t * s[6];
+  for (std::size_t j = 0; j < n; ++j) out[j] = sum[j];
+}
+
+bool sized(std::size_t n, std::initializer_list<std::size_t> columns) {
+  return std::ranges::all_of(columns,
+                             [n](std::size_t c) { return c == 0 || c == n; });
+}
+
+// The batch utc_time_scales() over any (TAI - UTC, UT1 - UTC) source:
+// `lookup(i)` returns the pair for jd_utc[i].
+template <class Lookup>
+std::expected<void, EphError> batch_time_scales(std::span<const double> jd_utc,
+                                                const TimeScaleColumns& out,
+                                                Lookup&& lookup) {
+  const std::size_t n = jd_utc.size();
+  if (!sized(n, {out.leap_seconds.size(), out.tt_frac.size(),
+                 out.ut1_frac.size(), out.tdb_frac.size(), out.delta_t.size()}))
+    return std::unexpected(EphError::invalid_argument);
+  for (std::size_t i = 0; i < n; i += 4) {
+    const std::size_t m = std::min<std::size_t>(4, n - i);
+    double tt_frac[4], jd_tt[4], dtdb[4];
+    for (std::size_t j = 0; j < m; ++j) {
+      const std::size_t k = i + j;
+      const auto [leap, ut1_utc] = lookup(k);
+      // As time_scales(), term for term.
+      tt_frac[j] = (leap + kTtMinusTai) / 86400.0;
+      jd_tt[j] = jd_utc[k] + tt_frac[j];
+      if (!out.leap_seconds.empty()) out.leap_seconds[k] = leap;
+      if (!out.tt_frac.empty()) out.tt_frac[k] = tt_frac[j];
+      if (!out.ut1_frac.empty()) out.ut1_frac[k] = ut1_utc / 86400.0;
+      if (!out.delta_t.empty()) out.delta_t[k] = kTtMinusTai + leap - ut1_utc;
+    }
+    if (out.tdb_frac.empty()) continue;
+    tdb_minus_tt_block(jd_tt, m, dtdb);
+    for (std::size_t j = 0; j < m; ++j)
+      out.tdb_frac[i + j] = tt_frac[j] + dtdb[j] / 86400.0;
+  }
+  return {};
+}
+
+// Gregorian date of Julian day number `j` (the integer part of jd + 0.5).
+// NOVAS `cal_date`'s integer algorithm.
+void civil_day(long j, int& year, int& month, int& day) {
+  long k = j + 68569L;
+  const long n = 4L * k / 146097L;
+  k = k - (146097L * n + 3L) / 4L;
+  const long m = 4000L * (k + 1L) / 1461001L;
+  k = k - 1461L * m / 4L + 31L;
+
+  long mo = 80L * k / 2447L;
+  day = static_cast<int>(k - 2447L * mo / 80L);
+  k = mo / 11L;
+  mo = mo + 2L - 12L * k;
+  month = static_cast<int>(mo);
+  year = static_cast<int>(100L * (n - 49L) + m + k);
+}
+
+// ---- ISO 8601 ----
+
+constexpr std::int64_t kNsPerDay = 86'400'000'000'000;
+constexpr std::int64_t kPow10[10] = {1,         10,        100,      1000,
+                                     10000,     100000,    1000000,  10000000,
+                                     100000000, 1000000000};
+
+bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+// The `n` digits at `p` as a number, or -1 if any is not a digit. The caller
+// has checked that they are in range.
+int fixed_digits(const char* p, int n) {
+  int v = 0;
+  for (int i = 0; i < n; ++i) {
+    if (!is_digit(p[i])) return -1;
+    v = v * 10 + (p[i] - '0');
+  }
+  return v;
+}
+
+// "<sep>dd" at `p`, e.g. "-07" or ":30": the number, or -1.
+int field(const char* p, const char* last, char sep) {
+  if (last - p < 3 || p[0] != sep) return -1;
+  return fixed_digits(p + 1, 2);
+}
+
+int days_in_month(long year, int month) {
+  constexpr int kDays[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  const bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+  return month == 2 && leap ? 29 : kDays[month - 1];
+}
+
+// `v` as exactly `n` digits (zero-padded; higher digits dropped) at `p`.
+char* put_digits(char* p, std::uint64_t v, int n) {
+  for (int i = n - 1; i >= 0; --i) {
+    p[i] = static_cast<char>('0' + v % 10);
+    v /= 10;
+  }
+  return p + n;
+}
+
 }  // namespace
 
 double julian_date(int year, int month, int day, double hour) {
@@ -40,45 +212,157 @@ double julian_date(int year, int month, int day, double hour) {
 
 CivilDate calendar_date(double jd) {
   const double djd = jd + 0.5;
-  const long j = static_cast<long>(djd);
-
   CivilDate out;
   out.hour = std::fmod(djd, 1.0) * 24.0;
+  civil_day(static_cast<long>(djd), out.year, out.month, out.day);
+  return out;
+}
 
-  long k = j + 68569L;
-  const long n = 4L * k / 146097L;
-  k = k - (146097L * n + 3L) / 4L;
-  const long m = 4000L * (k + 1L) / 1461001L;
-  k = k - 1461L * m / 4L + 31L;
+std::from_chars_result parse_utc_timestamp(const char* first, const char* last,
+                                           UtcTimestamp& out) noexcept {
+  const std::from_chars_result fail{first, std::errc::invalid_argument};
+  const char* p = first;
 
-  long month = 80L * k / 2447L;
-  out.day = static_cast<int>(k - 2447L * month / 80L);
-  k = month / 11L;
-  month = month + 2L - 12L * k;
-  out.month = static_cast<int>(month);
-  out.year = static_cast<int>(100L * (n - 49L) + m + k);
-  return out;
+  // Year: four digits, or a sign and four to ten.
+  const bool sign = p != last && (*p == '+' || *p == '-');
+  const bool negative = sign && *p == '-';
+  if (sign) ++p;
+  const char* digits = p;
+  long year = 0;
+  while (p != last && is_digit(*p) && p - digits < 10)
+    year = year * 10 + (*p++ - '0');
+  if (p - digits < 4 || (!sign && p - digits != 4)) return fail;
+  if (negative) year = -year;
+  if (year < std::numeric_limits<int>::min() ||
+      year > std::numeric_limits<int>::max())
+    return fail;
+
+  UtcTimestamp t;
+  t.year = static_cast<int>(year);
+  t.month = field(p, last, '-');
+  if (t.month < 1 || t.month > 12) return fail;
+  t.day = field(p + 3, last, '-');
+  if (t.day < 1 || t.day > days_in_month(year, t.month)) return fail;
+  p += 6;
+
+  // Each later part is taken only when complete, like std::from_chars's
+  // longest match: "2026-07-11T" stops before the 'T'. A complete part out of
+  // range fails the whole parse.
+  if (last - p >= 6 && (*p == 'T' || *p == ' ')) {
+    const int hour = fixed_digits(p + 1, 2), minute = field(p + 3, last, ':');
+    if (hour >= 0 && minute >= 0) {
+      if (hour > 23 || minute > 59) return fail;
+      t.hour = hour;
+      t.minute = minute;
+      p += 6;
+      if (const int second = field(p, last, ':'); second >= 0) {
+        if (second > 60 || (second == 60 && (hour != 23 || minute != 59)))
+          return fail;
+        t.second = second;
+        p += 3;
+        if (last - p >= 2 && (*p == '.' || *p == ',') && is_digit(p[1])) {
+          const char* f = ++p;
+          std::int32_t ns = 0;
+          while (p != last && is_digit(*p)) {
+            if (p - f == 9) return fail;
+            ns = ns * 10 + (*p++ - '0');
+          }
+          t.nanosecond = static_cast<std::int32_t>(ns * kPow10[9 - (p - f)]);
+        }
+      }
+    }
+  }
+  if (p != last && *p == 'Z') ++p;
+  out = t;
+  return {p, std::errc{}};
+}
+
+std::to_chars_result format_utc_timestamp(char* first, char* last,
+                                          const UtcTimestamp& t,
+                                          int digits) noexcept {
+  digits = std::clamp(digits, 0, 9);
+  char buf[kUtcTimestampMaxChars];
+  char* p = buf;
+  if (t.year >= 0 && t.year <= 9999) {
+    p = put_digits(p, static_cast<std::uint64_t>(t.year), 4);
+  } else {
+    *p++ = t.year < 0 ? '-' : '+';
+    const auto year = static_cast<std::uint64_t>(
+        t.year < 0 ? -static_cast<std::int64_t>(t.year) : t.year);
+    int n = 4;
+    while (n < 10 && year >= static_cast<std::uint64_t>(kPow10[n])) ++n;
+    p = put_digits(p, year, n);
+  }
+  *p++ = '-';
+  p = put_digits(p, static_cast<std::uint64_t>(t.month), 2);
+  *p++ = '-';
+  p = put_digits(p, static_cast<std::uint64_t>(t.day), 2);
+  *p++ = 'T';
+  p = put_digits(p, static_cast<std::uint64_t>(t.hour), 2);
+  *p++ = ':';
+  p = put_digits(p, static_cast<std::uint64_t>(t.minute), 2);
+  *p++ = ':';
+  p = put_digits(p, static_cast<std::uint64_t>(t.second), 2);
+  if (digits > 0) {
+    *p++ = '.';
+    p = put_digits(p, static_cast<std::uint64_t>(t.nanosecond) /
+                          static_cast<std::uint64_t>(kPow10[9 - digits]),
+                   digits);
+  }
+  *p++ = 'Z';
+
+  const auto n = p - buf;
+  if (last - first < n) return {last, std::errc::value_too_large};
+  std::copy(buf, p, first);
+  return {first + n, std::errc{}};
+}
+
+JulianDate julian_date(const UtcTimestamp& t) noexcept {
+  // The time of day in nanoseconds is exact in a double (< 2^47), so the
+  // fraction is rounded once.
+  const std::int64_t ns =
+      ((std::int64_t{t.hour} * 60 + t.minute) * 60 + t.second) * kPow10[9] +
+      t.nanosecond;
+  return JulianDate{julian_date(t.year, t.month, t.day),
+                    static_cast<double>(ns) / static_cast<double>(kNsPerDay)};
+}
+
+UtcTimestamp utc_timestamp(JulianDate jd_utc, int digits) noexcept {
+  digits = std::clamp(digits, 0, 9);
+  // Day number and fraction of the day from 0h; whole + 0.5 and the floors
+  // are exact, so only the sum with `frac` rounds.
+  const double w = jd_utc.whole + 0.5;
+  double day = std::floor(w);
+  double f = (w - day) + jd_utc.frac;
+  const double carry = std::floor(f);
+  day += carry;
+  f -= carry;
+
+  const std::int64_t unit = kPow10[9 - digits];
+  const double units_per_day = static_cast<double>(kNsPerDay / unit);
+  std::int64_t ns = std::llround(f * units_per_day) * unit;
+  if (ns >= kNsPerDay) {
+    day += 1.0;
+    ns -= kNsPerDay;
+  }
+
+  UtcTimestamp t;
+  civil_day(static_cast<long>(day), t.year, t.month, t.day);
+  t.nanosecond = static_cast<std::int32_t>(ns % kPow10[9]);
+  std::int64_t s = ns / kPow10[9];
+  t.second = static_cast<int>(s % 60);
+  s /= 60;
+  t.minute = static_cast<int>(s % 60);
+  t.hour = static_cast<int>(s / 60);
+  return t;
 }
 
 double tai_minus_utc(double jd_utc) {
-  // Advance while the *next* entry has already taken effect, mirroring the
-  // legacy lookup. `kLeap` has a far-future sentinel, so leap[1] is always safe.
-  const LeapEntry* leap = kLeap;
-  while (leap[1].jd_utc < jd_utc) ++leap;
-  return leap->tai_utc;
+  return kLeap[leap_index(jd_utc)].tai_utc;
 }
 
 TimeScaleSet utc_time_scales(double jd_utc, double ut1_utc) {
-  TimeScaleSet ts;
-  ts.jd_utc = jd_utc;
-  ts.leap_seconds = tai_minus_utc(jd_utc);
-  // Keep the offset in the fractional part rather than folding it into a single
-  // double: preserves precision near JD ~2.4e6 (the whole point of the two-part
-  // form; research doc 1.4).
-  ts.tt = TtInstant{JulianDate{jd_utc, (ts.leap_seconds + kTtMinusTai) / 86400.0}};
-  ts.ut1 = Ut1Instant{JulianDate{jd_utc, ut1_utc / 86400.0}};
-  ts.delta_t = DeltaT{kTtMinusTai + ts.leap_seconds - ut1_utc};
-  return ts;
+  return time_scales(jd_utc, tai_minus_utc(jd_utc), ut1_utc);
 }
 
 TimeScaleSet utc_time_scales(int year, int month, int day, double hour,
@@ -86,6 +370,16 @@ TimeScaleSet utc_time_scales(int year, int month, int day, double hour,
   return utc_time_scales(julian_date(year, month, day, hour), ut1_utc);
 }
 
+TimeScaleSet utc_time_scales(double jd_utc, const EarthOrientationTable& eop) {
+  return time_scales(jd_utc, eop.tai_minus_utc(jd_utc),
+                     eop.at(jd_utc).value_or(EarthOrientation{}).ut1_utc);
+}
+
+TimeScaleSet utc_time_scales(int year, int month, int day, double hour,
+                             const EarthOrientationTable& eop) {
+  return utc_time_scales(julian_date(year, month, day, hour), eop);
+}
+
 double tdb_minus_tt_seconds(double jd_tt) {
   const double t = (jd_tt - 2451545.0) / 36525.0;
   return 0.001657 * std::sin(628.3076 * t + 6.2401) +
@@ -102,4 +396,80 @@ TdbInstant tdb_from_tt(TtInstant t) {
   return TdbInstant{JulianDate{jd_tt, tdb_minus_tt_seconds(jd_tt) / 86400.0}};
 }
 
+TdbInstant tdb_from_tt(TtInstant t, const TdbTtTable& table) {
+  const double jd_tt = t.jd.value();
+  return TdbInstant{JulianDate{jd_tt, table.tdb_minus_tt_seconds(t) / 86400.0}};
+}
+
+std::expected<void, EphError> utc_time_scales(std::span<const double> jd_utc,
+                                              std::span<const double> ut1_utc,
+                                              const TimeScaleColumns& out) {
+  if (!sized(jd_utc.size(), {ut1_utc.size()}))  // empty: 0 throughout
+    return std::unexpected(EphError::invalid_argument);
+  LeapCursor leap;
+  return batch_time_scales(jd_utc, out, [&](std::size_t i) {
+    return std::pair{leap(jd_utc[i]), ut1_utc.empty() ? 0.0 : ut1_utc[i]};
+  });
+}
+
+std::expected<void, EphError> utc_time_scales(std::span<const double> jd_utc,
+                                              const TimeScaleColumns& out) {
+  return utc_time_scales(jd_utc, std::span<const double>{}, out);
+}
+
+std::expected<void, EphError> utc_time_scales(std::span<const double> jd_utc,
+                                              const EarthOrientationTable& eop,
+                                              const TimeScaleColumns& out) {
+  return batch_time_scales(jd_utc, out, [&](std::size_t i) {
+    const double jd = jd_utc[i];
+    return std::pair{eop.tai_minus_utc(jd),
+                     eop.at(jd).value_or(EarthOrientation{}).ut1_utc};
+  });
+}
+
+std::expected<void, EphError> tdb_minus_tt_seconds(std::span<const double> jd_tt,
+                                                   std::span<double> seconds) {
+  if (seconds.size() != jd_tt.size())
+    return std::unexpected(EphError::invalid_argument);
+  for (std::size_t i = 0; i < jd_tt.size(); i += 4)
+    tdb_minus_tt_block(&jd_tt[i], std::min<std::size_t>(4, jd_tt.size() - i),
+                       &seconds[i]);
+  return {};
+}
+
+std::expected<void, EphError> tdb_from_tt(std::span<const double> tt_whole,
+                                          std::span<const double> tt_frac,
+                                          std::span<double> tdb_frac) {
+  const std::size_t n = tt_whole.size();
+  if (tdb_frac.size() != n || !sized(n, {tt_frac.size()}))
+    return std::unexpected(EphError::invalid_argument);
+  for (std::size_t i = 0; i < n; i += 4) {
+    const std::size_t m = std::min<std::size_t>(4, n - i);
+    double frac[4], jd_tt[4], dtdb[4];
+    for (std::size_t j = 0; j < m; ++j) {
+      frac[j] = tt_frac.empty() ? 0.0 : tt_frac[i + j];
+      jd_tt[j] = tt_whole[i + j] + frac[j];
+    }
+    tdb_minus_tt_block(jd_tt, m, dtdb);
+    for (std::size_t j = 0; j < m; ++j)
+      tdb_frac[i + j] = frac[j] + dtdb[j] / 86400.0;
+  }
+  return {};
+}
+
+std::expected<void, EphError> tdb_from_tt(std::span<const double> tt_whole,
+                                          std::span<const double> tt_frac,
+                                          std::span<double> tdb_frac,
+                                          const TdbTtTable& table) {
+  const std::size_t n = tt_whole.size();
+  if (tdb_frac.size() != n || !sized(n, {tt_frac.size()}))
+    return std::unexpected(EphError::invalid_argument);
+  for (std::size_t i = 0; i < n; ++i) {
+    const double frac = tt_frac.empty() ? 0.0 : tt_frac[i];
+    tdb_frac[i] = frac + table.tdb_minus_tt_seconds(
+                             TtInstant{JulianDate{tt_whole[i], frac}}) / 86400.0;
+  }
+  return {};
+}
+
 }  // namespace astro
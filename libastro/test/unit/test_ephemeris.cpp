@@ -3,10 +3,23 @@
 // by CMake when data/JPLEPH exists); otherwise those checks are skipped and the
 // always-runnable checks still execute.
 
+#include <algorithm>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "astro/ephemeris.hpp"
+#include "astro/frames.hpp"
+#include "astro/phenomena.hpp"
+#include "astro/reductions.hpp"
+#include "astro/tdb_table.hpp"
+#include "astro/time.hpp"
 
 namespace {
 
@@ -20,6 +33,12 @@ int g_failures = 0;
     }                                                                     \
   } while (0)
 
+// The TDB instant `records` data records into `h`'s span.
+astro::TdbInstant at_record(const astro::Header& h, double records) {
+  return astro::TdbInstant{
+      astro::JulianDate{h.jd_begin + records * h.days_per_record}};
+}
+
 void test_missing_file() {
   auto eph = astro::Ephemeris::open("/nonexistent/path/JPLEPH");
   CHECK(!eph.has_value());
@@ -65,6 +84,1173 @@ void test_header(const char* path) {
   CHECK(zero.has_value());
 }
 
+// A mapped ephemeris interpolates the very same coefficients in place, so it
+// must agree with the buffered one bit-for-bit -- across record boundaries,
+// for every body, in both unit systems.
+void test_mapped(const char* path) {
+  auto buffered = astro::Ephemeris::open(path);
+  auto mapped = astro::Ephemeris::open(path, astro::OpenMode::mapped);
+  auto populated = astro::Ephemeris::open(
+      path, astro::OpenOptions{astro::OpenMode::mapped, /*populate=*/true});
+  CHECK(mapped.has_value());
+  CHECK(populated.has_value());
+  if (!buffered || !mapped || !populated) return;
+
+  const astro::Header& h = buffered->header();
+  CHECK(mapped->header().record_count == h.record_count);
+  CHECK(mapped->constants().size() == buffered->constants().size());
+
+  long compared = 0, mismatches = 0;
+  const double span = h.jd_end - h.jd_begin;
+  for (int i = 0; i < 200; ++i) {
+    const double jd = h.jd_begin + span * (i / 200.0);
+    const astro::TdbInstant t{astro::JulianDate{jd, 0.25 * (i % 4)}};
+    if (!buffered->covers(t)) continue;
+    for (int p = 0; p < 13; ++p) {
+      const auto u = (i % 2) ? astro::Units::km : astro::Units::au;
+      const auto tgt = static_cast<astro::Point>(p);
+      auto a = buffered->state(tgt, astro::Point::solar_system_barycenter, t, u);
+      auto b = mapped->state(tgt, astro::Point::solar_system_barycenter, t, u);
+      auto c = populated->state(tgt, astro::Point::earth, t, u);
+      auto d = buffered->state(tgt, astro::Point::earth, t, u);
+      if (!a || !b || !c || !d) {
+        CHECK(a.has_value() == b.has_value());
+        continue;
+      }
+      ++compared;
+      if (a->position != b->position || a->velocity != b->velocity ||
+          c->position != d->position || c->velocity != d->velocity)
+        ++mismatches;
+    }
+  }
+  std::fprintf(stderr, "  mapped vs buffered: %ld states, %ld mismatches\n",
+               compared, mismatches);
+  CHECK(compared > 0);
+  CHECK(mismatches == 0);
+
+  // Past the end of the ephemeris is still a range error, not a bad read.
+  auto late = mapped->state(astro::Point::mars, astro::Point::sun,
+                            astro::TdbInstant{astro::JulianDate{h.jd_end + 1.0}});
+  CHECK(!late && late.error() == astro::EphError::epoch_out_of_range);
+}
+
+// Handles share the opened file but not the record cursor: threads each
+// sweeping the span through their own handle (in different orders, so their
+// cursors fight over records) must reproduce the single-threaded states
+// exactly. Also checks a handle outlives the Ephemeris it came from.
+void test_handles(const char* path, astro::OpenMode mode) {
+  std::vector<astro::Ephemeris> handles;
+  std::vector<astro::StateVector> expected;
+  std::vector<astro::TdbInstant> epochs;
+  {
+    auto eph = astro::Ephemeris::open(path, mode);
+    CHECK(eph.has_value());
+    if (!eph) return;
+    const astro::Header& h = eph->header();
+    for (int i = 0; i < 400; ++i)
+      epochs.push_back(astro::TdbInstant{
+          astro::JulianDate{h.jd_begin + (h.jd_end - h.jd_begin) * i / 400.0}});
+    for (const auto& t : epochs) {
+      auto st = eph->state(astro::Point::moon, astro::Point::earth, t);
+      CHECK(st.has_value());
+      expected.push_back(st.value_or(astro::StateVector{}));
+    }
+    for (int k = 0; k < 4; ++k) handles.push_back(eph->handle());
+  }  // the original instance is gone; the handles keep the file open
+
+  std::vector<long> mismatches(handles.size(), 0);
+  std::vector<std::thread> workers;
+  for (std::size_t k = 0; k < handles.size(); ++k) {
+    workers.emplace_back([&, k] {
+      for (int rep = 0; rep < 5; ++rep) {
+        for (std::size_t j = 0; j < epochs.size(); ++j) {
+          const std::size_t i = (k % 2) ? epochs.size() - 1 - j : j;
+          auto st = handles[k].state(astro::Point::moon, astro::Point::earth,
+                                     epochs[i]);
+          if (!st || st->position != expected[i].position ||
+              st->velocity != expected[i].velocity)
+            ++mismatches[k];
+        }
+      }
+    });
+  }
+  for (auto& w : workers) w.join();
+  for (long m : mismatches) CHECK(m == 0);
+}
+
+// Alternating between epochs in distinct records: a one-record cache reads on
+// every call, a three-record one only on first touch -- with identical states.
+// Counters are exact: state(moon, earth) makes four group reads (EMB and Moon,
+// each for both endpoints), all from one record.
+void test_cache(const char* path) {
+  auto one = astro::Ephemeris::open(path);
+  auto three = astro::Ephemeris::open(path, astro::OpenOptions{.cache_records = 3});
+  CHECK(one.has_value());
+  CHECK(three.has_value());
+  if (!one || !three) return;
+
+  const astro::Header& h = one->header();
+  const astro::TdbInstant t[4] = {
+      at_record(h, 0.5), at_record(h, 10.5), at_record(h, 20.5),
+      at_record(h, 30.5)};
+
+  long mismatches = 0;
+  for (int rep = 0; rep < 10; ++rep) {
+    for (int i = 0; i < 3; ++i) {
+      auto a = one->state(astro::Point::moon, astro::Point::earth, t[i]);
+      auto b = three->state(astro::Point::moon, astro::Point::earth, t[i]);
+      if (!a || !b || a->position != b->position || a->velocity != b->velocity)
+        ++mismatches;
+    }
+  }
+  CHECK(mismatches == 0);
+
+  const astro::CacheStats s1 = one->cache_stats();
+  CHECK(s1.misses == 30 && s1.hits == 90 && s1.evictions == 29);
+  CHECK(s1.bytes_read == 30 * h.record_length);
+
+  astro::CacheStats s3 = three->cache_stats();
+  CHECK(s3.misses == 3 && s3.hits == 117 && s3.evictions == 0);
+  CHECK(s3.bytes_read == 3 * h.record_length);
+
+  // A fourth record evicts the least recently used one (t[0]); t[2] survives.
+  three->reset_cache_stats();
+  CHECK(three->state(astro::Point::mars, astro::Point::sun, t[3]).has_value());
+  CHECK(three->state(astro::Point::mars, astro::Point::sun, t[2]).has_value());
+  CHECK(three->state(astro::Point::mars, astro::Point::sun, t[0]).has_value());
+  s3 = three->cache_stats();
+  CHECK(s3.misses == 2 && s3.hits == 4 && s3.evictions == 2);
+
+  // Handles inherit the capacity, not the contents or the counters.
+  auto h3 = three->handle();
+  CHECK(h3.cache_stats().misses == 0);
+  for (int i = 0; i < 3; ++i)
+    CHECK(h3.state(astro::Point::moon, astro::Point::earth, t[i]).has_value());
+  CHECK(h3.state(astro::Point::moon, astro::Point::earth, t[0]).has_value());
+  CHECK(h3.cache_stats().misses == 3 && h3.cache_stats().evictions == 0);
+
+  auto mapped = astro::Ephemeris::open(path, astro::OpenMode::mapped);
+  if (mapped) {
+    CHECK(mapped->state(astro::Point::moon, astro::Point::earth, t[0]).has_value());
+    CHECK(mapped->cache_stats().misses == 0 && mapped->cache_stats().hits == 0);
+  }
+}
+
+// state_many() against per-epoch state(): bit-identical for sorted and
+// shuffled input, one record read per distinct record, and all-or-nothing on
+// an out-of-range epoch.
+void test_state_many(const char* path) {
+  auto eph = astro::Ephemeris::open(path);
+  auto batch = astro::Ephemeris::open(path);
+  CHECK(eph.has_value());
+  CHECK(batch.has_value());
+  if (!eph || !batch) return;
+
+  const astro::Header& h = eph->header();
+  std::vector<astro::TdbInstant> epochs;
+  for (int i = 0; i < 500; ++i)  // ~25 records, several epochs in each
+    epochs.push_back(astro::TdbInstant{
+        astro::JulianDate{h.jd_begin + 100.0, 1.6 * i + 0.01}});
+  std::vector<astro::TdbInstant> shuffled(epochs.rbegin(), epochs.rend());
+  for (std::size_t i = 0; i + 7 < shuffled.size(); i += 7)
+    std::swap(shuffled[i], shuffled[i + 7]);
+
+  const std::pair<astro::Point, astro::Point> pairs[] = {
+      {astro::Point::moon, astro::Point::earth},
+      {astro::Point::earth, astro::Point::solar_system_barycenter},
+      {astro::Point::mars, astro::Point::moon},
+      {astro::Point::sun, astro::Point::earth_moon_barycenter},
+      {astro::Point::venus, astro::Point::venus},
+  };
+  long mismatches = 0;
+  std::vector<astro::StateVector> out(epochs.size());
+  for (const auto& in : {epochs, shuffled}) {
+    for (auto [tgt, ctr] : pairs) {
+      for (auto u : {astro::Units::au, astro::Units::km}) {
+        batch->reset_cache_stats();
+        CHECK(batch->state_many(tgt, ctr, in, out, u).has_value());
+        if (tgt != ctr) CHECK(batch->cache_stats().misses <= 26);
+        for (std::size_t i = 0; i < in.size(); ++i) {
+          auto st = eph->state(tgt, ctr, in[i], u);
+          if (!st || st->position != out[i].position ||
+              st->velocity != out[i].velocity || st->units != out[i].units)
+            ++mismatches;
+        }
+      }
+    }
+  }
+  CHECK(mismatches == 0);
+
+  std::vector<astro::StateVector> small(3);
+  CHECK(!batch->state_many(astro::Point::mars, astro::Point::sun, epochs, small));
+
+  auto bad = epochs;
+  bad[250] = astro::TdbInstant{astro::JulianDate{h.jd_end + 1.0}};
+  std::vector<astro::StateVector> untouched(bad.size());
+  auto r = batch->state_many(astro::Point::mars, astro::Point::sun, bad, untouched);
+  CHECK(!r && r.error() == astro::EphError::epoch_out_of_range);
+  CHECK(untouched[0].position == astro::StateVector{}.position);
+}
+
+// snapshot() entries and every relative() pair reproduce state() exactly, from
+// one record read.
+void test_snapshot(const char* path) {
+  auto eph = astro::Ephemeris::open(path);
+  CHECK(eph.has_value());
+  if (!eph) return;
+
+  const astro::Header& h = eph->header();
+  long mismatches = 0;
+  for (int k = 0; k < 20; ++k) {
+    const astro::TdbInstant t{
+        astro::JulianDate{h.jd_begin + 1.0 + 517.3 * k, 0.125 * (k % 8)}};
+    const auto u = (k % 2) ? astro::Units::km : astro::Units::au;
+    eph->reset_cache_stats();
+    auto snap = eph->snapshot(t, u);
+    CHECK(snap.has_value());
+    if (!snap) continue;
+    CHECK(eph->cache_stats().hits + eph->cache_stats().misses == 1);
+    for (int a = 0; a < 13; ++a) {
+      for (int b = 0; b < 13; ++b) {
+        const auto tgt = static_cast<astro::Point>(a);
+        const auto ctr = static_cast<astro::Point>(b);
+        auto st = eph->state(tgt, ctr, t, u);
+        const astro::StateVector rel = snap->relative(tgt, ctr);
+        if (!st || st->position != rel.position ||
+            st->velocity != rel.velocity || st->units != rel.units)
+          ++mismatches;
+      }
+    }
+  }
+  CHECK(mismatches == 0);
+
+  auto late = eph->snapshot(astro::TdbInstant{astro::JulianDate{h.jd_end + 1.0}});
+  CHECK(!late && late.error() == astro::EphError::epoch_out_of_range);
+}
+
+// position() is state().position without the velocity work: same bits.
+void test_position(const char* path) {
+  auto eph = astro::Ephemeris::open(path);
+  CHECK(eph.has_value());
+  if (!eph) return;
+
+  const astro::Header& h = eph->header();
+  long mismatches = 0;
+  for (int k = 0; k < 40; ++k) {
+    const astro::TdbInstant t{
+        astro::JulianDate{h.jd_begin + 3.0 + 311.7 * k, 0.3}};
+    const auto u = (k % 2) ? astro::Units::km : astro::Units::au;
+    for (int a = 0; a < 13; ++a) {
+      for (int b = 0; b < 13; ++b) {
+        const auto tgt = static_cast<astro::Point>(a);
+        const auto ctr = static_cast<astro::Point>(b);
+        auto st = eph->state(tgt, ctr, t, u);
+        auto p = eph->position(tgt, ctr, t, u);
+        if (!st || !p || st->position != *p) ++mismatches;
+      }
+    }
+  }
+  CHECK(mismatches == 0);
+
+  auto late = eph->position(astro::Point::mars, astro::Point::sun,
+                            astro::TdbInstant{astro::JulianDate{h.jd_end + 1.0}});
+  CHECK(!late && late.error() == astro::EphError::epoch_out_of_range);
+}
+
+// Read-ahead: a sweep in either direction hints the records ahead of it, one
+// hint per record; readahead_records = 0 and non-sweeps hint nothing. The
+// hints never change results.
+void test_readahead(const char* path) {
+  auto eph = astro::Ephemeris::open(path);
+  auto off = astro::Ephemeris::open(
+      path, astro::OpenOptions{.readahead_records = 0});
+  auto mapped = astro::Ephemeris::open(path, astro::OpenMode::mapped);
+  CHECK(eph.has_value());
+  CHECK(off.has_value());
+  CHECK(mapped.has_value());
+  if (!eph || !off || !mapped) return;
+
+  const astro::Header& h = eph->header();
+
+  long mismatches = 0;
+  for (int dir : {1, -1}) {
+    eph->reset_cache_stats();
+    off->reset_cache_stats();
+    for (int i = 0; i < 100; ++i) {  // 0.25 record per step, 25 records
+      const double r = dir > 0 ? 10.0 + 0.25 * i : 59.75 - 0.25 * i;
+      const astro::TdbInstant t = at_record(h, r);
+      auto a = eph->state(astro::Point::jupiter, astro::Point::sun, t);
+      auto b = off->state(astro::Point::jupiter, astro::Point::sun, t);
+      if (!a || !b || a->position != b->position) ++mismatches;
+    }
+    const astro::CacheStats s = eph->cache_stats();
+    CHECK(s.misses == 25);
+    CHECK(s.prefetched >= 20 && s.prefetched <= 25 + 8);
+    CHECK(off->cache_stats().prefetched == 0);
+  }
+  CHECK(mismatches == 0);
+
+  // Alternating between two records is not a sweep.
+  eph->reset_cache_stats();
+  for (int i = 0; i < 20; ++i)
+    CHECK(eph->state(astro::Point::mars, astro::Point::sun,
+                     at_record(h, (i % 2) ? 100.5 : 300.5)).has_value());
+  CHECK(eph->cache_stats().prefetched == 0);
+
+  // Explicit hints count the records they cover (buffered), in either order.
+  eph->reset_cache_stats();
+  eph->prefetch(at_record(h, 40.5), at_record(h, 30.5));
+  CHECK(eph->cache_stats().prefetched == 11);
+  eph->prefetch(at_record(h, -5.0), at_record(h, 1e9));  // clamped
+  mapped->prefetch(at_record(h, 0.0), at_record(h, 50.0));
+  CHECK(mapped->cache_stats().prefetched == 0);
+  CHECK(mapped->state(astro::Point::mars, astro::Point::sun, at_record(h, 20.5))
+            .has_value());
+}
+
+// write_subset(): the subset file reopens through the normal path, answers
+// bit-identically for the bodies and span it kept, refuses the rest, and is
+// smaller in both record length and record count.
+void test_subset(const char* path) {
+  auto eph = astro::Ephemeris::open(path);
+  CHECK(eph.has_value());
+  if (!eph) return;
+
+  const astro::Header& h = eph->header();
+
+  const auto out =
+      std::filesystem::temp_directory_path() / "libastro_test_subset.eph";
+  astro::SubsetSpec spec{.from = at_record(h, 10.5),
+                         .to = at_record(h, 20.25),
+                         .points = {astro::Point::mars, astro::Point::moon}};
+  auto w = eph->write_subset(out, spec);
+  CHECK(w.has_value());
+  if (!w) return;
+
+  using astro::Point;
+  const std::pair<Point, Point> pairs[] = {
+      {Point::mars, Point::earth},
+      {Point::moon, Point::earth_moon_barycenter},
+      {Point::earth, Point::solar_system_barycenter}};
+
+  for (auto mode : {astro::OpenMode::buffered, astro::OpenMode::mapped}) {
+    auto sub = astro::Ephemeris::open(out, mode);
+    CHECK(sub.has_value());
+    if (!sub) continue;
+    const astro::Header& sh = sub->header();
+    CHECK(sh.denum == h.denum && sh.n_constants == h.n_constants);
+    CHECK(sh.jd_begin == h.jd_begin + 10 * h.days_per_record);
+    CHECK(sh.jd_end == h.jd_begin + 21 * h.days_per_record);
+    CHECK(sh.record_count == 2 + 11);
+    CHECK(sh.record_length < h.record_length);
+    CHECK(sh.groups[1].n_coeff == 0 && sh.groups[10].n_coeff == 0);
+    CHECK(sub->constants().get("AU") == eph->constants().get("AU"));
+
+    long mismatches = 0;
+    for (int i = 0; i < 44; ++i) {
+      const astro::TdbInstant t = at_record(h, 10.0 + 0.25 * i);
+      for (auto [tgt, ctr] : pairs) {
+        auto a = eph->state(tgt, ctr, t, astro::Units::km);
+        auto b = sub->state(tgt, ctr, t, astro::Units::km);
+        if (!a || !b || a->position != b->position || a->velocity != b->velocity)
+          ++mismatches;
+      }
+    }
+    CHECK(mismatches == 0);
+
+    auto dropped =
+        sub->state(astro::Point::mars, astro::Point::sun, at_record(h, 15.0));
+    CHECK(!dropped && dropped.error() == astro::EphError::body_not_available);
+    // state_many() reports it before writing any of `out`.
+    const astro::TdbInstant ts[2] = {at_record(h, 15.0), at_record(h, 16.0)};
+    astro::StateVector many[2];
+    many[0].position = {1.0, 2.0, 3.0};
+    auto batch = sub->state_many(astro::Point::mars, astro::Point::sun, ts, many);
+    CHECK(!batch && batch.error() == astro::EphError::body_not_available);
+    CHECK(many[0].position == (astro::Vec3{1.0, 2.0, 3.0}));
+    auto outside =
+        sub->state(astro::Point::mars, astro::Point::earth, at_record(h, 25.0));
+    CHECK(!outside && outside.error() == astro::EphError::epoch_out_of_range);
+    auto snap = sub->snapshot(at_record(h, 15.0));
+    CHECK(snap.has_value());
+    if (snap) {
+      CHECK(std::isnan((*snap)[astro::Point::jupiter].position[0]));
+      CHECK(!std::isnan((*snap)[astro::Point::mars].position[0]));
+    }
+  }
+
+  CHECK(std::filesystem::file_size(out) < std::filesystem::file_size(path) / 10);
+  std::filesystem::remove(out);
+
+  spec.from = at_record(h, 30.0);  // reversed span
+  auto reversed = eph->write_subset(out, spec);
+  CHECK(!reversed && reversed.error() == astro::EphError::invalid_argument);
+  spec.from = at_record(h, -1.0);
+  auto early = eph->write_subset(out, spec);
+  CHECK(!early && early.error() == astro::EphError::epoch_out_of_range);
+  spec.from = at_record(h, 1.0);
+  auto unwritable = eph->write_subset("/nonexistent/dir/subset.eph", spec);
+  CHECK(!unwritable && unwritable.error() == astro::EphError::io_error);
+  CHECK(!std::filesystem::exists(out));
+}
+
+// Precision::float32: every position within position_error_bound() of the
+// full-precision one (the sum of both bounds for a relative state), and the
+// tier's own paths -- state_many(), snapshot(), position() -- agreeing with
+// its state() bit for bit.
+void test_float32(const char* path) {
+  auto full = astro::Ephemeris::open(path);
+  auto f32 = astro::Ephemeris::open(
+      path, astro::OpenOptions{.precision = astro::Precision::float32});
+  CHECK(full.has_value());
+  CHECK(f32.has_value());
+  if (!full || !f32) return;
+  CHECK(full->precision() == astro::Precision::full);
+  CHECK(f32->precision() == astro::Precision::float32);
+
+  using astro::Point;
+  const Point bodies[] = {Point::mercury, Point::earth,   Point::mars,
+                          Point::jupiter, Point::neptune, Point::pluto,
+                          Point::moon,    Point::sun,     Point::earth_moon_barycenter};
+  for (Point p : bodies) {
+    CHECK(full->position_error_bound(p) == 0.0);
+    CHECK(f32->position_error_bound(p) > 0.0);
+    CHECK(f32->position_error_bound(p) < 1e-6 * 7.5e9);  // float epsilon x Pluto
+  }
+  CHECK(f32->position_error_bound(Point::solar_system_barycenter) == 0.0);
+  CHECK(f32->position_error_bound(Point::moon) >
+        f32->position_error_bound(Point::earth_moon_barycenter));
+
+  const astro::Header& h = full->header();
+  std::vector<astro::TdbInstant> t;
+  for (int i = 0; i < 200; ++i)
+    t.push_back({astro::JulianDate{h.jd_begin + 1.0 + i * 61.37}});
+  long outside = 0, mismatches = 0, exact = 0;
+  for (Point p : bodies) {
+    for (Point c : {Point::solar_system_barycenter, Point::earth}) {
+      std::vector<astro::StateVector> many(t.size());
+      CHECK(f32->state_many(p, c, t, many, astro::Units::km).has_value());
+      const double bound =
+          f32->position_error_bound(p) + f32->position_error_bound(c);
+      for (std::size_t i = 0; i < t.size(); ++i) {
+        auto a = full->state(p, c, t[i], astro::Units::km);
+        auto b = f32->state(p, c, t[i], astro::Units::km);
+        auto pos = f32->position(p, c, t[i], astro::Units::km);
+        if (!a || !b || !pos) { ++mismatches; continue; }
+        double d2 = 0.0;
+        for (int k = 0; k < 3; ++k) {
+          const double d = a->position[k] - b->position[k];
+          d2 += d * d;
+        }
+        if (std::sqrt(d2) > bound) ++outside;
+        if (d2 == 0.0 && p != c) ++exact;
+        if (b->position != many[i].position || b->velocity != many[i].velocity ||
+            b->position != *pos)
+          ++mismatches;
+      }
+    }
+  }
+  CHECK(outside == 0);
+  CHECK(mismatches == 0);
+  CHECK(exact < 10);  // the tier really is reduced
+
+  auto snap = f32->snapshot(t[7], astro::Units::km);
+  auto mars = f32->state(Point::mars, Point::earth, t[7], astro::Units::km);
+  CHECK(snap.has_value() && mars.has_value());
+  if (snap && mars)
+    CHECK(snap->relative(Point::mars, Point::earth).position == mars->position);
+
+  // Handles share the converted records; the record cache is not used.
+  auto h2 = f32->handle();
+  CHECK(h2.precision() == astro::Precision::float32);
+  auto again = h2.state(Point::mars, Point::earth, t[7], astro::Units::km);
+  CHECK(again && mars && again->position == mars->position);
+  CHECK(h2.cache_stats().misses == 0);
+}
+
+// open() over several files: three subsets of one ephemeris -- two
+// overlapping, then a gap -- behave as one ephemeris over their union,
+// bit-identical to the original wherever some file covers the epoch.
+void test_set(const char* path) {
+  auto eph = astro::Ephemeris::open(path);
+  CHECK(eph.has_value());
+  if (!eph) return;
+
+  const astro::Header& h = eph->header();
+  const auto dir = std::filesystem::temp_directory_path();
+  const std::filesystem::path files[] = {dir / "libastro_test_set_a.eph",
+                                         dir / "libastro_test_set_b.eph",
+                                         dir / "libastro_test_set_c.eph"};
+  const double spans[][2] = {{10.5, 40.5}, {30.5, 80.5}, {120.5, 150.5}};
+  for (int i = 0; i < 3; ++i) {
+    auto w = eph->write_subset(files[i], {.from = at_record(h, spans[i][0]),
+                                          .to = at_record(h, spans[i][1]),
+                                          .points = {}});
+    CHECK(w.has_value());
+    if (!w) return;
+  }
+
+  auto set = astro::Ephemeris::open(files);
+  CHECK(set.has_value());
+  auto empty = astro::Ephemeris::open(std::span<const std::filesystem::path>{});
+  CHECK(!empty && empty.error() == astro::EphError::invalid_argument);
+  if (set) {
+    CHECK(set->segments().size() == 3);
+    CHECK(set->header().jd_begin == h.jd_begin + 10 * h.days_per_record);
+    CHECK(set->header().jd_end == h.jd_begin + 151 * h.days_per_record);
+    CHECK(set->constants().get("EMRAT") == eph->constants().get("EMRAT"));
+    CHECK(eph->segments().size() == 1);
+
+    std::vector<astro::TdbInstant> t;
+    for (double r = 10.0; r < 151.0; r += 0.37) t.push_back(at_record(h, r));
+    std::vector<astro::StateVector> many(t.size());
+    auto batch = set->state_many(astro::Point::moon, astro::Point::earth, t, many);
+    CHECK(!batch && batch.error() == astro::EphError::epoch_out_of_range);  // gap
+
+    long mismatches = 0, gaps = 0;
+    std::vector<astro::TdbInstant> covered;
+    for (const astro::TdbInstant& ti : t) {
+      auto a = eph->state(astro::Point::moon, astro::Point::earth, ti);
+      auto b = set->state(astro::Point::moon, astro::Point::earth, ti);
+      const double r = (ti.jd.value() - h.jd_begin) / h.days_per_record;
+      if (r > 81.0 && r < 120.0) {
+        if (b || b.error() != astro::EphError::epoch_out_of_range) ++mismatches;
+        if (set->covers(ti)) ++mismatches;
+        ++gaps;
+        continue;
+      }
+      covered.push_back(ti);
+      if (!a || !b || a->position != b->position || a->velocity != b->velocity)
+        ++mismatches;
+    }
+    CHECK(gaps > 0);
+    CHECK(mismatches == 0);
+
+    many.resize(covered.size());
+    CHECK(set->state_many(astro::Point::mars, astro::Point::sun, covered, many)
+              .has_value());
+    for (std::size_t i = 0; i < covered.size(); ++i) {
+      auto a = eph->state(astro::Point::mars, astro::Point::sun, covered[i]);
+      if (!a || a->position != many[i].position) ++mismatches;
+    }
+    CHECK(mismatches == 0);
+
+    auto h2 = set->handle();
+    auto s = h2.snapshot(at_record(h, 140.25));
+    auto ref = eph->state(astro::Point::venus, astro::Point::solar_system_barycenter,
+                          at_record(h, 140.25));
+    CHECK(s && ref && (*s)[astro::Point::venus].position == ref->position);
+    CHECK(h2.cache_stats().misses >= 1);
+
+    // write_subset() copies one file's records: a span inside one part
+    // works, one that only the set covers is refused.
+    const auto sub = dir / "libastro_test_set_subset.eph";
+    CHECK(set->write_subset(sub, {.from = at_record(h, 45.0),
+                                  .to = at_record(h, 75.0),
+                                  .points = {astro::Point::mars}})
+              .has_value());
+    auto across = set->write_subset(sub, {.from = at_record(h, 20.0),
+                                          .to = at_record(h, 60.0),
+                                          .points = {}});
+    CHECK(!across && across.error() == astro::EphError::invalid_argument);
+    auto gap = set->write_subset(sub, {.from = at_record(h, 70.0),
+                                       .to = at_record(h, 100.0),
+                                       .points = {}});
+    CHECK(!gap && gap.error() == astro::EphError::epoch_out_of_range);
+    std::filesystem::remove(sub);
+  }
+  for (const auto& f : files) std::filesystem::remove(f);
+}
+
+// nutation() and libration(): rates consistent with the angles, nutation
+// close to the IAU 2000A series, and place() and the ecliptic of date
+// switching their nutation source only where asked (OpenOptions::nutation).
+void test_angles(const char* path) {
+  auto eph = astro::Ephemeris::open(path);
+  auto nut = astro::Ephemeris::open(
+      path, astro::OpenOptions{.nutation = astro::NutationSource::ephemeris});
+  CHECK(eph.has_value());
+  CHECK(nut.has_value());
+  if (!eph || !nut) return;
+  CHECK(eph->nutation_source() == astro::NutationSource::series);
+  CHECK(nut->nutation_source() == astro::NutationSource::ephemeris);
+
+  constexpr double kAsec = 4.848136811095359935899141e-6;  // radians
+  const astro::Header& h = eph->header();
+  long bad = 0;
+  for (int i = 0; i < 50; ++i) {
+    const double jd = h.jd_begin + 10.3 + i * 97.13;
+    const astro::TdbInstant t{astro::JulianDate{jd}};
+    const astro::TdbInstant t2{astro::JulianDate{jd + 0.01}};
+    auto n = eph->nutation(t);
+    auto n2 = eph->nutation(t2);
+    auto l = eph->libration(t);
+    auto l2 = eph->libration(t2);
+    if (!n || !n2 || !l || !l2) { ++bad; continue; }
+
+    double dpsi, deps;  // arcseconds
+    astro::nutation_angles((jd - 2451545.0) / 36525.0, astro::Accuracy::full,
+                           dpsi, deps);
+    if (std::abs(n->dpsi / kAsec - dpsi) > 2.0) ++bad;
+    if (std::abs(n->deps / kAsec - deps) > 2.0) ++bad;
+
+    // Centred-enough difference over 0.01 day vs the mean of the two rates.
+    auto near = [](double da, double r1, double r2) {
+      const double fd = da / 0.01, mean = 0.5 * (r1 + r2);
+      return std::abs(fd - mean) <= 1e-6 * std::abs(mean) + 1e-12;
+    };
+    if (!near(n2->dpsi - n->dpsi, n->dpsi_rate, n2->dpsi_rate)) ++bad;
+    if (!near(n2->deps - n->deps, n->deps_rate, n2->deps_rate)) ++bad;
+    for (int k = 0; k < 3; ++k)
+      if (!near(l2->angles[k] - l->angles[k], l->rates[k], l2->rates[k])) ++bad;
+  }
+  CHECK(bad == 0);
+
+  auto late = eph->nutation(astro::TdbInstant{astro::JulianDate{h.jd_end + 1.0}});
+  CHECK(!late && late.error() == astro::EphError::epoch_out_of_range);
+
+  // place(): GCRS has no nutation and is unchanged; the apparent place moves
+  // by no more than the two nutation models differ.
+  const astro::TtInstant tt{astro::JulianDate{h.jd_begin + 5000.25}};
+  for (auto sys : {astro::CoordSys::gcrs, astro::CoordSys::equator_equinox,
+                   astro::CoordSys::equator_cio}) {
+    auto a = astro::place(*eph, astro::Point::mars, tt, astro::DeltaT{69.0}, sys,
+                          astro::Accuracy::full);
+    auto b = astro::place(*nut, astro::Point::mars, tt, astro::DeltaT{69.0}, sys,
+                          astro::Accuracy::full);
+    CHECK(a && b);
+    if (!a || !b) continue;
+    const double dra = (a->ra_hours - b->ra_hours) * 15.0 * 3600.0;
+    const double ddec = (a->dec_deg - b->dec_deg) * 3600.0;
+    if (sys == astro::CoordSys::gcrs) {
+      CHECK(dra == 0.0 && ddec == 0.0);
+    } else {
+      CHECK(std::abs(dra) < 5.0 && std::abs(ddec) < 5.0);
+      CHECK(dra != 0.0 || ddec != 0.0);
+    }
+  }
+
+  // The ecliptic of date takes its obliquity from the same source: unchanged
+  // by a series ephemeris, moved (within the models' difference) by `nut`.
+  double lon0, lat0, lon1, lat1, lon2, lat2;
+  const double jd_tt = tt.jd.value();
+  astro::equ_to_ecl_of_date(jd_tt, 6.5, 23.0, lon0, lat0);
+  astro::equ_to_ecl_of_date(jd_tt, 6.5, 23.0, lon1, lat1, &*eph);
+  astro::equ_to_ecl_of_date(jd_tt, 6.5, 23.0, lon2, lat2, &*nut);
+  CHECK(lon1 == lon0 && lat1 == lat0);
+  CHECK(lon2 != lon0 || lat2 != lat0);
+  CHECK(std::abs(lon2 - lon0) * 3600.0 < 5.0 &&
+        std::abs(lat2 - lat0) * 3600.0 < 5.0);
+}
+
+// OpenOptions::transposed: transposed bodies answer bit-identically to the
+// interleaved records through every path, without a single record read;
+// other bodies still go through the records.
+void test_transposed(const char* path) {
+  using astro::Point;
+  auto plain = astro::Ephemeris::open(path);
+  CHECK(plain.has_value());
+  if (!plain) return;
+
+  const astro::Header& h = plain->header();
+  std::vector<astro::TdbInstant> t;
+  for (int i = 0; i < 300; ++i)
+    t.push_back({astro::JulianDate{h.jd_begin + 0.5 + i * 13.71}});
+
+  for (astro::OpenMode mode : {astro::OpenMode::buffered, astro::OpenMode::mapped}) {
+    auto eph = astro::Ephemeris::open(
+        path, astro::OpenOptions{.mode = mode,
+                                 .transposed = {Point::jupiter, Point::moon}});
+    CHECK(eph.has_value());
+    if (!eph) continue;
+
+    const std::pair<Point, Point> swept[] = {
+        {Point::jupiter, Point::solar_system_barycenter},
+        {Point::moon, Point::earth},
+        {Point::jupiter, Point::earth},
+        {Point::earth_moon_barycenter, Point::jupiter}};
+    long mismatches = 0;
+    for (auto [p, c] : swept) {
+      std::vector<astro::StateVector> many(t.size());
+      CHECK(eph->state_many(p, c, t, many, astro::Units::km).has_value());
+      for (std::size_t i = 0; i < t.size(); ++i) {
+        auto a = plain->state(p, c, t[i], astro::Units::km);
+        auto b = eph->state(p, c, t[i], astro::Units::km);
+        auto pos = eph->position(p, c, t[i], astro::Units::km);
+        if (!a || !b || !pos || a->position != b->position ||
+            a->velocity != b->velocity || b->position != *pos ||
+            b->position != many[i].position || b->velocity != many[i].velocity)
+          ++mismatches;
+      }
+    }
+    CHECK(mismatches == 0);
+    CHECK(eph->cache_stats().misses == 0);
+
+    // Mars and the nutations are still interleaved: read through the
+    // records, same bits.
+    auto a = plain->state(Point::mars, Point::jupiter, t[42]);
+    auto b = eph->state(Point::mars, Point::jupiter, t[42]);
+    CHECK(a && b && a->position == b->position && a->velocity == b->velocity);
+    if (mode == astro::OpenMode::buffered) CHECK(eph->cache_stats().misses == 1);
+    auto n = eph->nutation(t[3]);
+    auto m = plain->nutation(t[3]);
+    CHECK(n && m && n->dpsi == m->dpsi && n->deps_rate == m->deps_rate);
+
+    auto snap = eph->snapshot(t[42]);
+    CHECK(snap && b && snap->relative(Point::mars, Point::jupiter).position ==
+                           b->position);
+
+    // Handles share the streams.
+    auto h2 = eph->handle();
+    auto c = h2.state(Point::moon, Point::earth, t[9]);
+    auto d = plain->state(Point::moon, Point::earth, t[9]);
+    CHECK(c && d && c->position == d->position);
+    CHECK(h2.cache_stats().misses == 0);
+  }
+
+  // A body the file lacks cannot be transposed.
+  const auto out =
+      std::filesystem::temp_directory_path() / "libastro_test_transposed.eph";
+  astro::SubsetSpec spec{.from = t[10], .to = t[20], .points = {Point::mars}};
+  CHECK(plain->write_subset(out, spec).has_value());
+  auto lacking = astro::Ephemeris::open(
+      out, astro::OpenOptions{.transposed = {Point::earth}});
+  CHECK(!lacking && lacking.error() == astro::EphError::body_not_available);
+  auto mars = astro::Ephemeris::open(
+      out, astro::OpenOptions{.transposed = {Point::mars}});
+  CHECK(mars.has_value());
+  if (mars) {
+    auto a = plain->state(Point::mars, Point::sun, t[15]);
+    CHECK(!mars->state(Point::mars, Point::sun, t[15]));  // Sun dropped
+    auto b = mars->state(Point::mars, Point::solar_system_barycenter, t[15]);
+    auto c = plain->state(Point::mars, Point::solar_system_barycenter, t[15]);
+    CHECK(a && b && c && b->position == c->position);
+  }
+  std::filesystem::remove(out);
+}
+
+// OpenOptions::batch_queue_depth: state_many() over epochs scattered across
+// the whole file reads its uncached records as one concurrent batch, never
+// more than the queue depth at a time, and still matches state() bit for bit.
+void test_batched_reads(const char* path) {
+  using astro::Point;
+  auto serial = astro::Ephemeris::open(
+      path, astro::OpenOptions{.batch_queue_depth = 0});
+  auto batch = astro::Ephemeris::open(
+      path, astro::OpenOptions{.cache_records = 4, .batch_queue_depth = 4});
+  CHECK(serial.has_value());
+  CHECK(batch.has_value());
+  if (!serial || !batch) return;
+
+  const astro::Header& h = serial->header();
+  const double span = h.jd_end - h.jd_begin;
+  std::vector<astro::TdbInstant> t;
+  std::uint64_t x = 88172645463325252ull;  // xorshift: fixed, unordered epochs
+  for (int i = 0; i < 600; ++i) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    t.push_back({astro::JulianDate{h.jd_begin + 1.0 + (x % 1000000) * 1e-6 * (span - 2.0)}});
+  }
+  std::vector<long> records;
+  for (const auto& e : t)
+    records.push_back(static_cast<long>((e.jd.value() - h.jd_begin) /
+                                        h.days_per_record));
+  std::ranges::sort(records);
+  const auto distinct = static_cast<std::uint64_t>(
+      std::unique(records.begin(), records.end()) - records.begin());
+
+  // One record already cached is taken from the cache, not the batch.
+  CHECK(batch->state(Point::mars, Point::sun, t[0]).has_value());
+  batch->reset_cache_stats();
+
+  std::vector<astro::StateVector> out(t.size());
+  CHECK(batch->state_many(Point::mars, Point::earth, t, out, astro::Units::km)
+            .has_value());
+  long mismatches = 0;
+  for (std::size_t i = 0; i < t.size(); ++i) {
+    auto st = serial->state(Point::mars, Point::earth, t[i], astro::Units::km);
+    if (!st || st->position != out[i].position || st->velocity != out[i].velocity)
+      ++mismatches;
+  }
+  CHECK(mismatches == 0);
+
+  const astro::CacheStats c = batch->cache_stats();
+  CHECK(c.batched == distinct - 1);
+  CHECK(c.misses == c.batched);
+  CHECK(c.bytes_read == c.batched * h.record_length);
+  CHECK(c.max_queue_depth >= 1 && c.max_queue_depth <= 4);
+  CHECK(c.batch_wait_ns > 0 && c.max_batch_wait_ns <= c.batch_wait_ns);
+
+  // The batch left the cache alone: the warm record is still a hit.
+  batch->reset_cache_stats();
+  CHECK(batch->state(Point::mars, Point::sun, t[0]).has_value());
+  CHECK(batch->cache_stats().misses == 0);
+
+  // A second batch runs on the queue the first set up, and a handle on its
+  // own; both fetch and evaluate the same.
+  std::vector<astro::StateVector> more(t.size());
+  batch->reset_cache_stats();
+  CHECK(batch->state_many(Point::mars, Point::earth, t, more, astro::Units::km)
+            .has_value());
+  CHECK(batch->cache_stats().batched == distinct - 1);
+  CHECK(more[17].position == out[17].position);
+  auto other = batch->handle();
+  CHECK(other.state_many(Point::mars, Point::earth, t, more, astro::Units::km)
+            .has_value());
+  CHECK(other.cache_stats().batched == distinct);
+  CHECK(more[17].position == out[17].position);
+
+  // Depth 0 reads through the cache one record at a time.
+  std::vector<astro::StateVector> again(t.size());
+  serial->reset_cache_stats();
+  CHECK(serial->state_many(Point::mars, Point::earth, t, again, astro::Units::km)
+            .has_value());
+  CHECK(serial->cache_stats().batched == 0);
+  CHECK(serial->cache_stats().misses == distinct);
+  CHECK(again[17].position == out[17].position);
+}
+
+// write_compressed(): a container smaller than the file it came from, whose
+// every read -- state(), state_many(), snapshot(), the float32 tier, a subset
+// written from it -- matches the original bit for bit, in either open mode.
+void test_compressed(const char* path) {
+  using astro::Point;
+  auto eph = astro::Ephemeris::open(path);
+  CHECK(eph.has_value());
+  if (!eph) return;
+  CHECK(!eph->header().compressed);
+
+  const astro::Header& h = eph->header();
+  const auto dir = std::filesystem::temp_directory_path();
+  const auto out = dir / "libastro_test_compressed.astroz";
+  CHECK(eph->write_compressed(out).has_value());
+  CHECK(std::filesystem::file_size(out) < std::filesystem::file_size(path));
+
+  const double last = static_cast<double>(h.record_count - 2) - 0.5;
+  std::vector<astro::TdbInstant> t;
+  for (double r = 0.1; r < last; r += 1.37) t.push_back(at_record(h, r));
+  std::vector<astro::StateVector> want(t.size());
+  CHECK(eph->state_many(Point::moon, Point::earth, t, want, astro::Units::km)
+            .has_value());
+
+  for (auto mode : {astro::OpenMode::buffered, astro::OpenMode::mapped}) {
+    auto z = astro::Ephemeris::open(out, mode);
+    CHECK(z.has_value());
+    if (!z) continue;
+    CHECK(z->header().compressed);
+    CHECK(z->header().record_count == h.record_count);
+    CHECK(z->header().jd_end == h.jd_end);
+    CHECK(z->constants().get("EMRAT") == eph->constants().get("EMRAT"));
+
+    long mismatches = 0;
+    for (std::size_t i = 0; i < t.size(); ++i) {
+      auto st = z->state(Point::moon, Point::earth, t[i], astro::Units::km);
+      if (!st || st->position != want[i].position ||
+          st->velocity != want[i].velocity)
+        ++mismatches;
+    }
+    std::vector<astro::StateVector> many(t.size());
+    CHECK(z->state_many(Point::moon, Point::earth, t, many, astro::Units::km)
+              .has_value());
+    for (std::size_t i = 0; i < t.size(); ++i)
+      if (many[i].position != want[i].position) ++mismatches;
+    CHECK(mismatches == 0);
+
+    auto a = eph->snapshot(at_record(h, last - 3.3));
+    auto b = z->snapshot(at_record(h, last - 3.3));
+    CHECK(a && b && (*a)[Point::pluto].position == (*b)[Point::pluto].position);
+  }
+
+  auto f32 = astro::Ephemeris::open(path, {.precision = astro::Precision::float32});
+  auto z32 = astro::Ephemeris::open(out, {.precision = astro::Precision::float32});
+  CHECK(f32 && z32);
+  if (f32 && z32) {
+    auto a = f32->state(Point::mars, Point::sun, at_record(h, 12.7));
+    auto b = z32->state(Point::mars, Point::sun, at_record(h, 12.7));
+    CHECK(a && b && a->position == b->position);
+  }
+
+  // A subset and a second container written from the container.
+  auto z = astro::Ephemeris::open(out);
+  CHECK(z.has_value());
+  if (z) {
+    const auto sub = dir / "libastro_test_compressed_subset.eph";
+    CHECK(z->write_subset(sub, {.from = at_record(h, 20.5),
+                                .to = at_record(h, 30.5),
+                                .points = {Point::moon}})
+              .has_value());
+    auto s = astro::Ephemeris::open(sub);
+    CHECK(s && !s->header().compressed);
+    if (s) {
+      auto a = s->state(Point::moon, Point::earth, at_record(h, 25.2));
+      auto b = eph->state(Point::moon, Point::earth, at_record(h, 25.2));
+      CHECK(a && b && a->position == b->position);
+    }
+    std::filesystem::remove(sub);
+
+    const auto again = dir / "libastro_test_compressed_2.astroz";
+    CHECK(z->write_compressed(again).has_value());
+    CHECK(std::filesystem::file_size(again) == std::filesystem::file_size(out));
+    std::filesystem::remove(again);
+  }
+
+  // A truncated container loses its index.
+  const auto cut = dir / "libastro_test_compressed_cut.astroz";
+  std::filesystem::copy_file(out, cut,
+                             std::filesystem::copy_options::overwrite_existing);
+  std::filesystem::resize_file(cut, std::filesystem::file_size(out) - 64);
+  auto truncated = astro::Ephemeris::open(cut);
+  CHECK(!truncated && truncated.error() == astro::EphError::bad_header);
+  std::filesystem::remove(cut);
+
+  // A set has no single file to compress.
+  const auto part = dir / "libastro_test_compressed_part.eph";
+  CHECK(eph->write_subset(part, {.from = at_record(h, 40.5),
+                                 .to = at_record(h, 50.5),
+                                 .points = {}})
+            .has_value());
+  const std::filesystem::path parts[] = {out, part};
+  auto set = astro::Ephemeris::open(parts);
+  CHECK(set.has_value());
+  if (set) {
+    auto w = set->write_compressed(dir / "libastro_test_compressed_set.astroz");
+    CHECK(!w && w.error() == astro::EphError::invalid_argument);
+  }
+  auto unwritable = eph->write_compressed("/nonexistent/dir/eph.astroz");
+  CHECK(!unwritable && unwritable.error() == astro::EphError::io_error);
+  std::filesystem::remove(part);
+  std::filesystem::remove(out);
+}
+
+// Constants: the map built once however many threads ask first, lookups by
+// std::string_view, and the hot accessors agreeing with get().
+void test_constants(const char* path) {
+  auto eph = astro::Ephemeris::open(path);
+  CHECK(eph.has_value());
+  if (!eph) return;
+  const astro::Constants& c = eph->constants();
+  CHECK(c.size() == static_cast<std::size_t>(eph->header().n_constants));
+  CHECK(c.au_km() == eph->header().au_km);  // no map needed
+
+  std::vector<std::jthread> threads;
+  std::vector<std::optional<double>> gms(8);
+  for (std::size_t i = 0; i < gms.size(); ++i)
+    threads.emplace_back([&, i] { gms[i] = eph->handle().constants().get("GMS"); });
+  threads.clear();
+  for (const auto& g : gms) CHECK(g.has_value() && g == gms[0]);
+  CHECK(c.entries().size() == c.size());
+
+  const char buf[] = "EMRATIO";
+  CHECK(c.get(std::string_view(buf, 5)) == c.earth_moon_ratio());
+  CHECK(c.get("CLIGHT") == c.speed_of_light_km_s());
+  CHECK(c.get("RE") == c.earth_radius_km());
+  CHECK(c.get("GMS") == c.gm_sun());
+  CHECK(c.get("GMB") == c.gm_earth_moon());
+  CHECK(!c.get("NOSUCH"));
+  CHECK(!c.get(""));
+
+  const astro::Constants none;
+  CHECK(none.empty() && !none.get("AU") && !none.au_km() && none.entries().empty());
+  const astro::Constants given({{"AU", 1.5e8}, {"GMS", 3e-4}});
+  CHECK(given.size() == 2 && given.au_km() == 1.5e8 && given.gm_sun() == 3e-4);
+  CHECK(given.get("AU") == 1.5e8 && !given.earth_moon_ratio());
+}
+
+// state_pva(): position and velocity bit-identical to state(), and the
+// acceleration agreeing with a central difference of state() velocities --
+// for raw groups and for the EMRAT-reconstructed Earth and Moon alike.
+void test_state_pva(const char* path) {
+  using astro::Point;
+  auto eph = astro::Ephemeris::open(path);
+  CHECK(eph.has_value());
+  if (!eph) return;
+  const astro::Header& h = eph->header();
+
+  const std::pair<Point, Point> pairs[] = {
+      {Point::mars, Point::solar_system_barycenter},
+      {Point::earth, Point::sun},
+      {Point::moon, Point::earth},
+      {Point::earth, Point::moon},
+      {Point::moon, Point::sun},
+      {Point::venus, Point::earth_moon_barycenter},
+      {Point::sun, Point::sun}};
+  for (auto units : {astro::Units::au, astro::Units::km}) {
+    const double day = units == astro::Units::km ? 86400.0 : 1.0;
+    for (int i = 0; i < 20; ++i) {
+      const double jd = h.jd_begin + 3.0 + i * 211.0;
+      const astro::TdbInstant t{astro::JulianDate{jd, 0.3}};
+      for (auto [tgt, ctr] : pairs) {
+        auto pva = eph->state_pva(tgt, ctr, t, units);
+        auto st = eph->state(tgt, ctr, t, units);
+        CHECK(pva && st);
+        if (!pva || !st) continue;
+        CHECK(pva->position == st->position && pva->velocity == st->velocity);
+        CHECK(pva->units == units);
+
+        const double dt = 1.0 / 1024;  // days, exact in the split fraction
+        auto lo = eph->state(tgt, ctr, {astro::JulianDate{jd, 0.3 - dt}}, units);
+        auto hi = eph->state(tgt, ctr, {astro::JulianDate{jd, 0.3 + dt}}, units);
+        CHECK(lo && hi);
+        if (!lo || !hi) continue;
+        double mag = 0.0, err = 0.0;
+        for (int k = 0; k < 3; ++k) {
+          const double fd = (hi->velocity[k] - lo->velocity[k]) / (2.0 * dt * day);
+          mag = std::max(mag, std::abs(pva->acceleration[k]));
+          err = std::max(err, std::abs(fd - pva->acceleration[k]));
+        }
+        CHECK(err <= 1e-7 * mag);  // the difference's own truncation: ~1e-8 (Moon)
+      }
+    }
+  }
+
+  auto far = eph->state_pva(Point::mars, Point::sun,
+                            astro::TdbInstant{astro::JulianDate{h.jd_end + 10.0}});
+  CHECK(!far && far.error() == astro::EphError::epoch_out_of_range);
+}
+
+// TdbTtTable: generated from the ephemeris, within the series' error of it
+// and continuous across intervals; save()/load()/cached() round-trip; and
+// OpenOptions::tdb sharing one table across handles and feeding place() and
+// the other of-date reductions.
+void test_tdb_table(const char* path) {
+  auto eph = astro::Ephemeris::open(path);
+  CHECK(eph.has_value());
+  if (!eph) return;
+  const astro::Header& h = eph->header();
+
+  // No table: the series, everywhere.
+  CHECK(eph->tdb_table().empty());
+  CHECK(eph->tdb_table().tdb_minus_tt_seconds(h.jd_begin + 100.0) ==
+        astro::tdb_minus_tt_seconds(h.jd_begin + 100.0));
+
+  auto table = astro::TdbTtTable::generate(*eph);
+  CHECK(table.has_value());
+  if (!table) return;
+  CHECK(table->jd_begin() == h.jd_begin);
+  CHECK(table->jd_end() <= h.jd_end && table->jd_end() > h.jd_end - 16.0);
+
+  // Within the series' own error of it (~10 us), and continuous across the
+  // 16-day interval boundaries.
+  double worst = 0.0;
+  for (double jd = table->jd_begin(); jd < table->jd_end(); jd += 3.7)
+    worst = std::max(worst, std::abs(table->tdb_minus_tt_seconds(jd) -
+                                     astro::tdb_minus_tt_seconds(jd)));
+  CHECK(worst < 5e-5);
+  for (int i = 1; i < 20; ++i) {
+    const double edge = table->jd_begin() + 16.0 * i;
+    CHECK(std::abs(table->tdb_minus_tt_seconds(edge - 1e-7) -
+                   table->tdb_minus_tt_seconds(edge + 1e-7)) < 1e-10);
+  }
+  const double outside = table->jd_end() + 100.0;
+  CHECK(!table->covers(outside));
+  CHECK(table->tdb_minus_tt_seconds(outside) ==
+        astro::tdb_minus_tt_seconds(outside));
+
+  // The two-part forms agree with the one-part one.
+  const astro::TtInstant tt{astro::JulianDate{h.jd_begin + 4000.0, 0.375}};
+  const double dt = table->tdb_minus_tt_seconds(tt.jd.value());
+  CHECK(std::abs(table->tdb_minus_tt_seconds(tt) - dt) < 1e-12);
+  const auto tdb = astro::tdb_from_tt(tt, *table);
+  CHECK(tdb.jd.whole == tt.jd.value() &&
+        std::abs(tdb.jd.frac * 86400.0 - dt) < 1e-12);
+  {
+    const double whole[] = {tt.jd.whole, outside}, frac[] = {tt.jd.frac, 0.0};
+    double out[2];
+    CHECK(astro::tdb_from_tt(whole, frac, out, *table).has_value());
+    CHECK(std::abs((out[0] - frac[0]) * 86400.0 - dt) < 1e-9);
+    CHECK(out[1] * 86400.0 == astro::tdb_minus_tt_seconds(outside));
+    CHECK(!astro::tdb_from_tt(whole, frac, std::span<double>(out, 1), *table));
+  }
+
+  // save() / load() round-trip exactly; cached() reuses a matching file and
+  // replaces anything else.
+  const auto file =
+      std::filesystem::temp_directory_path() / "libastro_test_tdb.bin";
+  std::filesystem::remove(file);
+  CHECK(!astro::TdbTtTable::load(file) &&
+        astro::TdbTtTable::load(file).error() == astro::EphError::file_not_found);
+  CHECK(table->save(file).has_value());
+  auto loaded = astro::TdbTtTable::load(file);
+  CHECK(loaded.has_value());
+  if (loaded)
+    for (double jd = h.jd_begin; jd < table->jd_end(); jd += 97.3)
+      CHECK(loaded->tdb_minus_tt_seconds(jd) == table->tdb_minus_tt_seconds(jd));
+  std::filesystem::resize_file(file, 100);
+  CHECK(!astro::TdbTtTable::load(file) &&
+        astro::TdbTtTable::load(file).error() == astro::EphError::bad_header);
+  auto cached = astro::TdbTtTable::cached(*eph, file);
+  CHECK(cached.has_value() && astro::TdbTtTable::load(file).has_value());
+
+  // Selected at open(): shared by handles, and used by the reductions.
+  astro::OpenOptions options;
+  options.tdb = astro::TdbSource::ephemeris;
+  options.tdb_cache = file;
+  auto with = astro::Ephemeris::open(path, options);
+  CHECK(with.has_value());
+  if (with) {
+    const astro::Ephemeris other = with->handle();
+    CHECK(!with->tdb_table().empty());
+    CHECK(&other.tdb_table() == &with->tdb_table());
+    CHECK(with->tdb_table().tdb_minus_tt_seconds(tt) ==
+          table->tdb_minus_tt_seconds(tt));
+    // A TDB shift of microseconds moves Mars by well under a milliarcsecond.
+    auto a = astro::place(*eph, astro::Point::mars, tt, astro::DeltaT{69.0},
+                          astro::CoordSys::gcrs, astro::Accuracy::full);
+    auto b = astro::place(*with, astro::Point::mars, tt, astro::DeltaT{69.0},
+                          astro::CoordSys::gcrs, astro::Accuracy::full);
+    CHECK(a && b);
+    if (a && b) {
+      CHECK(std::abs(a->ra_hours - b->ra_hours) * 54000.0 < 1e-3);
+      CHECK(std::abs(a->dec_deg - b->dec_deg) * 3600.0 < 1e-3);
+    }
+    // So do the ecliptic of date, sidereal time and equ2hor: unchanged given
+    // a series ephemeris, barely moved by the table.
+    const double jd_tt = tt.jd.value();
+    double lon0, lat0, lon1, lat1, lon2, lat2;
+    astro::equ_to_ecl_of_date(jd_tt, 6.5, 23.0, lon0, lat0);
+    astro::equ_to_ecl_of_date(jd_tt, 6.5, 23.0, lon1, lat1, &*eph);
+    astro::equ_to_ecl_of_date(jd_tt, 6.5, 23.0, lon2, lat2, &*with);
+    CHECK(lon1 == lon0 && lat1 == lat0);
+    CHECK(std::abs(lon2 - lon0) * 3600.0 < 1e-6 &&
+          std::abs(lat2 - lat0) * 3600.0 < 1e-6);
+    const astro::Ut1Instant ut1{astro::JulianDate{jd_tt - 69.0 / 86400.0}};
+    const astro::DeltaT dt{69.0};
+    const double gast0 =
+        astro::greenwich_apparent_sidereal_time(ut1, dt, astro::Accuracy::full);
+    CHECK(astro::greenwich_apparent_sidereal_time(
+              *eph, ut1, dt, astro::Accuracy::full) == gast0);
+    CHECK(std::abs(astro::greenwich_apparent_sidereal_time(
+                       *with, ut1, dt, astro::Accuracy::full) -
+                   gast0) * 54000.0 < 1e-6);
+    const astro::SurfaceObserver obs{47.6, -122.3, 10.0};
+    const auto h0 =
+        astro::equ2hor(ut1, dt, astro::Accuracy::full, astro::PolarMotion{},
+                       obs, 6.5, 23.0, astro::Refraction::none);
+    const auto h1 =
+        astro::equ2hor(*eph, ut1, dt, astro::Accuracy::full,
+                       astro::PolarMotion{}, obs, 6.5, 23.0,
+                       astro::Refraction::none);
+    CHECK(h1.zenith_distance_deg == h0.zenith_distance_deg &&
+          h1.azimuth_deg == h0.azimuth_deg);
+  }
+  std::filesystem::remove(file);
+
+  // A subset without the planets cannot drive the integration.
+  const auto sub =
+      std::filesystem::temp_directory_path() / "libastro_test_tdb_subset.eph";
+  astro::SubsetSpec spec{.from = at_record(h, 10.0),
+                         .to = at_record(h, 40.0),
+                         .points = {astro::Point::mars}};
+  if (eph->write_subset(sub, spec)) {
+    auto partial = astro::Ephemeris::open(sub, options);
+    CHECK(!partial && partial.error() == astro::EphError::body_not_available);
+  } else {
+    CHECK(false);
+  }
+  std::filesystem::remove(sub);
+}
+
 }  // namespace
 
 int main() {
@@ -72,6 +1258,24 @@ int main() {
 
   if (const char* path = std::getenv("LIBASTRO_EPHEMERIS")) {
     test_header(path);
+    test_mapped(path);
+    test_handles(path, astro::OpenMode::buffered);
+    test_handles(path, astro::OpenMode::mapped);
+    test_cache(path);
+    test_state_many(path);
+    test_snapshot(path);
+    test_position(path);
+    test_readahead(path);
+    test_subset(path);
+    test_float32(path);
+    test_set(path);
+    test_angles(path);
+    test_transposed(path);
+    test_batched_reads(path);
+    test_compressed(path);
+    test_constants(path);
+    test_state_pva(path);
+    test_tdb_table(path);
   } else {
     std::fprintf(stderr,
                  "SKIP header tests: set LIBASTRO_EPHEMERIS or run "
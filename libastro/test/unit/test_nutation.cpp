@@ -2,12 +2,17 @@
 // series (gen_nutation). Same tables + arithmetic => round-off agreement. Needs
 // no ephemeris. Skips (exit 0) if the reference file is absent.
 //
+// The other NutationEvaluators are checked against the same rows, and against
+// the exact evaluator to kEvaluatorTol.
+//
 // Usage: test_nutation <nutation.csv>
 
 #include <cmath>
+#include <cstddef>
 #include <cstdio>
 #include <cstdlib>
 #include <fstream>
+#include <iterator>
 #include <string>
 
 #include "astro/frames.hpp"
@@ -17,6 +22,17 @@ constexpr double kT0 = 2451545.0;
 // Same tables/arithmetic as the oracle; residual is round-off. Angles are in
 // arcseconds; a genuine table/argument error deviates by >> 1e-4.
 constexpr double kTol = 1e-7;
+// The other evaluators' promise (accuracy.hpp): the same series with
+// different rounding, so within 1e-9 arcsec of exact.
+constexpr double kEvaluatorTol = 1e-9;
+struct Evaluator {
+  astro::NutationEvaluator evaluator;
+  const char* name;
+};
+constexpr Evaluator kEvaluators[] = {
+    {astro::NutationEvaluator::vectorized, "vectorized"},
+    {astro::NutationEvaluator::recurrence, "recurrence"},
+};
 }  // namespace
 
 int main(int argc, char** argv) {
@@ -37,6 +53,7 @@ int main(int argc, char** argv) {
 
   long rows = 0, failures = 0;
   double max_dpsi = 0, max_deps = 0, max_mobl = 0;
+  double max_alt[std::size(kEvaluators)] = {};
 
   while (std::getline(csv, line)) {
     if (line.empty()) continue;
@@ -64,6 +81,22 @@ int main(int argc, char** argv) {
     max_deps = std::fmax(max_deps, ede);
     max_mobl = std::fmax(max_mobl, emo);
 
+    for (std::size_t k = 0; k < std::size(kEvaluators); ++k) {
+      double vp, ve;
+      astro::nutation_angles(t, accuracy, kEvaluators[k].evaluator, vp, ve);
+      const double err = std::fmax(std::fabs(vp - gp), std::fabs(ve - ge));
+      max_alt[k] = std::fmax(max_alt[k], err);
+      if (err > kEvaluatorTol || std::fabs(vp - dpsi) > kTol ||
+          std::fabs(ve - deps) > kTol) {
+        std::fprintf(stderr,
+                     "FAIL nutation (%s): acc=%d jd=%.6f\n"
+                     "  got dpsi=%.12f deps=%.12f\n"
+                     "  exact dpsi=%.12f deps=%.12f\n",
+                     kEvaluators[k].name, acc, jd, vp, ve, gp, ge);
+        ++failures;
+      }
+    }
+
     if (edp > kTol || ede > kTol || emo > kTol) {
       std::fprintf(stderr,
                    "FAIL nutation: acc=%d jd=%.6f\n"
@@ -78,5 +111,8 @@ int main(int argc, char** argv) {
                "nutation: %ld rows, %ld failures; max |ddpsi|=%.2e "
                "|ddeps|=%.2e |dmobl|=%.2e (arcsec)\n",
                rows, failures, max_dpsi, max_deps, max_mobl);
+  for (std::size_t k = 0; k < std::size(kEvaluators); ++k)
+    std::fprintf(stderr, "nutation: max |%s - exact|=%.2e (arcsec)\n",
+                 kEvaluators[k].name, max_alt[k]);
   return failures == 0 ? 0 : 1;
 }
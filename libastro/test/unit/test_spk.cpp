@@ -0,0 +1,323 @@
+// Unit tests for the SPK reader. Two parts:
+//   1. A synthetic kernel written here (Type 2 and 3 segments, overlapping
+//      segments, a chain of centers, an unsupported segment) -- always runs.
+//   2. When an ephemeris is available (env LIBASTRO_EPHEMERIS): its EMB,
+//      Moon and Mars series re-packed as Type 2 segments, which SpkFile must
+//      evaluate to the Ephemeris's own states.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "astro/ephemeris.hpp"
+#include "astro/spk.hpp"
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(cond)                                                       \
+  do {                                                                    \
+    if (!(cond)) {                                                        \
+      std::fprintf(stderr, "FAIL %s:%d  %s\n", __FILE__, __LINE__, #cond); \
+      ++g_failures;                                                       \
+    }                                                                     \
+  } while (0)
+
+constexpr double kJ2000 = 2451545.0;
+constexpr double kDay = 86400.0;
+constexpr double kAuKm = 149597870.7;
+
+struct Segment {
+  int target, center, frame, type;
+  double begin, end;  // TDB seconds past J2000
+  std::string name;
+  std::vector<double> data;
+};
+
+// A Type 2 (3: with `ncf` velocity coefficients too) segment of `n` records
+// of `intlen` seconds from `init`, coefficient j of component i of record r
+// being coeff(r, i, j).
+template <class F>
+Segment chebyshev(int target, int center, int type, double init, double intlen,
+                  int n, int ncf, F coeff) {
+  const int comps = type == 2 ? 3 : 6;
+  Segment s{target, center, 1, type, init, init + n * intlen,
+            "TEST " + std::to_string(target), {}};
+  for (int r = 0; r < n; ++r) {
+    s.data.push_back(init + (r + 0.5) * intlen);
+    s.data.push_back(0.5 * intlen);
+    for (int i = 0; i < comps; ++i)
+      for (int j = 0; j < ncf; ++j) s.data.push_back(coeff(r, i, j));
+  }
+  s.data.insert(s.data.end(), {init, intlen, 2.0 + comps * ncf, double(n)});
+  return s;
+}
+
+// A little-endian DAF/SPK file: file record, one summary record, its name
+// record, then the segments' data.
+void write_spk(const std::filesystem::path& path, const std::vector<Segment>& segs) {
+  std::vector<double> words(3 * 128, 0.0);
+  for (const auto& s : segs) words.insert(words.end(), s.data.begin(), s.data.end());
+  words.resize((words.size() + 127) / 128 * 128, 0.0);
+
+  char* file = reinterpret_cast<char*>(words.data());
+  const std::int32_t nd = 2, ni = 6, fward = 2, bward = 2;
+  std::memcpy(file, "DAF/SPK ", 8);
+  std::memcpy(file + 8, &nd, 4);
+  std::memcpy(file + 12, &ni, 4);
+  std::memset(file + 16, ' ', 60);
+  std::memcpy(file + 76, &fward, 4);
+  std::memcpy(file + 80, &bward, 4);
+  std::memcpy(file + 88, "LTL-IEEE", 8);
+
+  double* summary = words.data() + 128;
+  summary[2] = static_cast<double>(segs.size());
+  char* names = file + 2 * 1024;
+  std::memset(names, ' ', 1024);
+  std::int32_t address = 3 * 128 + 1;
+  for (std::size_t i = 0; i < segs.size(); ++i) {
+    const Segment& s = segs[i];
+    double* sum = summary + 3 + 5 * i;
+    sum[0] = s.begin;
+    sum[1] = s.end;
+    const std::int32_t last = address + static_cast<std::int32_t>(s.data.size()) - 1;
+    const std::int32_t ic[6] = {s.target, s.center, s.frame, s.type, address, last};
+    std::memcpy(sum + 2, ic, sizeof ic);
+    std::memcpy(names + 40 * i, s.name.data(), std::min<std::size_t>(s.name.size(), 40));
+    address = last + 1;
+  }
+  const std::int32_t free = address;
+  std::memcpy(file + 84, &free, 4);
+  std::ofstream(path, std::ios::binary)
+      .write(file, static_cast<std::streamsize>(words.size() * sizeof(double)));
+}
+
+// Sum of c[j] T_j(x) and of c[j] T_j'(x), the reference for the kernels.
+void series(const double* c, int ncf, double x, double& p, double& dp) {
+  double t0 = 1.0, t1 = x, d0 = 0.0, d1 = 1.0;
+  p = c[0] + (ncf > 1 ? c[1] * x : 0.0);
+  dp = ncf > 1 ? c[1] : 0.0;
+  for (int j = 2; j < ncf; ++j) {
+    const double t2 = 2.0 * x * t1 - t0;
+    const double d2 = 2.0 * t1 + 2.0 * x * d1 - d0;
+    p += c[j] * t2;
+    dp += c[j] * d2;
+    t0 = t1; t1 = t2; d0 = d1; d1 = d2;
+  }
+}
+
+bool near(double a, double b, double rel) {
+  return std::abs(a - b) <= rel * std::max(1.0, std::abs(b));
+}
+
+astro::TdbInstant at_seconds(double et) {
+  return {astro::JulianDate{kJ2000, et / kDay}};
+}
+
+void test_synthetic() {
+  const double day = kDay;
+  auto wiggle = [](int seed) {
+    return [seed](int r, int i, int j) {
+      return std::sin(seed + 1.3 * r + 0.7 * i + 0.37 * j) * 1e6 / (1 + j * j);
+    };
+  };
+  const int kAsteroid = 2000001, kSun = 10, kEmb = 3, kEarth = 399;
+  std::vector<Segment> segs = {
+      chebyshev(kAsteroid, kSun, 2, 0.0, 16 * day, 8, 9, wiggle(1)),
+      chebyshev(kSun, 0, 3, -32 * day, 64 * day, 4, 6, wiggle(2)),
+      chebyshev(kEmb, 0, 2, 0.0, 32 * day, 4, 11, wiggle(3)),
+      chebyshev(kEarth, kEmb, 2, 0.0, 4 * day, 32, 7, wiggle(4)),
+      // Overrides the asteroid from day 40 to day 72 (later in the file).
+      chebyshev(kAsteroid, kSun, 2, 40 * day, 8 * day, 4, 5, wiggle(5)),
+  };
+  Segment other = segs[0];
+  other.target = 99;
+  other.type = 13;
+  segs.push_back(other);
+  const auto path =
+      std::filesystem::temp_directory_path() / "libastro_test_spk.bsp";
+  write_spk(path, segs);
+
+  auto spk = astro::SpkFile::open(path);
+  CHECK(spk.has_value());
+  if (!spk) return;
+  CHECK(spk->segments().size() == segs.size());
+  CHECK(spk->segments()[0].name == "TEST 2000001");
+  CHECK(spk->segments()[3].target == kEarth && spk->segments()[3].center == kEmb);
+  CHECK(spk->segments()[5].type == 13 && !spk->segments()[5].indexed);
+  CHECK(spk->segments()[4].indexed);
+
+  // A segment's state at `et` from the reference series, km and km/s.
+  auto reference = [&](const Segment& s, double et, double p[3], double v[3]) {
+    const double init = s.data[s.data.size() - 4];
+    const double intlen = s.data[s.data.size() - 3];
+    const auto rsize = static_cast<std::size_t>(s.data[s.data.size() - 2]);
+    const auto n = static_cast<std::size_t>(s.data.back());
+    const int comps = s.type == 2 ? 3 : 6;
+    const int ncf = static_cast<int>(rsize - 2) / comps;
+    auto r = static_cast<std::size_t>(std::floor((et - init) / intlen));
+    r = std::min(r, n - 1);
+    const double* rec = s.data.data() + r * rsize;
+    const double x = (et - rec[0]) / rec[1];
+    for (int i = 0; i < 3; ++i) {
+      double dp;
+      series(rec + 2 + i * ncf, ncf, x, p[i], dp);
+      v[i] = dp / rec[1];
+      if (s.type == 3) series(rec + 2 + (3 + i) * ncf, ncf, x, v[i], dp);
+    }
+  };
+
+  long bad = 0;
+  for (double d = 0.25; d < 128.0; d += 1.7) {
+    const double et = d * day;
+    const Segment& ast = (d >= 40.0 && d < 72.0) ? segs[4] : segs[0];
+    double a[3], av[3], s[3], sv[3], b[3], bv[3], e[3], ev[3];
+    reference(ast, et, a, av);
+    reference(segs[1], et, s, sv);
+    reference(segs[2], et, b, bv);
+    reference(segs[3], et, e, ev);
+
+    auto helio = spk->state(kAsteroid, kSun, at_seconds(et), astro::Units::km);
+    auto geo = spk->state(kAsteroid, kEarth, at_seconds(et), astro::Units::km);
+    auto geo_au = spk->state(kAsteroid, kEarth, at_seconds(et));
+    auto pos = spk->position(kAsteroid, kEarth, at_seconds(et), astro::Units::km);
+    if (!helio || !geo || !geo_au || !pos) { ++bad; continue; }
+    for (std::size_t i = 0; i < 3; ++i) {
+      const double gp = a[i] + s[i] - (e[i] + b[i]);
+      const double gv = av[i] + sv[i] - (ev[i] + bv[i]);
+      if (!near(helio->position[i], a[i], 1e-12) ||
+          !near(helio->velocity[i], av[i], 1e-12) ||
+          !near(geo->position[i], gp, 1e-12) || !near(geo->velocity[i], gv, 1e-12) ||
+          !near(geo_au->position[i], gp / kAuKm, 1e-12) ||
+          !near(geo_au->velocity[i], gv * kDay / kAuKm, 1e-12) ||
+          (*pos)[i] != geo->position[i])
+        ++bad;
+    }
+  }
+  CHECK(bad == 0);
+
+  CHECK(spk->covers(kAsteroid, at_seconds(0.0)));
+  CHECK(spk->covers(kAsteroid, at_seconds(128 * day)));
+  CHECK(!spk->covers(kAsteroid, at_seconds(130 * day)));
+  CHECK(!spk->covers(99, at_seconds(day)));
+  auto self = spk->state(kEarth, kEarth, at_seconds(day));
+  CHECK(self && self->position == astro::Vec3{} && self->velocity == astro::Vec3{});
+  auto late = spk->state(kAsteroid, kEarth, at_seconds(129 * day));
+  CHECK(!late && late.error() == astro::EphError::epoch_out_of_range);
+  auto unknown = spk->state(12345, kSun, at_seconds(day));
+  CHECK(!unknown && unknown.error() == astro::EphError::body_not_available);
+  auto unsupported = spk->state(99, kSun, at_seconds(day));
+  CHECK(!unsupported && unsupported.error() == astro::EphError::body_not_available);
+
+  // Damaged files.
+  auto missing = astro::SpkFile::open(path.string() + ".missing");
+  CHECK(!missing && missing.error() == astro::EphError::file_not_found);
+  std::filesystem::resize_file(path, 1024 + 512);
+  auto cut = astro::SpkFile::open(path);
+  CHECK(!cut && cut.error() == astro::EphError::bad_header);
+  segs[0].data.pop_back();  // directory no longer matches the length
+  write_spk(path, segs);
+  auto bent = astro::SpkFile::open(path);
+  CHECK(!bent && bent.error() == astro::EphError::bad_header);
+  std::filesystem::remove(path);
+}
+
+// The ephemeris's EMB, Moon and Mars groups as Type 2 segments -- one SPK
+// record per DE subinterval, the Moon split by EMRAT into Moon and Earth
+// from the EMB -- against Ephemeris::state().
+void test_from_ephemeris(const char* eph_path) {
+  auto eph = astro::Ephemeris::open(eph_path);
+  CHECK(eph.has_value());
+  if (!eph) return;
+  const astro::Header& h = eph->header();
+  const std::size_t first = 10, count = 20;  // data records re-packed
+
+  std::ifstream in(eph_path, std::ios::binary);
+  std::vector<double> recs(count * h.record_length / sizeof(double));
+  in.seekg(static_cast<std::streamoff>((first + 2) * h.record_length));
+  in.read(reinterpret_cast<char*>(recs.data()),
+          static_cast<std::streamsize>(recs.size() * sizeof(double)));
+  CHECK(in.good());
+
+  const double span = h.days_per_record * kDay;
+  const double init = (h.jd_begin - kJ2000) * kDay + first * span;
+  auto repack = [&](int group, int target, int center, double scale) {
+    const astro::GroupLayout& g = h.groups[static_cast<std::size_t>(group)];
+    const double intlen = span / g.n_subintervals;
+    const int n = static_cast<int>(count) * g.n_subintervals;
+    return chebyshev(target, center, 2, init, intlen, n, g.n_coeff,
+                     [&](int r, int i, int j) {
+                       const std::size_t rec = static_cast<std::size_t>(r / g.n_subintervals);
+                       const int sub = r % g.n_subintervals;
+                       const double* blk = recs.data() + rec * h.record_length / sizeof(double) +
+                                           (g.offset - 1);
+                       return scale * blk[(sub * 3 + i) * g.n_coeff + j];
+                     });
+  };
+  const double emr1 = 1.0 + h.earth_moon_ratio;
+  const std::vector<Segment> segs = {
+      repack(2, 3, 0, 1.0),
+      repack(9, 301, 3, h.earth_moon_ratio / emr1),
+      repack(9, 399, 3, -1.0 / emr1),
+      repack(3, 4, 0, 1.0),
+  };
+  const auto path =
+      std::filesystem::temp_directory_path() / "libastro_test_spk_de.bsp";
+  write_spk(path, segs);
+  auto spk = astro::SpkFile::open(path);
+  CHECK(spk.has_value());
+  if (!spk) return;
+
+  using astro::Point;
+  const std::pair<Point, Point> pairs[] = {
+      {Point::moon, Point::earth},
+      {Point::mars, Point::earth},
+      {Point::earth, Point::solar_system_barycenter},
+      {Point::earth_moon_barycenter, Point::moon}};
+  // Off every subinterval boundary: where two polynomials meet, the two
+  // readers may pick either one.
+  long bad = 0;
+  const double jd = h.jd_begin + first * h.days_per_record;
+  for (std::size_t k = 0; 0.5 * k < count * h.days_per_record; k += 3) {
+    const astro::TdbInstant t{astro::JulianDate{jd, 0.25 + 0.5 * k}};
+    for (auto [tgt, ctr] : pairs) {
+      auto want = eph->state(tgt, ctr, t, astro::Units::km);
+      auto got = spk->state(astro::naif_id(tgt), astro::naif_id(ctr), t,
+                            astro::Units::km);
+      if (!want || !got) { ++bad; continue; }
+      for (std::size_t i = 0; i < 3; ++i)
+        // Rounding of barycentric sums: ~1e-15 of an AU, ~1e-15 of 30 km/s.
+        if (std::abs(got->position[i] - want->position[i]) > 1e-13 * kAuKm ||
+            std::abs(got->velocity[i] - want->velocity[i]) > 1e-12)
+          ++bad;
+    }
+  }
+  CHECK(bad == 0);
+  std::filesystem::remove(path);
+}
+
+}  // namespace
+
+int main() {
+  test_synthetic();
+  if (const char* path = std::getenv("LIBASTRO_EPHEMERIS"))
+    test_from_ephemeris(path);
+  else
+    std::fprintf(stderr, "note: no ephemeris; synthetic SPK checks only\n");
+
+  if (g_failures == 0) {
+    std::fprintf(stderr, "spk: OK\n");
+    return 0;
+  }
+  std::fprintf(stderr, "spk: %d check(s) failed\n", g_failures);
+  return 1;
+}
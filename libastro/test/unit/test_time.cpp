@@ -1,6 +1,8 @@
 // Validate the civil-time utility. Two parts:
 //   1. Self-contained checks (leap seconds, delta_t algebra, JD spot values +
-//      round-trip) -- always run, no NOVAS needed.
+//      round-trip, the Earth-orientation table on synthetic IERS files, the
+//      batch conversions against the scalar ones, ISO 8601 parse/format) --
+//      always run, no NOVAS needed.
 //   2. Calendar <-> Julian-date bit-for-bit vs NOVAS (gen_time) -- when a
 //      reference file is supplied.
 //
@@ -9,9 +11,14 @@
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <filesystem>
 #include <fstream>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
 
+#include "astro/earth_orientation.hpp"
 #include "astro/time.hpp"
 
 namespace {
@@ -41,6 +48,12 @@ void self_checks() {
   CHECK(astro::tai_minus_utc(astro::julian_date(2000, 6, 1)) == 32.0);
   CHECK(astro::tai_minus_utc(astro::julian_date(2010, 6, 1)) == 34.0);
   CHECK(astro::tai_minus_utc(astro::julian_date(2020, 1, 1)) == 37.0);
+  // A value takes effect just after its date (the legacy rule), holds before
+  // 1972 and past the sentinel.
+  CHECK(astro::tai_minus_utc(2457754.5) == 36.0);
+  CHECK(astro::tai_minus_utc(2457754.5 + 1e-6) == 37.0);
+  CHECK(astro::tai_minus_utc(2400000.5) == 10.0);
+  CHECK(astro::tai_minus_utc(6e6) == 37.0);
 
   // delta_t = 32.184 + (TAI-UTC) - (UT1-UTC).
   auto ts = astro::utc_time_scales(2020, 1, 1, 0.0, /*ut1_utc=*/-0.2);
@@ -54,6 +67,339 @@ void self_checks() {
   CHECK(near(ts.ut1.jd.frac, -0.2 / 86400.0, 1e-18));
 }
 
+// One line of the IERS "finals" format: the date, MJD, and the flagged
+// Bulletin A pole and UT1 - UTC columns (errors and the rest left blank).
+std::string finals_line(int mjd, double x, double y, double ut1_utc) {
+  std::string line(185, ' ');
+  char buf[16];
+  const auto c = astro::calendar_date(mjd + 2400000.5);
+  std::snprintf(buf, sizeof buf, "%02d%02d%02d", c.year % 100, c.month, c.day);
+  line.replace(0, 6, buf);
+  std::snprintf(buf, sizeof buf, "%8.2f", static_cast<double>(mjd));
+  line.replace(7, 8, buf);
+  line[16] = 'I';
+  std::snprintf(buf, sizeof buf, "%9.6f", x);
+  line.replace(18, 9, buf);
+  std::snprintf(buf, sizeof buf, "%9.6f", y);
+  line.replace(37, 9, buf);
+  line[57] = 'P';
+  std::snprintf(buf, sizeof buf, "%10.7f", ut1_utc);
+  line.replace(58, 10, buf);
+  return line + "\n";
+}
+
+// Around the 2016-12-31 leap second: UT1 - UTC steps by +1 s at MJD 57754
+// while UT1 - TAI drifts smoothly (-1 ms/day); the pole moves linearly.
+constexpr int kFirstMjd = 57750, kDays = 8;
+double ut1_utc_at(double mjd) {
+  return (mjd < 57754 ? -0.4 : 0.6) - 0.001 * (mjd - kFirstMjd);
+}
+
+std::string synthetic_finals() {
+  std::string text;
+  for (int d = kFirstMjd; d < kFirstMjd + kDays; ++d)
+    text += finals_line(d, 0.01 * (d - kFirstMjd), 0.3, ut1_utc_at(d));
+  text += std::string(80, ' ').replace(7, 8, "57758.00") + "\n";  // past the data
+  return text;
+}
+
+void eop_checks() {
+  using astro::EarthOrientationTable;
+  using astro::EphError;
+  constexpr double kMjd0 = 2400000.5;
+
+  auto eop = EarthOrientationTable::parse(synthetic_finals());
+  CHECK(eop.has_value());
+  if (!eop) return;
+  CHECK(eop->first_mjd() == kFirstMjd && eop->last_mjd() == kFirstMjd + kDays - 1);
+  CHECK(!eop->covers(kFirstMjd - 0.01 + kMjd0));
+  CHECK(eop->covers(kFirstMjd + kDays - 1 + kMjd0));
+  CHECK(!eop->at(kFirstMjd + kDays - 0.99 + kMjd0));
+
+  // Interpolated as UT1 - TAI: linear within each day, the leap second landing
+  // at 0h of the new day rather than smeared over the previous one.
+  for (double mjd : {57750.0, 57751.25, 57753.5, 57753.999, 57754.001, 57754.75,
+                     57757.0}) {
+    const auto eo = eop->at(mjd + kMjd0);
+    CHECK(eo && near(eo->ut1_utc, ut1_utc_at(mjd), 1e-9));
+    CHECK(eo && near(eo->pole.x_arcsec, 0.01 * (mjd - kFirstMjd), 1e-10));
+    CHECK(eo && eo->pole.y_arcsec == 0.3);
+  }
+  CHECK(eop->tai_minus_utc(57753.5 + kMjd0) == 36.0);
+  CHECK(eop->tai_minus_utc(57754.5 + kMjd0) == 37.0);
+  CHECK(eop->tai_minus_utc(2451545.0) == 32.0);  // outside: the built-in table
+
+  // A leap second takes effect strictly after its 0h, as in the built-in
+  // table and the batch path: at exactly 57754.0 TAI - UTC is still 36 and
+  // UT1 - UTC the old day's (UT1 - TAI is continuous), and the time scales
+  // match the table-less call's.
+  const double leap_day = 57754.0 + kMjd0;
+  CHECK(astro::tai_minus_utc(leap_day) == 36.0);
+  CHECK(eop->tai_minus_utc(leap_day) == 36.0);
+  CHECK(eop->tai_minus_utc(leap_day + 1e-6) == 37.0);
+  const auto eo_leap = eop->at(leap_day);
+  CHECK(eo_leap && near(eo_leap->ut1_utc, ut1_utc_at(57754.0) - 1.0, 1e-9));
+  const auto at_leap = astro::utc_time_scales(leap_day, *eop);
+  const auto at_leap_ref =
+      astro::utc_time_scales(leap_day, ut1_utc_at(57754.0) - 1.0);
+  CHECK(at_leap.leap_seconds == 36.0);
+  CHECK(at_leap.tt.jd.frac == at_leap_ref.tt.jd.frac);
+  CHECK(near(at_leap.ut1.jd.frac, at_leap_ref.ut1.jd.frac, 1e-14));
+  auto before = EarthOrientationTable::parse(finals_line(57000, 0, 0, 0));
+  CHECK(before && before->tai_minus_utc(leap_day) == 36.0);  // outside finals
+  {
+    const std::vector<double> days{leap_day - 1e-6, leap_day, leap_day + 1e-6};
+    std::vector<double> plain(days.size()), with_eop(days.size());
+    astro::TimeScaleColumns p, e;
+    p.leap_seconds = plain;
+    e.leap_seconds = with_eop;
+    CHECK(astro::utc_time_scales(days, p).has_value());
+    CHECK(astro::utc_time_scales(days, *eop, e).has_value());
+    CHECK(plain == (std::vector<double>{36.0, 36.0, 37.0}));
+    CHECK(with_eop == plain);
+  }
+
+  // The time-scale overload: the same algebra as passing UT1 - UTC by hand.
+  const double jd = 57755.25 + kMjd0;
+  const auto ts = astro::utc_time_scales(jd, *eop);
+  const auto ref = astro::utc_time_scales(jd, ut1_utc_at(57755.25));
+  CHECK(ts.leap_seconds == 37.0);
+  CHECK(near(ts.delta_t.seconds, ref.delta_t.seconds, 1e-9));
+  CHECK(ts.tt.jd.whole == ref.tt.jd.whole && ts.tt.jd.frac == ref.tt.jd.frac);
+  CHECK(near(ts.ut1.jd.frac, ref.ut1.jd.frac, 1e-14));
+  // ... and an empty table reproduces the default.
+  const auto plain = astro::utc_time_scales(jd, EarthOrientationTable{});
+  CHECK(plain.delta_t.seconds == astro::utc_time_scales(jd).delta_t.seconds);
+
+  // A leap-second list newer than the built-in table, in either format
+  // (abridged: only the entries these dates reach).
+  const std::string iers =
+      "#  File expires on 28 June 2027\n"
+      "    41317.0    1  1 1972       10\n"
+      "    57204.0    1  7 2015       36\n"
+      "    57754.0    1  1 2017       37\n"
+      "    57760.0    7  1 2017       38\n";
+  const std::string ietf =
+      "#$\t 3676924800\n"
+      "2272060800\t10\t# 1 Jan 1972\n"
+      "3644697600\t36\t# 1 Jul 2015\n"
+      "3692217600\t37\t# 1 Jan 2017\n"
+      "3692736000\t38\t# (test)\n";
+  for (const std::string& leaps : {iers, ietf}) {
+    auto t = EarthOrientationTable::parse(synthetic_finals(), leaps);
+    CHECK(t.has_value());
+    if (!t) continue;
+    CHECK(t->tai_minus_utc(57760.5 + kMjd0) == 38.0);
+    CHECK(t->tai_minus_utc(57759.5 + kMjd0) == 37.0);
+    CHECK(t->tai_minus_utc(41000.0 + kMjd0) == 10.0);
+    // The leap midnights follow the same rule as the built-in table, inside
+    // the finals span (57754) and past it (57760).
+    CHECK(t->tai_minus_utc(leap_day) == astro::tai_minus_utc(leap_day));
+    CHECK(t->tai_minus_utc(leap_day + 1e-6) == 37.0);
+    CHECK(t->tai_minus_utc(57760.0 + kMjd0) == 37.0);
+    CHECK(t->tai_minus_utc(57760.0 + 1e-6 + kMjd0) == 38.0);
+    const auto ts_leap = astro::utc_time_scales(leap_day, *t);
+    CHECK(ts_leap.tt.jd.frac == at_leap.tt.jd.frac);
+    CHECK(ts_leap.ut1.jd.frac == at_leap.ut1.jd.frac);
+    // ... and so does a table whose finals miss the leap day.
+    auto early =
+        EarthOrientationTable::parse(finals_line(57000, 0, 0, 0), leaps);
+    CHECK(early && early->tai_minus_utc(leap_day) == 36.0);
+    CHECK(early && early->tai_minus_utc(leap_day + 1e-6) == 37.0);
+    const auto eo = t->at(57753.5 + kMjd0);
+    CHECK(eo && near(eo->ut1_utc, ut1_utc_at(57753.5), 1e-9));
+  }
+
+  // Malformed input.
+  CHECK(EarthOrientationTable::parse("").error() == EphError::bad_header);
+  std::string gap = finals_line(57750, 0, 0, 0) + finals_line(57752, 0, 0, 0);
+  CHECK(EarthOrientationTable::parse(gap).error() == EphError::bad_header);
+  CHECK(EarthOrientationTable::parse(synthetic_finals(), "41317.0 1 1\n").error() ==
+        EphError::bad_header);
+
+  // load(): the same table from files.
+  const auto dir = std::filesystem::temp_directory_path();
+  const auto finals = dir / "astro_test_finals2000A.daily";
+  const auto leaps = dir / "astro_test_leap_seconds.list";
+  std::ofstream(finals) << synthetic_finals();
+  std::ofstream(leaps) << ietf;
+  auto loaded = EarthOrientationTable::load(finals, leaps);
+  CHECK(loaded.has_value());
+  if (loaded) {
+    CHECK(loaded->last_mjd() == eop->last_mjd());
+    CHECK(loaded->at(jd)->ut1_utc == eop->at(jd)->ut1_utc);
+    CHECK(loaded->tai_minus_utc(57760.5 + kMjd0) == 38.0);
+  }
+  CHECK(EarthOrientationTable::load(dir / "astro_no_such_finals").error() ==
+        EphError::file_not_found);
+  std::filesystem::remove(finals);
+  std::filesystem::remove(leaps);
+}
+
+// The span overloads reproduce the scalar calls: bit-for-bit except TDB, whose
+// series goes through the vectorized sine.
+void batch_checks() {
+  // 1969..2031 in uneven steps (a count that is not a multiple of four), then
+  // a few out of order to exercise the leap-second cursor's fallback search.
+  std::vector<double> jd, ut1;
+  for (double d = 2440000.3; d < 2462900.0; d += 37.77) jd.push_back(d);
+  jd.insert(jd.end(), {2457754.5, 2457754.5 + 1e-6, 2441317.0, 2462000.25, 2445000.0, 2451545.0});
+  for (std::size_t i = 0; i < jd.size(); ++i)
+    ut1.push_back(0.9 * std::sin(0.37 * static_cast<double>(i)));
+  const std::size_t n = jd.size();
+  CHECK(n % 4 != 0);
+
+  std::vector<double> leap(n), tt(n), ut(n), tdb(n), dt(n);
+  const astro::TimeScaleColumns cols{leap, tt, ut, tdb, dt};
+  CHECK(astro::utc_time_scales(jd, ut1, cols).has_value());
+  double max_tdb = 0.0;
+  for (std::size_t i = 0; i < n; ++i) {
+    const auto ref = astro::utc_time_scales(jd[i], ut1[i]);
+    CHECK(leap[i] == ref.leap_seconds);
+    CHECK(tt[i] == ref.tt.jd.frac);
+    CHECK(ut[i] == ref.ut1.jd.frac);
+    CHECK(dt[i] == ref.delta_t.seconds);
+    const double jd_tt = jd[i] + tt[i];
+    max_tdb = std::fmax(max_tdb, std::fabs((tdb[i] - tt[i]) * 86400.0 -
+                                           astro::tdb_minus_tt_seconds(jd_tt)));
+  }
+  CHECK(max_tdb < 1e-13);
+
+  // TDB - TT alone, out to +-10 centuries (arguments ~6e3 rad).
+  std::vector<double> jd_tt, sec(0);
+  for (double d = 2086000.5; d < 2817000.0; d += 123.456) jd_tt.push_back(d);
+  sec.resize(jd_tt.size());
+  CHECK(astro::tdb_minus_tt_seconds(jd_tt, sec).has_value());
+  double max_sec = 0.0;
+  for (std::size_t i = 0; i < jd_tt.size(); ++i)
+    max_sec = std::fmax(max_sec,
+                        std::fabs(sec[i] - astro::tdb_minus_tt_seconds(jd_tt[i])));
+  CHECK(max_sec < 1e-14);
+  std::fprintf(stderr, "time (batch): max |dTDB| %.1e s, series %.1e s\n",
+               max_tdb, max_sec);
+
+  // TT -> TDB: the whole part carries over; the fraction gains TDB - TT.
+  std::vector<double> tdb_frac(jd_tt.size());
+  std::vector<double> tt_frac(jd_tt.size(), 0.25);
+  CHECK(astro::tdb_from_tt(jd_tt, tt_frac, tdb_frac).has_value());
+  CHECK(near((tdb_frac[7] - 0.25) * 86400.0,  // 1 ulp of 0.25 d is 5e-12 s
+             astro::tdb_minus_tt_seconds(jd_tt[7] + 0.25), 1e-11));
+  CHECK(astro::tdb_from_tt(jd_tt, {}, tdb_frac).has_value());
+  CHECK(near(tdb_frac[7] * 86400.0, sec[7], 1e-15));
+
+  // The table overload matches its scalar counterpart; empty columns are
+  // skipped; a mis-sized column is refused before anything is written.
+  auto eop = astro::EarthOrientationTable::parse(synthetic_finals());
+  CHECK(eop.has_value());
+  if (eop) {
+    const std::vector<double> days = {57749.9 + 2400000.5, 57751.5 + 2400000.5,
+                                      57754.25 + 2400000.5};
+    std::vector<double> d3(3);
+    astro::TimeScaleColumns only_dt;
+    only_dt.delta_t = d3;
+    CHECK(astro::utc_time_scales(days, *eop, only_dt).has_value());
+    for (std::size_t i = 0; i < days.size(); ++i)
+      CHECK(d3[i] == astro::utc_time_scales(days[i], *eop).delta_t.seconds);
+  }
+  std::vector<double> short_col(n - 1, -1.0);
+  const std::vector<double> tt_before = tt;
+  astro::TimeScaleColumns bad;
+  bad.tt_frac = tt;
+  bad.delta_t = short_col;
+  CHECK(astro::utc_time_scales(jd, bad).error() ==
+        astro::EphError::invalid_argument);
+  CHECK(short_col[0] == -1.0 && tt == tt_before);
+  CHECK(astro::utc_time_scales(jd, short_col, cols).error() ==
+        astro::EphError::invalid_argument);
+  CHECK(astro::tdb_minus_tt_seconds(jd, short_col).error() ==
+        astro::EphError::invalid_argument);
+}
+
+void iso_checks() {
+  using astro::UtcTimestamp;
+  auto parse = [](std::string_view s, UtcTimestamp& t) {
+    const auto r = astro::parse_utc_timestamp(s.data(), s.data() + s.size(), t);
+    return r.ec == std::errc{} ? r.ptr - s.data() : -1;
+  };
+  auto format = [](const UtcTimestamp& t, int digits) {
+    char buf[astro::kUtcTimestampMaxChars];
+    const auto r =
+        astro::format_utc_timestamp(buf, buf + sizeof buf, t, digits);
+    return r.ec == std::errc{} ? std::string(buf, r.ptr) : std::string("?");
+  };
+
+  UtcTimestamp t;
+  CHECK(parse("2026-07-11T17:24:05.123456789Z", t) == 30);
+  CHECK(t.year == 2026 && t.month == 7 && t.day == 11 && t.hour == 17 &&
+        t.minute == 24 && t.second == 5 && t.nanosecond == 123456789);
+  CHECK(format(t, 9) == "2026-07-11T17:24:05.123456789Z");
+  CHECK(format(t, 3) == "2026-07-11T17:24:05.123Z");
+  CHECK(format(t, 0) == "2026-07-11T17:24:05Z");
+
+  // Shorter forms, ',' decimals, ' ' for 'T'; the fraction is exact.
+  CHECK(parse("2026-07-11", t) == 10 && t.hour == 0 && t.nanosecond == 0);
+  CHECK(parse("2026-07-11 04:00", t) == 16 && t.hour == 4 && t.second == 0);
+  CHECK(parse("2026-07-11T04:00:30,25", t) == 22 && t.nanosecond == 250000000);
+  CHECK(parse("2016-12-31T23:59:60Z", t) == 20 && t.second == 60);
+  CHECK(parse("2024-02-29", t) == 10);
+  CHECK(parse("-0044-03-15T12:00:00", t) == 20 && t.year == -44);
+  CHECK(format(t, 0) == "-0044-03-15T12:00:00Z");
+  CHECK(parse("+12000-01-01", t) == 12 && t.year == 12000);
+  CHECK(format(t, 0) == "+12000-01-01T00:00:00Z");
+
+  // Longest match: an incomplete trailing part is left unread.
+  CHECK(parse("2026-07-11T", t) == 10);
+  CHECK(parse("2026-07-11T04:00:", t) == 16);
+  CHECK(parse("2026-07-11T04:00:30.", t) == 19);
+
+  // Out of range, malformed, or finer than a nanosecond: rejected, and `t`
+  // untouched.
+  t = UtcTimestamp{};
+  for (std::string_view bad :
+       {"2026-13-01", "2026-00-10", "2023-02-29", "1900-02-29", "2026-04-31",
+        "2026-07-11T24:00", "2026-07-11T12:60", "2026-07-11T12:00:60",
+        "2026-07-11T23:59:61", "2026-07-11T00:00:00.1234567891", "26-07-11",
+        "20260711", "2026/07/11", ""})
+    CHECK(parse(bad, t) == -1);
+  CHECK(t.year == 2000 && t.month == 1 && t.day == 1);
+
+  // A buffer one short is value_too_large.
+  {
+    char buf[20];
+    auto r = astro::format_utc_timestamp(buf, buf + 19, t);
+    CHECK(r.ec == std::errc::value_too_large && r.ptr == buf + 19);
+    r = astro::format_utc_timestamp(buf, buf + 20, t);
+    CHECK(r.ec == std::errc{} &&
+          std::string_view(buf, 20) == "2000-01-01T00:00:00Z");
+  }
+
+  // Julian dates: J2000.0, a fraction that is exact in binary, and rounding
+  // with carry through the end of a year.
+  CHECK(parse("2000-01-01T12:00:00", t) > 0);
+  CHECK(astro::julian_date(t).value() == 2451545.0);
+  CHECK(parse("2026-07-11T06:00:00", t) > 0);
+  const astro::JulianDate jd = astro::julian_date(t);
+  CHECK(jd.whole == astro::julian_date(2026, 7, 11) && jd.frac == 0.25);
+  CHECK(format(astro::utc_timestamp(jd, 3), 3) == "2026-07-11T06:00:00.000Z");
+  const double new_year = astro::julian_date(2026, 1, 1);
+  auto at = [&](double seconds) {
+    return astro::utc_timestamp(astro::JulianDate{new_year, seconds / 86400.0});
+  };
+  CHECK(format(at(-0.4e-3), 0) == "2026-01-01T00:00:00Z");
+  CHECK(format(at(-0.6), 0) == "2025-12-31T23:59:59Z");
+
+  // Round trip at every digit count: format(utc_timestamp(julian_date(t)))
+  // gives back the text.
+  for (int digits = 0; digits <= 9; ++digits) {
+    std::string text = "1987-04-10T19:21:00";
+    if (digits > 0) text += std::string(".123456789").substr(0, digits + 1);
+    text += 'Z';
+    CHECK(parse(text, t) == static_cast<long>(text.size()));
+    CHECK(format(astro::utc_timestamp(astro::julian_date(t), digits), digits) ==
+          text);
+  }
+}
+
 void novas_checks(const char* csv_path) {
   std::ifstream csv(csv_path);
   if (!csv) {
@@ -93,6 +439,9 @@ void novas_checks(const char* csv_path) {
 
 int main(int argc, char** argv) {
   self_checks();
+  eop_checks();
+  batch_checks();
+  iso_checks();
   const char* csv = (argc > 1) ? argv[1] : std::getenv("LIBASTRO_TIME");
   if (csv)
     novas_checks(csv);
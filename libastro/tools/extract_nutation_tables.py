@@ -8,6 +8,14 @@ extract rather than hand-copy to avoid transcription error; the result
 (src/nutation_tables.inc) is committed as library source because nutation.c is
 a fetched artifact not present at build time.
 
+Each table is emitted twice: verbatim as NOVAS lays it out (one row per term,
+for the exact evaluator) and transposed into structure-of-arrays form (one
+row per column, as double, zero-padded to a multiple of 4 terms and 32-byte
+aligned) for the vectorized evaluator. A padding term has all multipliers and
+coefficients 0, so it adds exactly nothing. The largest |multiplier| in any
+table is emitted as kMaxMultiplier, which sizes the recurrence evaluator's
+multiple-angle tables.
+
 Usage:
   tools/extract_nutation_tables.py <path/to/nutation.c> <out.inc>
 """
@@ -48,6 +56,35 @@ TARGETS = [
 ]
 
 
+LANES = 4  # terms per vector in the vectorized evaluator
+
+
+def rows(init):
+    """The rows of a two-level '{{...}, ...}' initializer, as lists of the
+    number tokens exactly as written."""
+    return [[v.strip() for v in r.split(",")]
+            for r in re.findall(r"\{([^{}]*)\}", init)]
+
+
+def soa(name, table, width=80):
+    """`table` (rows of terms) transposed to '<name>_soa[columns][padded]'."""
+    n = len(table)
+    padded = -(-n // LANES) * LANES
+    cols = len(table[0])
+    out = [f"alignas(32) static const double {name}_soa[{cols}][{padded}] = {{"]
+    for c in range(cols):
+        values = [r[c] for r in table] + ["0"] * (padded - n)
+        line = "    {"
+        for i, v in enumerate(values):
+            piece = v + ("," if i + 1 < len(values) else "}")
+            if len(line) + 1 + len(piece) > width:
+                out.append(line)
+                line = "     "
+            line += ("" if line.endswith("{") else " ") + piece
+        out.append(line + ("," if c + 1 < cols else "};"))
+    return out
+
+
 def main():
     if len(sys.argv) != 3:
         sys.exit("usage: extract_nutation_tables.py <nutation.c> <out.inc>")
@@ -61,6 +98,7 @@ def main():
         "",
     ]
     pos = 0
+    tables = []
     for pattern, name, etype in TARGETS:
         m = re.search(pattern, src[pos:])
         if not m:
@@ -72,6 +110,23 @@ def main():
         n, k = dims.group(1), dims.group(2)
         out.append(f"static const {etype} {name}[{n}][{k}] = {init};")
         out.append("")
+        table = rows(init)
+        if len(table) != int(n) or any(len(r) != int(k) for r in table):
+            sys.exit(f"unexpected shape: {name}")
+        tables.append((name, table))
+
+    largest = max(abs(int(v)) for name, table in tables
+                  if name.startswith("na") for r in table for v in r)
+    out.append("// The largest |multiplier| in the tables above.")
+    out.append(f"constexpr int kMaxMultiplier = {largest};")
+    out.append("")
+
+    out.append("// The same tables in structure-of-arrays form, for the vectorized")
+    out.append("// evaluator: column-major, zero-padded to a multiple of 4 terms.")
+    out.append("")
+    for name, table in tables:
+        out.extend(soa(name, table))
+        out.append("")
 
     open(sys.argv[2], "w").write("\n".join(out))
     print(f"wrote {sys.argv[2]}")